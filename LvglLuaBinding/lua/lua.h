@@ -11,7 +11,7 @@
 
 #include <stdarg.h>
 #include <stddef.h>
-#ifndef LUA_BUILD_AS_DLL
+#if defined(_WIN32) && !defined(LUA_BUILD_AS_DLL)
 #define LUA_BUILD_AS_DLL
 #endif // !LUA_BUILD_AS_DLL
 
@@ -61,7 +61,11 @@
  * OPERATING SYSTEM
  *=================*/
 
-#define LV_USE_OS   LV_OS_WINDOWS
+#ifdef _WIN32
+    #define LV_USE_OS   LV_OS_WINDOWS
+#else
+    #define LV_USE_OS   LV_OS_PTHREAD
+#endif
 
 #if LV_USE_OS == LV_OS_CUSTOM
     #define LV_OS_CUSTOM_INCLUDE <stdint.h>
@@ -325,8 +329,18 @@
 
 #define LV_FS_DEFAULT_DRIVER_LETTER '\0'
 #define LV_USE_FS_STDIO 0
-#define LV_USE_FS_POSIX 0
-#define LV_USE_FS_WIN32 1
+#ifdef _WIN32
+    #define LV_USE_FS_POSIX 0
+    #define LV_USE_FS_WIN32 1
+#else
+    #define LV_USE_FS_POSIX 1
+    #define LV_USE_FS_WIN32 0
+#endif
+#if LV_USE_FS_POSIX
+    #define LV_FS_POSIX_LETTER 'D'
+    #define LV_FS_POSIX_PATH ""
+    #define LV_FS_POSIX_CACHE_SIZE 0
+#endif
 #if LV_USE_FS_WIN32
     #define LV_FS_WIN32_LETTER 'D'
     #define LV_FS_WIN32_PATH ""
@@ -385,7 +399,27 @@
         #define LV_USE_MEM_MONITOR_POS LV_ALIGN_BOTTOM_LEFT
     #endif
 #endif
-#define LV_USE_PROFILER 0
+#define LV_USE_PROFILER 1
+#if LV_USE_PROFILER
+    /*Timeline tracer in lvgl_trace.h, enabled at runtime with lv.trace_start()*/
+    #define LV_USE_PROFILER_BUILTIN 0
+    #define LV_PROFILER_INCLUDE "lvgl_trace.h"
+    #define LV_PROFILER_BEGIN LVGL_TRACE_BEGIN_TAG(__func__)
+    #define LV_PROFILER_END LVGL_TRACE_END_TAG(__func__)
+    #define LV_PROFILER_BEGIN_TAG(tag) LVGL_TRACE_BEGIN_TAG(tag)
+    #define LV_PROFILER_END_TAG(tag) LVGL_TRACE_END_TAG(tag)
+    #define LV_PROFILER_LAYOUT 1
+    #define LV_PROFILER_REFR 1
+    #define LV_PROFILER_DRAW 1
+    #define LV_PROFILER_INDEV 1
+    #define LV_PROFILER_TIMER 1
+    #define LV_PROFILER_DECODER 0
+    #define LV_PROFILER_FONT 0
+    #define LV_PROFILER_FS 0
+    #define LV_PROFILER_CACHE 0
+    #define LV_PROFILER_STYLE 0
+    #define LV_PROFILER_EVENT 0
+#endif
 #define LV_USE_MONKEY 0
 #define LV_USE_GRIDNAV 0
 #define LV_USE_FRAGMENT 0
@@ -418,7 +452,11 @@
 #define LV_USE_GENERIC_MIPI (LV_USE_ST7735 | LV_USE_ST7789 | LV_USE_ST7796 | LV_USE_ILI9341)
 #define LV_USE_RENESAS_GLCDC    0
 #define LV_USE_ST_LTDC    0
-#define LV_USE_WINDOWS    1
+#ifdef _WIN32
+    #define LV_USE_WINDOWS    1
+#else
+    #define LV_USE_WINDOWS    0
+#endif
 #define LV_USE_UEFI 0
 #define LV_USE_OPENGLES   0
 #define LV_USE_QNX              0
@@ -93,12 +93,16 @@ char * lv_strncpy(char * dst, const char * src, size_t dest_size)
 
 char * lv_strcpy(char * dst, const char * src)
 {
-    /* 使用安全的 strcpy_s 替代 strcpy */
     if(dst == NULL || src == NULL) return NULL;
+#if defined(_MSC_VER)
+    /* 使用安全的 strcpy_s 替代 strcpy */
     size_t src_len = strlen(src) + 1;
     errno_t err = strcpy_s(dst, src_len, src);
     if(err != 0) return NULL;
     return dst;
+#else
+    return strcpy(dst, src);
+#endif
 }
 
 int lv_strcmp(const char * s1, const char * s2)
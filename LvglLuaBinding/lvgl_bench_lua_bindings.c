@@ -0,0 +1,56 @@
+﻿/**
+ * @file lvgl_bench_lua_bindings.c
+ * @brief Native loops for the binding micro-benchmarks
+ * 基准测试辅助：在 C 中循环调用 push_lv_obj / check_lv_obj，
+ * 排除 Lua 调用开销，单独测量对象包装和有效性检查的耗时。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+
+// Nanoseconds per iteration
+static lua_Number ns_per_op(uint64_t start_us, lua_Integer iterations) {
+    return (lua_Number)(lvgl_lua_time_us() - start_us) * 1000.0 / (lua_Number)iterations;
+}
+
+// lv.bench_push_obj(obj, iterations) - ns per push_lv_obj (userdata allocation), garbage included
+static int l_lv_bench_push_obj(lua_State* L) {
+    lv_obj_t* obj = check_lv_obj(L, 1);
+    lua_Integer iterations = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, obj != NULL, 1, "invalid object");
+    luaL_argcheck(L, iterations > 0, 2, "iterations must be positive");
+
+    uint64_t start = lvgl_lua_time_us();
+    for (lua_Integer i = 0; i < iterations; i++) {
+        push_lv_obj(L, obj);
+        lua_pop(L, 1);
+    }
+    lua_pushnumber(L, ns_per_op(start, iterations));
+    return 1;
+}
+
+// lv.bench_check_obj(obj, iterations) - ns per check_lv_obj (lv_obj_is_valid walks the object tree)
+static int l_lv_bench_check_obj(lua_State* L) {
+    lua_Integer iterations = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, check_lv_obj(L, 1) != NULL, 1, "invalid object");
+    luaL_argcheck(L, iterations > 0, 2, "iterations must be positive");
+
+    size_t found = 0;
+    uint64_t start = lvgl_lua_time_us();
+    for (lua_Integer i = 0; i < iterations; i++) {
+        if (check_lv_obj(L, 1)) found++;
+    }
+    lua_Number ns = ns_per_op(start, iterations);
+    if (found != (size_t)iterations) return luaL_error(L, "object became invalid");
+    lua_pushnumber(L, ns);
+    return 1;
+}
+
+static const luaL_Reg lv_bench_funcs[] = {
+    {"bench_push_obj", l_lv_bench_push_obj},
+    {"bench_check_obj", l_lv_bench_check_obj},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_bench_funcs(void) {
+    return lv_bench_funcs;
+}
@@ -0,0 +1,327 @@
+﻿/**
+ * @file lvgl_callback_lua_bindings.c
+ * @brief Lua callback invocation - timing statistics and time budget watchdog
+ * 回调统计：按回调函数的源码位置统计耗时分布（count/p50/p99/max），
+ * 并可通过 lua_sethook 中止超出时间或指令预算的回调。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+#include "lvgl_trace.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+// Number of hash buckets for the statistics table
+#define CB_STATS_HASH_SIZE 256
+
+// Instructions executed between two budget checks
+#define CB_BUDGET_CHECK_COUNT 1000
+
+// ========== Time ==========
+
+uint64_t lvgl_lua_time_us(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000u +
+           (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000u / (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+// ========== Histogram ==========
+
+// Bucket index: values below 4 map directly, above that 4 sub-buckets per power of two
+static int hist_index(uint32_t v) {
+    if (v < 4) return (int)v;
+    int e = 31;
+    while (!(v & (1u << e))) e--;
+    int sub = (int)((v >> (e - 2)) & 3u);
+    return 4 + (e - 2) * 4 + sub;
+}
+
+// Upper bound of a bucket
+static uint32_t hist_bucket_max(int idx) {
+    if (idx < 4) return (uint32_t)idx;
+    int e = (idx - 4) / 4 + 2;
+    uint32_t sub = (uint32_t)((idx - 4) % 4);
+    uint64_t lo = ((uint64_t)(4 + sub)) << (e - 2);
+    uint64_t hi = lo + (1ull << (e - 2)) - 1;
+    return hi > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)hi;
+}
+
+void lvgl_hist_add(lvgl_hist_t* hist, uint32_t value) {
+    hist->buckets[hist_index(value)]++;
+    hist->count++;
+    hist->sum += value;
+    if (value > hist->max) hist->max = value;
+}
+
+uint32_t lvgl_hist_percentile(const lvgl_hist_t* hist, double p) {
+    if (hist->count == 0) return 0;
+    uint64_t rank = (uint64_t)(p * (double)hist->count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > hist->count) rank = hist->count;
+    uint64_t seen = 0;
+    for (int i = 0; i < LVGL_HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint32_t v = hist_bucket_max(i);
+            return v < hist->max ? v : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+void lvgl_hist_reset(lvgl_hist_t* hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+// ========== Per-callback statistics ==========
+
+struct lvgl_cb_stats_s {
+    struct lvgl_cb_stats_s* next;
+    char* key;              // "short_src:line"
+    const char* kind;       // "event" / "timer"
+    lvgl_hist_t hist;       // call duration in microseconds
+    uint32_t errors;
+    uint32_t aborts;
+};
+
+static lvgl_cb_stats_t* g_stats[CB_STATS_HASH_SIZE];
+
+// Budget settings (0 = disabled)
+static uint64_t g_budget_us = 0;
+static uint64_t g_budget_instructions = 0;
+
+// State of the outermost running callback
+static struct {
+    lua_State* L;
+    volatile int depth;
+    int budget;
+    uint64_t start_us;
+    uint64_t instructions;
+    int exceeded;
+} g_running;
+
+static unsigned int hash_key(const char* s, const char* kind) {
+    unsigned int h = 5381;
+    while (*s) h = h * 33u + (unsigned char)*s++;
+    while (*kind) h = h * 33u + (unsigned char)*kind++;
+    return h % CB_STATS_HASH_SIZE;
+}
+
+lvgl_cb_stats_t* lvgl_callback_stats_for(lua_State* L, int func_idx, const char* kind) {
+    lua_Debug ar;
+    char key[LUA_IDSIZE + 32];
+
+    lua_pushvalue(L, func_idx);
+    if (!lua_getinfo(L, ">S", &ar)) return NULL;
+    if (ar.linedefined > 0) {
+        snprintf(key, sizeof(key), "%s:%d", ar.short_src, ar.linedefined);
+    } else {
+        snprintf(key, sizeof(key), "%s", ar.short_src);
+    }
+
+    unsigned int h = hash_key(key, kind);
+    for (lvgl_cb_stats_t* s = g_stats[h]; s; s = s->next) {
+        if (strcmp(s->key, key) == 0 && strcmp(s->kind, kind) == 0) return s;
+    }
+
+    lvgl_cb_stats_t* s = (lvgl_cb_stats_t*)calloc(1, sizeof(lvgl_cb_stats_t));
+    if (!s) return NULL;
+    size_t len = strlen(key) + 1;
+    s->key = (char*)malloc(len);
+    if (!s->key) {
+        free(s);
+        return NULL;
+    }
+    memcpy(s->key, key, len);
+    s->kind = kind;
+    s->next = g_stats[h];
+    g_stats[h] = s;
+    return s;
+}
+
+// Abort the running callback once it is over budget
+static void budget_hook(lua_State* L, lua_Debug* ar) {
+    (void)ar;
+    lvgl_profiler_take_sample(L);
+    g_running.instructions += CB_BUDGET_CHECK_COUNT;
+    if ((g_budget_instructions && g_running.instructions > g_budget_instructions) ||
+        (g_budget_us && lvgl_lua_time_us() - g_running.start_us > g_budget_us)) {
+        g_running.exceeded = 1;
+        luaL_error(L, "callback exceeded budget (%d ms, %d instructions)",
+                   (int)((lvgl_lua_time_us() - g_running.start_us) / 1000),
+                   (int)g_running.instructions);
+    }
+}
+
+int lvgl_lua_call_callback(lua_State* L, int nargs, lvgl_cb_stats_t* stats, const void* target, const char* detail) {
+    int outermost = g_running.depth == 0;
+    int budget = outermost && (g_budget_us || g_budget_instructions);
+    lua_Hook old_hook = NULL;
+    int old_mask = 0;
+    int old_count = 0;
+    uint64_t start = lvgl_lua_time_us();
+
+    // Objects created by a preview state's callbacks (lv.scr_act() etc.) belong to its display
+    lv_display_t* preview_disp = lvgl_preview_display_for(L);
+    lv_display_t* old_disp = NULL;
+    if (preview_disp) {
+        old_disp = lv_display_get_default();
+        lv_display_set_default(preview_disp);
+    }
+
+    if (outermost) {
+        g_running.L = L;
+        g_running.budget = budget;
+        g_running.start_us = start;
+        g_running.instructions = 0;
+        g_running.exceeded = 0;
+    }
+    if (budget) {
+        old_hook = lua_gethook(L);
+        old_mask = lua_gethookmask(L);
+        old_count = lua_gethookcount(L);
+        lua_sethook(L, budget_hook, LUA_MASKCOUNT, CB_BUDGET_CHECK_COUNT);
+    }
+
+    const char* trace_name = stats ? stats->key : "lua callback";
+    const char* trace_cat = stats ? stats->kind : "lua";
+    if (lvgl_trace_enabled) lvgl_trace_write(trace_name, trace_cat, 'B', target, detail);
+
+    g_running.depth++;
+    int status = lua_pcall(L, nargs, 0, 0);
+    g_running.depth--;
+
+    if (lvgl_trace_enabled) lvgl_trace_write(trace_name, trace_cat, 'E', NULL, NULL);
+
+    if (preview_disp) lv_display_set_default(old_disp);
+
+    if (budget) {
+        g_running.budget = 0;
+        lua_sethook(L, old_hook, old_mask, old_count);
+    }
+
+    if (stats) {
+        uint64_t elapsed = lvgl_lua_time_us() - start;
+        lvgl_hist_add(&stats->hist, elapsed > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)elapsed);
+        if (status != LUA_OK) {
+            if (outermost && g_running.exceeded) stats->aborts++;
+            else stats->errors++;
+        }
+    }
+    return status;
+}
+
+int lvgl_lua_callback_depth(void) {
+    return g_running.depth;
+}
+
+void lvgl_callback_restore_hook(lua_State* L) {
+    if (g_running.depth > 0 && g_running.budget && g_running.L == L) {
+        lua_sethook(L, budget_hook, LUA_MASKCOUNT, CB_BUDGET_CHECK_COUNT);
+    } else {
+        lua_sethook(L, NULL, 0, 0);
+    }
+}
+
+// ========== Lua API ==========
+
+static void set_ms_field(lua_State* L, const char* name, uint64_t us) {
+    lua_pushnumber(L, (lua_Number)us / 1000.0);
+    lua_setfield(L, -2, name);
+}
+
+static int compare_stats(const void* a, const void* b) {
+    const lvgl_cb_stats_t* sa = *(const lvgl_cb_stats_t* const*)a;
+    const lvgl_cb_stats_t* sb = *(const lvgl_cb_stats_t* const*)b;
+    if (sa->hist.sum != sb->hist.sum) return sa->hist.sum < sb->hist.sum ? 1 : -1;
+    return strcmp(sa->key, sb->key);
+}
+
+// lv.callback_stats() - per-callback timing, sorted by total time
+static int l_lv_callback_stats(lua_State* L) {
+    size_t n = 0;
+    for (int i = 0; i < CB_STATS_HASH_SIZE; i++) {
+        for (lvgl_cb_stats_t* s = g_stats[i]; s; s = s->next) {
+            if (s->hist.count) n++;
+        }
+    }
+
+    lvgl_cb_stats_t** list = n ? (lvgl_cb_stats_t**)malloc(n * sizeof(*list)) : NULL;
+    if (n && !list) return luaL_error(L, "not enough memory");
+    size_t k = 0;
+    for (int i = 0; i < CB_STATS_HASH_SIZE; i++) {
+        for (lvgl_cb_stats_t* s = g_stats[i]; s; s = s->next) {
+            if (s->hist.count) list[k++] = s;
+        }
+    }
+    if (n > 1) qsort(list, n, sizeof(*list), compare_stats);
+
+    lua_createtable(L, (int)n, 0);
+    for (size_t i = 0; i < n; i++) {
+        const lvgl_cb_stats_t* s = list[i];
+        lua_createtable(L, 0, 10);
+        lua_pushstring(L, s->key);
+        lua_setfield(L, -2, "source");
+        lua_pushstring(L, s->kind);
+        lua_setfield(L, -2, "kind");
+        lua_pushinteger(L, (lua_Integer)s->hist.count);
+        lua_setfield(L, -2, "count");
+        set_ms_field(L, "total_ms", s->hist.sum);
+        set_ms_field(L, "avg_ms", s->hist.sum / s->hist.count);
+        set_ms_field(L, "p50_ms", lvgl_hist_percentile(&s->hist, 0.50));
+        set_ms_field(L, "p99_ms", lvgl_hist_percentile(&s->hist, 0.99));
+        set_ms_field(L, "max_ms", s->hist.max);
+        lua_pushinteger(L, s->errors);
+        lua_setfield(L, -2, "errors");
+        lua_pushinteger(L, s->aborts);
+        lua_setfield(L, -2, "aborts");
+        lua_rawseti(L, -2, (lua_Integer)i + 1);
+    }
+    free(list);
+    return 1;
+}
+
+// lv.callback_stats_reset()
+static int l_lv_callback_stats_reset(lua_State* L) {
+    (void)L;
+    for (int i = 0; i < CB_STATS_HASH_SIZE; i++) {
+        for (lvgl_cb_stats_t* s = g_stats[i]; s; s = s->next) {
+            lvgl_hist_reset(&s->hist);
+            s->errors = 0;
+            s->aborts = 0;
+        }
+    }
+    return 0;
+}
+
+// lv.set_callback_budget(ms [, instructions]) - 0 or nil disables a limit
+static int l_lv_set_callback_budget(lua_State* L) {
+    lua_Number ms = luaL_optnumber(L, 1, 0);
+    lua_Integer instructions = luaL_optinteger(L, 2, 0);
+    g_budget_us = ms > 0 ? (uint64_t)(ms * 1000.0) : 0;
+    g_budget_instructions = instructions > 0 ? (uint64_t)instructions : 0;
+    return 0;
+}
+
+static const luaL_Reg lv_callback_funcs[] = {
+    {"callback_stats", l_lv_callback_stats},
+    {"callback_stats_reset", l_lv_callback_stats_reset},
+    {"set_callback_budget", l_lv_set_callback_budget},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_callback_funcs(void) {
+    return lv_callback_funcs;
+}
@@ -0,0 +1,81 @@
+﻿/**
+ * @file lvgl_chunk_lua_bindings.c
+ * @brief Lua chunk precompilation - bytecode dump and content hashing
+ * 预编译：把生成的工程脚本编译为（可去掉调试信息的）字节码，luaL_loadfile 可直接加载，
+ * 省去启动时的语法分析；内容哈希用于判断工程是否需要重新编译。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+
+// FNV-1a 64-bit parameters
+#define CHUNK_HASH_OFFSET 14695981039346656037ull
+#define CHUNK_HASH_PRIME 1099511628211ull
+
+typedef struct {
+    luaL_Buffer b;
+    int init;
+} chunk_writer_t;
+
+// lua_dump writer, the buffer is opened on the first block so the function stays on top
+static int chunk_writer(lua_State* L, const void* p, size_t size, void* ud) {
+    chunk_writer_t* w = (chunk_writer_t*)ud;
+    if (!w->init) {
+        w->init = 1;
+        luaL_buffinit(L, &w->b);
+    }
+    if (p == NULL) {
+        luaL_pushresult(&w->b);
+        lua_replace(L, 1);
+    } else {
+        luaL_addlstring(&w->b, (const char*)p, size);
+    }
+    return 0;
+}
+
+// lv.compile_chunk(source, chunkname [, strip]) - bytecode string, or nil and the syntax error
+static int l_lv_compile_chunk(lua_State* L) {
+    size_t len = 0;
+    const char* source = luaL_checklstring(L, 1, &len);
+    const char* name = luaL_optstring(L, 2, "=chunk");
+    int strip = lua_toboolean(L, 3);
+
+    if (luaL_loadbufferx(L, source, len, name, "t") != LUA_OK) {
+        lua_pushnil(L);
+        lua_insert(L, -2);
+        return 2;
+    }
+    lua_replace(L, 1);
+    lua_settop(L, 1);
+    // Slot 1 receives the result, the function is dumped from the top
+    lua_pushvalue(L, 1);
+    chunk_writer_t w;
+    w.init = 0;
+    lua_dump(L, chunk_writer, &w, strip);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// lv.hash(data) - 64-bit FNV-1a of a string as 16 hex digits
+static int l_lv_hash(lua_State* L) {
+    size_t len = 0;
+    const unsigned char* p = (const unsigned char*)luaL_checklstring(L, 1, &len);
+    uint64_t h = CHUNK_HASH_OFFSET;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= CHUNK_HASH_PRIME;
+    }
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%08x%08x", (unsigned)(h >> 32), (unsigned)(h & 0xFFFFFFFFu));
+    lua_pushstring(L, hex);
+    return 1;
+}
+
+static const luaL_Reg lv_chunk_funcs[] = {
+    {"compile_chunk", l_lv_compile_chunk},
+    {"hash", l_lv_hash},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_chunk_funcs(void) {
+    return lv_chunk_funcs;
+}
@@ -0,0 +1,145 @@
+﻿/**
+ * @file lvgl_clock_lua_bindings.c
+ * @brief Virtual clock - deterministic lv_tick source and os.time/os.date hooks
+ * 虚拟时钟：启用后 lv_tick 与 os.time/os.date 都读取虚拟时间，由宿主按需推进
+ * （尽可能快或固定步长），长时间运行的场景（24 小时趋势等）可在几分钟内回放，
+ * 且每次运行的定时器触发顺序一致。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+#include <time.h>
+
+static struct {
+    volatile int enabled;
+    volatile uint64_t elapsed_ms;   // virtual time since the clock was enabled
+    uint32_t tick_base;             // lv_tick value when the clock was enabled
+    int64_t epoch_ms;               // wall-clock time when the clock was enabled
+} g_clock;
+
+static uint32_t virtual_tick_cb(void) {
+    return g_clock.tick_base + (uint32_t)g_clock.elapsed_ms;
+}
+
+// lv_delay_ms() sleeps in virtual time
+static void virtual_delay_cb(uint32_t ms) {
+    lvgl_clock_advance(ms);
+}
+
+// ========== Public API ==========
+
+void lvgl_clock_set_virtual(int64_t start_epoch_ms) {
+    // Continue from the current tick so running timers keep their phase
+    g_clock.tick_base = lv_tick_get();
+    g_clock.elapsed_ms = 0;
+    g_clock.epoch_ms = start_epoch_ms > 0 ? start_epoch_ms : (int64_t)time(NULL) * 1000;
+    g_clock.enabled = 1;
+    lv_tick_set_cb(virtual_tick_cb);
+    lv_delay_set_cb(virtual_delay_cb);
+}
+
+int lvgl_clock_is_virtual(void) {
+    return g_clock.enabled;
+}
+
+void lvgl_clock_advance(uint32_t ms) {
+    if (g_clock.enabled) g_clock.elapsed_ms += ms;
+}
+
+uint64_t lvgl_clock_elapsed_ms(void) {
+    return g_clock.elapsed_ms;
+}
+
+int64_t lvgl_clock_now_ms(void) {
+    if (g_clock.enabled) return g_clock.epoch_ms + (int64_t)g_clock.elapsed_ms;
+    return (int64_t)time(NULL) * 1000;
+}
+
+// ========== os.time / os.date hooks ==========
+
+// os.time([t]) - without a table returns the virtual time
+static int l_os_time(lua_State* L) {
+    if (!g_clock.enabled || !lua_isnoneornil(L, 1)) {
+        lua_pushvalue(L, lua_upvalueindex(1));
+        lua_insert(L, 1);
+        lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);
+        return lua_gettop(L);
+    }
+    lua_pushinteger(L, (lua_Integer)(lvgl_clock_now_ms() / 1000));
+    return 1;
+}
+
+// os.date([format [, t]]) - t defaults to the virtual time
+static int l_os_date(lua_State* L) {
+    if (g_clock.enabled && lua_isnoneornil(L, 2)) {
+        if (lua_isnoneornil(L, 1)) {
+            lua_settop(L, 0);
+            lua_pushliteral(L, "%c");
+        }
+        lua_settop(L, 1);
+        lua_pushinteger(L, (lua_Integer)(lvgl_clock_now_ms() / 1000));
+    }
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_insert(L, 1);
+    lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);
+    return lua_gettop(L);
+}
+
+static void wrap_os_function(lua_State* L, const char* name, lua_CFunction fn) {
+    lua_getfield(L, -1, name);
+    if (lua_isfunction(L, -1)) {
+        lua_pushcclosure(L, fn, 1);
+        lua_setfield(L, -2, name);
+    } else {
+        lua_pop(L, 1);
+    }
+}
+
+void lvgl_clock_install_os_hooks(lua_State* L) {
+    lua_getglobal(L, "os");
+    if (lua_istable(L, -1)) {
+        wrap_os_function(L, "time", l_os_time);
+        wrap_os_function(L, "date", l_os_date);
+    }
+    lua_pop(L, 1);
+}
+
+// ========== Lua API ==========
+
+// lv.clock_is_virtual()
+static int l_lv_clock_is_virtual(lua_State* L) {
+    lua_pushboolean(L, g_clock.enabled);
+    return 1;
+}
+
+// lv.clock_now() - milliseconds since the Unix epoch (virtual when enabled)
+static int l_lv_clock_now(lua_State* L) {
+    lua_pushinteger(L, (lua_Integer)lvgl_clock_now_ms());
+    return 1;
+}
+
+// lv.clock_advance(ms) - jump the virtual clock forward, timers fire on the next lv_timer_handler()
+static int l_lv_clock_advance(lua_State* L) {
+    lua_Integer ms = luaL_checkinteger(L, 1);
+    if (!g_clock.enabled) return luaL_error(L, "virtual clock is not enabled");
+    luaL_argcheck(L, ms >= 0 && ms <= 0xFFFFFFFF, 1, "out of range");
+    lvgl_clock_advance((uint32_t)ms);
+    return 0;
+}
+
+// lv.time_us() - monotonic real time in microseconds for measurements, ignores the virtual clock
+static int l_lv_time_us(lua_State* L) {
+    lua_pushinteger(L, (lua_Integer)lvgl_lua_time_us());
+    return 1;
+}
+
+static const luaL_Reg lv_clock_funcs[] = {
+    {"time_us", l_lv_time_us},
+    {"clock_is_virtual", l_lv_clock_is_virtual},
+    {"clock_now", l_lv_clock_now},
+    {"clock_advance", l_lv_clock_advance},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_clock_funcs(void) {
+    return lv_clock_funcs;
+}
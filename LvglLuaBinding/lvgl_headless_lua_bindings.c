@@ -0,0 +1,368 @@
+﻿/**
+ * @file lvgl_headless_lua_bindings.c
+ * @brief Headless display - renders into a memory framebuffer, optional PPM/PNG frame dumps
+ * 无窗口显示驱动：LVGL 以 DIRECT 模式直接渲染到内存帧缓冲区，
+ * 可在每帧完成时把画面保存为 PPM/PNG，用于无图形环境的性能测试和批量渲染；
+ * lv.image_compare() 按容差比较两张 PNG，供图像回归测试使用。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+#include "lvgl/src/display/lv_display_private.h"
+#include "lvgl/src/libs/lodepng/lodepng.h"
+
+typedef struct {
+    uint8_t* framebuffer;           // XRGB8888, stride = width * 4
+    int32_t width;
+    int32_t height;
+    uint32_t frame_count;
+    char* dump_dir;                 // NULL = no frame dumps
+    int dump_png;
+} headless_display_t;
+
+static void headless_flush_cb(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map);
+
+static headless_display_t* get_headless(lv_display_t* disp) {
+    if (!disp || disp->flush_cb != headless_flush_cb) return NULL;
+    return (headless_display_t*)lv_display_get_driver_data(disp);
+}
+
+// ========== Frame output ==========
+
+// Convert the framebuffer to packed RGB888
+static uint8_t* framebuffer_to_rgb(const headless_display_t* hd) {
+    size_t pixels = (size_t)hd->width * (size_t)hd->height;
+    uint8_t* rgb = (uint8_t*)malloc(pixels * 3);
+    if (!rgb) return NULL;
+    const uint8_t* src = hd->framebuffer;
+    uint8_t* dst = rgb;
+    for (size_t i = 0; i < pixels; i++) {
+        dst[0] = src[2];
+        dst[1] = src[1];
+        dst[2] = src[0];
+        src += 4;
+        dst += 3;
+    }
+    return rgb;
+}
+
+static int path_has_suffix(const char* path, const char* suffix) {
+    size_t len = strlen(path);
+    size_t slen = strlen(suffix);
+    if (len < slen) return 0;
+    for (size_t i = 0; i < slen; i++) {
+        char c = path[len - slen + i];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (c != suffix[i]) return 0;
+    }
+    return 1;
+}
+
+static int write_frame(const headless_display_t* hd, const char* path, int png) {
+    uint8_t* rgb = framebuffer_to_rgb(hd);
+    if (!rgb) return 0;
+
+    int ok = 0;
+    FILE* f = lvgl_lua_fopen(path, "wb");
+    if (f) {
+        if (png) {
+            unsigned char* data = NULL;
+            size_t size = 0;
+            if (lodepng_encode24(&data, &size, rgb, (unsigned)hd->width, (unsigned)hd->height) == 0) {
+                ok = fwrite(data, 1, size, f) == size;
+            }
+            lv_free(data);
+        } else {
+            size_t size = (size_t)hd->width * (size_t)hd->height * 3;
+            fprintf(f, "P6\n%d %d\n255\n", (int)hd->width, (int)hd->height);
+            ok = fwrite(rgb, 1, size, f) == size;
+        }
+        ok = (fclose(f) == 0) && ok;
+    }
+    free(rgb);
+    return ok;
+}
+
+// ========== Image comparison ==========
+
+// Decode a PNG file to packed RGB888, free the result with free()
+static uint8_t* load_png_rgb(const char* path, unsigned* width, unsigned* height) {
+    FILE* f = lvgl_lua_fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char* data = size > 0 ? (unsigned char*)malloc((size_t)size) : NULL;
+    int ok = data && fread(data, 1, (size_t)size, f) == (size_t)size;
+    fclose(f);
+
+    // LVGL's lodepng decodes into a draw buffer (sized for ARGB8888), the pixels are packed at the start
+    unsigned char* decoded = NULL;
+    uint8_t* rgb = NULL;
+    if (ok && lodepng_decode24(&decoded, width, height, data, (size_t)size) == 0 && decoded) {
+        size_t bytes = (size_t)*width * *height * 3;
+        rgb = (uint8_t*)malloc(bytes);
+        if (rgb) memcpy(rgb, ((lv_draw_buf_t*)decoded)->data, bytes);
+    }
+    if (decoded) lv_draw_buf_destroy((lv_draw_buf_t*)decoded);
+    free(data);
+    return rgb;
+}
+
+// Differing pixels in red over a dimmed grey copy of the reference
+static int write_diff_png(const char* path, const uint8_t* ref, const uint8_t* mask, unsigned w, unsigned h) {
+    size_t pixels = (size_t)w * h;
+    uint8_t* rgb = (uint8_t*)malloc(pixels * 3);
+    if (!rgb) return 0;
+    for (size_t i = 0; i < pixels; i++) {
+        if (mask[i]) {
+            rgb[i * 3] = 255;
+            rgb[i * 3 + 1] = 0;
+            rgb[i * 3 + 2] = 0;
+        } else {
+            uint8_t grey = (uint8_t)((ref[i * 3] * 77 + ref[i * 3 + 1] * 150 + ref[i * 3 + 2] * 29) >> 8) / 2 + 64;
+            rgb[i * 3] = rgb[i * 3 + 1] = rgb[i * 3 + 2] = grey;
+        }
+    }
+    int ok = 0;
+    unsigned char* png = NULL;
+    size_t size = 0;
+    if (lodepng_encode24(&png, &size, rgb, w, h) == 0) {
+        FILE* f = lvgl_lua_fopen(path, "wb");
+        if (f) {
+            ok = fwrite(png, 1, size, f) == size;
+            ok = (fclose(f) == 0) && ok;
+        }
+    }
+    lv_free(png);
+    free(rgb);
+    return ok;
+}
+
+static void headless_flush_cb(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map) {
+    (void)area;
+    (void)px_map;
+    headless_display_t* hd = (headless_display_t*)lv_display_get_driver_data(disp);
+    // Rendering goes straight into the framebuffer, a frame is complete after its last area
+    if (lv_display_flush_is_last(disp)) {
+        hd->frame_count++;
+        if (hd->dump_dir) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/frame_%06u.%s", hd->dump_dir,
+                     (unsigned)hd->frame_count, hd->dump_png ? "png" : "ppm");
+            if (!write_frame(hd, path, hd->dump_png)) {
+                printf("Headless display: cannot write %s\n", path);
+            }
+        }
+    }
+    lv_display_flush_ready(disp);
+}
+
+static void headless_delete_cb(lv_event_t* e) {
+    lv_display_t* disp = (lv_display_t*)lv_event_get_target(e);
+    headless_display_t* hd = (headless_display_t*)lv_display_get_driver_data(disp);
+    if (!hd) return;
+    lv_display_set_driver_data(disp, NULL);
+    free(hd->framebuffer);
+    free(hd->dump_dir);
+    free(hd);
+}
+
+// Tick source for hosts without a platform driver
+static uint32_t headless_tick_cb(void) {
+    return (uint32_t)(lvgl_lua_time_us() / 1000);
+}
+
+// ========== Public API ==========
+
+lv_display_t* lvgl_headless_create_display(int32_t width, int32_t height) {
+    if (width <= 0 || height <= 0) return NULL;
+
+    headless_display_t* hd = (headless_display_t*)calloc(1, sizeof(headless_display_t));
+    if (!hd) return NULL;
+    uint32_t size = (uint32_t)width * (uint32_t)height * 4;
+    hd->framebuffer = (uint8_t*)calloc(1, size);
+    hd->width = width;
+    hd->height = height;
+
+    lv_display_t* disp = hd->framebuffer ? lv_display_create(width, height) : NULL;
+    if (!disp) {
+        free(hd->framebuffer);
+        free(hd);
+        return NULL;
+    }
+    lv_display_set_color_format(disp, LV_COLOR_FORMAT_XRGB8888);
+    lv_display_set_driver_data(disp, hd);
+    lv_display_set_flush_cb(disp, headless_flush_cb);
+    lv_display_set_buffers(disp, hd->framebuffer, NULL, size, LV_DISPLAY_RENDER_MODE_DIRECT);
+    lv_display_add_event_cb(disp, headless_delete_cb, LV_EVENT_DELETE, NULL);
+
+    // The virtual clock, when enabled, keeps driving the tick
+    if (!lvgl_clock_is_virtual()) {
+        lv_tick_set_cb(headless_tick_cb);
+        lv_delay_set_cb(lv_sleep_ms);
+    }
+    return disp;
+}
+
+int lvgl_headless_set_frame_dump(lv_display_t* disp, const char* dir, const char* format) {
+    headless_display_t* hd = get_headless(disp);
+    if (!hd) return 0;
+    free(hd->dump_dir);
+    hd->dump_dir = NULL;
+    if (!dir || !dir[0]) return 1;
+
+    size_t len = strlen(dir) + 1;
+    hd->dump_dir = (char*)malloc(len);
+    if (!hd->dump_dir) return 0;
+    memcpy(hd->dump_dir, dir, len);
+    hd->dump_png = format && path_has_suffix(format, "png");
+    return 1;
+}
+
+int lvgl_headless_save_frame(lv_display_t* disp, const char* path) {
+    headless_display_t* hd = get_headless(disp);
+    if (!hd || !path) return 0;
+    return write_frame(hd, path, path_has_suffix(path, ".png"));
+}
+
+const uint8_t* lvgl_headless_get_framebuffer(lv_display_t* disp, uint32_t* frame_count) {
+    headless_display_t* hd = get_headless(disp);
+    if (!hd) return NULL;
+    if (frame_count) *frame_count = hd->frame_count;
+    return hd->framebuffer;
+}
+
+// ========== Lua API ==========
+
+// lv.display_save(path) - save the headless display's last frame as .png or .ppm
+static int l_lv_display_save(lua_State* L) {
+    const char* path = luaL_checkstring(L, 1);
+    lv_display_t* disp = lv_display_get_default();
+    if (!get_headless(disp)) {
+        lua_pushnil(L);
+        lua_pushstring(L, "display is not headless");
+        return 2;
+    }
+    if (!lvgl_headless_save_frame(disp, path)) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "cannot write %s", path);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// lv.display_is_headless()
+static int l_lv_display_is_headless(lua_State* L) {
+    lua_pushboolean(L, get_headless(lv_display_get_default()) != NULL);
+    return 1;
+}
+
+// lv.refr_now() - lay out, render and flush the default display immediately
+static int l_lv_refr_now(lua_State* L) {
+    (void)L;
+    lv_refr_now(NULL);
+    return 0;
+}
+
+// lv.timer_handler() - run due LVGL timers once, returns milliseconds until the next one
+static int l_lv_timer_handler(lua_State* L) {
+    uint32_t next = lv_timer_handler();
+    lua_pushinteger(L, next == LV_NO_TIMER_READY ? -1 : (lua_Integer)next);
+    return 1;
+}
+
+// lv.image_compare(actual, reference [, tolerance [, diff_path]]) - compare two PNG files
+// A pixel differs when any channel differs by more than tolerance (default 0).
+// Returns { width, height, diff_pixels, diff_pct, max_delta } or nil, error.
+static int l_lv_image_compare(lua_State* L) {
+    const char* actual_path = luaL_checkstring(L, 1);
+    const char* ref_path = luaL_checkstring(L, 2);
+    int tolerance = (int)luaL_optinteger(L, 3, 0);
+    const char* diff_path = luaL_optstring(L, 4, NULL);
+
+    unsigned aw = 0, ah = 0, rw = 0, rh = 0;
+    uint8_t* actual = load_png_rgb(actual_path, &aw, &ah);
+    if (!actual) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "cannot read %s", actual_path);
+        return 2;
+    }
+    uint8_t* ref = load_png_rgb(ref_path, &rw, &rh);
+    if (!ref) {
+        free(actual);
+        lua_pushnil(L);
+        lua_pushfstring(L, "cannot read %s", ref_path);
+        return 2;
+    }
+    if (aw != rw || ah != rh) {
+        free(actual);
+        free(ref);
+        lua_pushnil(L);
+        lua_pushfstring(L, "size differs: %dx%d vs %dx%d", (int)aw, (int)ah, (int)rw, (int)rh);
+        return 2;
+    }
+
+    size_t pixels = (size_t)aw * ah;
+    uint8_t* mask = diff_path ? (uint8_t*)calloc(pixels, 1) : NULL;
+    size_t diff_pixels = 0;
+    int max_delta = 0;
+    for (size_t i = 0; i < pixels; i++) {
+        int delta = 0;
+        for (int c = 0; c < 3; c++) {
+            int d = abs((int)actual[i * 3 + c] - (int)ref[i * 3 + c]);
+            if (d > delta) delta = d;
+        }
+        if (delta > max_delta) max_delta = delta;
+        if (delta > tolerance) {
+            diff_pixels++;
+            if (mask) mask[i] = 1;
+        }
+    }
+    if (mask && diff_pixels) write_diff_png(diff_path, ref, mask, aw, ah);
+    free(mask);
+    free(actual);
+    free(ref);
+
+    lua_createtable(L, 0, 5);
+    lua_pushinteger(L, (lua_Integer)aw);
+    lua_setfield(L, -2, "width");
+    lua_pushinteger(L, (lua_Integer)ah);
+    lua_setfield(L, -2, "height");
+    lua_pushinteger(L, (lua_Integer)diff_pixels);
+    lua_setfield(L, -2, "diff_pixels");
+    lua_pushnumber(L, pixels ? (lua_Number)diff_pixels * 100.0 / (lua_Number)pixels : 0);
+    lua_setfield(L, -2, "diff_pct");
+    lua_pushinteger(L, max_delta);
+    lua_setfield(L, -2, "max_delta");
+    return 1;
+}
+
+// lv.sysmon_set_visible(visible) - show or hide the performance and memory monitor overlays
+static int l_lv_sysmon_set_visible(lua_State* L) {
+    int visible = lua_toboolean(L, 1);
+#if LV_USE_PERF_MONITOR
+    if (visible) lv_sysmon_show_performance(NULL);
+    else lv_sysmon_hide_performance(NULL);
+#endif
+#if LV_USE_MEM_MONITOR
+    if (visible) lv_sysmon_show_memory(NULL);
+    else lv_sysmon_hide_memory(NULL);
+#endif
+    (void)visible;
+    return 0;
+}
+
+static const luaL_Reg lv_headless_funcs[] = {
+    {"display_save", l_lv_display_save},
+    {"display_is_headless", l_lv_display_is_headless},
+    {"refr_now", l_lv_refr_now},
+    {"timer_handler", l_lv_timer_handler},
+    {"sysmon_set_visible", l_lv_sysmon_set_visible},
+    {"image_compare", l_lv_image_compare},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_headless_funcs(void) {
+    return lv_headless_funcs;
+}
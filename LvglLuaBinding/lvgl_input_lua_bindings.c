@@ -0,0 +1,509 @@
+﻿/**
+ * @file lvgl_input_lua_bindings.c
+ * @brief Input record/replay - indev traces for reproducible UI benchmarks
+ * 输入录制：包装现有输入设备的 read_cb，把指针/键盘/编码器状态变化连同时间戳
+ * 写入紧凑的二进制文件；回放时由虚拟输入设备按时间戳送回，并统计每个输入
+ * 事件到下一次完成刷屏的延迟分布（p50/p95/p99）。
+ *
+ * 文件格式：头部 "VDUI" + 版本字节 + 3 字节保留，之后每条记录为
+ *   varint 距上一条记录的毫秒数, u8 (indev 类型 << 1 | 按下状态), 负载
+ * 负载：指针为 zigzag varint x/y，键盘为 varint 键值，编码器为 zigzag varint 增量。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+#include "lvgl/src/indev/lv_indev_private.h"
+
+#define INPUT_MAGIC "VDUI"
+#define INPUT_VERSION 1
+#define INPUT_HEADER_SIZE 8
+
+// Input devices wrapped while recording / created for replay
+#define INPUT_MAX_DEVICES 8
+
+// Delivered events waiting for the next refresh
+#define INPUT_MAX_PENDING 1024
+
+typedef struct {
+    uint32_t time_ms;               // since the start of the recording
+    uint8_t type;                   // lv_indev_type_t
+    uint8_t state;                  // lv_indev_state_t
+    int32_t x;
+    int32_t y;
+    uint32_t key;
+    int32_t enc_diff;
+} input_event_t;
+
+// ========== Recording ==========
+
+typedef struct {
+    lv_indev_t* indev;
+    lv_indev_read_cb_t read_cb;     // original callback
+    input_event_t last;
+    int has_last;
+} record_device_t;
+
+static struct {
+    FILE* file;
+    uint32_t start_tick;
+    uint32_t last_ms;
+    uint32_t count;
+    record_device_t devices[INPUT_MAX_DEVICES];
+    int device_count;
+} g_rec;
+
+static void write_varint(FILE* f, uint32_t v) {
+    uint8_t buf[5];
+    int n = 0;
+    do {
+        uint8_t b = (uint8_t)(v & 0x7F);
+        v >>= 7;
+        buf[n++] = v ? (uint8_t)(b | 0x80) : b;
+    } while (v);
+    fwrite(buf, 1, (size_t)n, f);
+}
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static void record_write(const input_event_t* ev) {
+    FILE* f = g_rec.file;
+    write_varint(f, ev->time_ms - g_rec.last_ms);
+    g_rec.last_ms = ev->time_ms;
+    fputc((ev->type << 1) | (ev->state ? 1 : 0), f);
+    switch (ev->type) {
+        case LV_INDEV_TYPE_POINTER:
+            write_varint(f, zigzag(ev->x));
+            write_varint(f, zigzag(ev->y));
+            break;
+        case LV_INDEV_TYPE_KEYPAD:
+            write_varint(f, ev->key);
+            break;
+        case LV_INDEV_TYPE_ENCODER:
+            write_varint(f, zigzag(ev->enc_diff));
+            break;
+        default:
+            break;
+    }
+    g_rec.count++;
+}
+
+// Only state changes are stored, the replay holds the last state in between
+static int record_changed(const record_device_t* dev, const input_event_t* ev) {
+    if (!dev->has_last) return 1;
+    if (ev->state != dev->last.state) return 1;
+    switch (ev->type) {
+        case LV_INDEV_TYPE_POINTER:
+            return ev->x != dev->last.x || ev->y != dev->last.y;
+        case LV_INDEV_TYPE_KEYPAD:
+            return ev->key != dev->last.key;
+        case LV_INDEV_TYPE_ENCODER:
+            return ev->enc_diff != 0;
+        default:
+            return 0;
+    }
+}
+
+static void record_read_cb(lv_indev_t* indev, lv_indev_data_t* data) {
+    record_device_t* dev = NULL;
+    for (int i = 0; i < g_rec.device_count; i++) {
+        if (g_rec.devices[i].indev == indev) dev = &g_rec.devices[i];
+    }
+    if (!dev) return;
+    dev->read_cb(indev, data);
+    if (!g_rec.file) return;
+
+    input_event_t ev = {0};
+    ev.time_ms = lv_tick_elaps(g_rec.start_tick);
+    ev.type = (uint8_t)lv_indev_get_type(indev);
+    ev.state = (uint8_t)data->state;
+    ev.x = data->point.x;
+    ev.y = data->point.y;
+    ev.key = data->key;
+    ev.enc_diff = data->enc_diff;
+    if (record_changed(dev, &ev)) {
+        record_write(&ev);
+        dev->last = ev;
+        dev->has_last = 1;
+    }
+}
+
+// ========== Replay ==========
+
+typedef struct {
+    lv_indev_t* indev;
+    uint8_t type;
+    uint32_t cursor;                // next event of this type
+    input_event_t current;
+} replay_device_t;
+
+static struct {
+    input_event_t* events;
+    uint32_t event_count;
+    uint32_t delivered;
+    uint32_t start_tick;
+    int active;
+    int release_pending;            // replay_async_release() is queued
+    replay_device_t devices[INPUT_MAX_DEVICES];
+    int device_count;
+    lv_indev_t* disabled[INPUT_MAX_DEVICES];    // real devices muted during the replay
+    int disabled_count;
+    // Latency measurement
+    lv_display_t* disp;
+    int rendered;
+    uint64_t pending[INPUT_MAX_PENDING];
+    uint32_t pending_count;
+    lvgl_hist_t latency;            // delivery -> end of the next rendered refresh, microseconds
+    uint32_t no_redraw;             // events followed by a refresh that drew nothing
+    uint32_t overflow;
+} g_replay;
+
+static int read_varint(const uint8_t** p, const uint8_t* end, uint32_t* out) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35 && *p < end; shift += 7) {
+        uint8_t b = *(*p)++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *out = v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Parse a recording, returns the number of events or -1 on a malformed file
+static int32_t parse_events(const uint8_t* data, size_t size, input_event_t* out) {
+    const uint8_t* p = data + INPUT_HEADER_SIZE;
+    const uint8_t* end = data + size;
+    uint32_t time_ms = 0;
+    int32_t n = 0;
+    while (p < end) {
+        uint32_t dt, a = 0, b = 0;
+        if (!read_varint(&p, end, &dt) || p >= end) return -1;
+        uint8_t head = *p++;
+        input_event_t ev = {0};
+        time_ms += dt;
+        ev.time_ms = time_ms;
+        ev.type = (uint8_t)(head >> 1);
+        ev.state = (uint8_t)(head & 1);
+        switch (ev.type) {
+            case LV_INDEV_TYPE_POINTER:
+                if (!read_varint(&p, end, &a) || !read_varint(&p, end, &b)) return -1;
+                ev.x = unzigzag(a);
+                ev.y = unzigzag(b);
+                break;
+            case LV_INDEV_TYPE_KEYPAD:
+                if (!read_varint(&p, end, &ev.key)) return -1;
+                break;
+            case LV_INDEV_TYPE_ENCODER:
+                if (!read_varint(&p, end, &a)) return -1;
+                ev.enc_diff = unzigzag(a);
+                break;
+            default:
+                return -1;
+        }
+        if (out) out[n] = ev;
+        n++;
+    }
+    return n;
+}
+
+static void replay_advance(replay_device_t* dev) {
+    while (dev->cursor < g_replay.event_count && g_replay.events[dev->cursor].type != dev->type) {
+        dev->cursor++;
+    }
+}
+
+// One event per read so LVGL processes every recorded state change
+static void replay_read_cb(lv_indev_t* indev, lv_indev_data_t* data) {
+    replay_device_t* dev = (replay_device_t*)lv_indev_get_driver_data(indev);
+    uint32_t now = lv_tick_elaps(g_replay.start_tick);
+
+    dev->current.enc_diff = 0;
+    if (dev->cursor < g_replay.event_count && g_replay.events[dev->cursor].time_ms <= now) {
+        dev->current = g_replay.events[dev->cursor];
+        dev->cursor++;
+        replay_advance(dev);
+        g_replay.delivered++;
+        if (g_replay.pending_count < INPUT_MAX_PENDING) {
+            g_replay.pending[g_replay.pending_count++] = lvgl_lua_time_us();
+        } else {
+            g_replay.overflow++;
+        }
+        data->continue_reading = dev->cursor < g_replay.event_count &&
+                                 g_replay.events[dev->cursor].time_ms <= now;
+    }
+
+    data->state = (lv_indev_state_t)dev->current.state;
+    data->point.x = dev->current.x;
+    data->point.y = dev->current.y;
+    data->key = dev->current.key;
+    data->enc_diff = (int16_t)dev->current.enc_diff;
+}
+
+static void replay_async_release(void* user_data);
+
+static void replay_disp_event_cb(lv_event_t* e) {
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_REFR_START:
+            g_replay.rendered = 0;
+            break;
+        case LV_EVENT_RENDER_START:
+            g_replay.rendered = 1;
+            break;
+        case LV_EVENT_REFR_READY: {
+            // Events delivered before this refresh either caused it or drew nothing
+            uint64_t now = lvgl_lua_time_us();
+            for (uint32_t i = 0; i < g_replay.pending_count; i++) {
+                if (g_replay.rendered) {
+                    uint64_t us = now - g_replay.pending[i];
+                    lvgl_hist_add(&g_replay.latency, us > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)us);
+                } else {
+                    g_replay.no_redraw++;
+                }
+            }
+            g_replay.pending_count = 0;
+            // Give the real devices back once the last event has been rendered
+            if (g_replay.active && !g_replay.release_pending && lvgl_input_replay_is_done()) {
+                g_replay.release_pending = 1;
+                lv_async_call(replay_async_release, NULL);
+            }
+            break;
+        }
+        case LV_EVENT_DELETE:
+            g_replay.disp = NULL;
+            break;
+        default:
+            break;
+    }
+}
+
+// Delete the virtual devices and re-enable the real ones, the statistics are kept
+static void replay_release(void) {
+    if (g_replay.release_pending) {
+        lv_async_call_cancel(replay_async_release, NULL);
+        g_replay.release_pending = 0;
+    }
+    for (int i = 0; i < g_replay.device_count; i++) {
+        lv_indev_delete(g_replay.devices[i].indev);
+    }
+    g_replay.device_count = 0;
+    for (int i = 0; i < g_replay.disabled_count; i++) {
+        lv_indev_enable(g_replay.disabled[i], true);
+    }
+    g_replay.disabled_count = 0;
+    if (g_replay.disp) {
+        lv_display_remove_event_cb_with_user_data(g_replay.disp, replay_disp_event_cb, NULL);
+        g_replay.disp = NULL;
+    }
+    free(g_replay.events);
+    g_replay.events = NULL;
+    g_replay.active = 0;
+}
+
+static void replay_async_release(void* user_data) {
+    (void)user_data;
+    g_replay.release_pending = 0;
+    replay_release();
+}
+
+// ========== Public API ==========
+
+int lvgl_input_record_start(const char* path) {
+    if (g_rec.file) return 0;
+    FILE* f = lvgl_lua_fopen(path, "wb");
+    if (!f) return 0;
+    static const uint8_t header[INPUT_HEADER_SIZE] = { 'V', 'D', 'U', 'I', INPUT_VERSION, 0, 0, 0 };
+    fwrite(header, 1, sizeof(header), f);
+
+    g_rec.file = f;
+    g_rec.start_tick = lv_tick_get();
+    g_rec.last_ms = 0;
+    g_rec.count = 0;
+    g_rec.device_count = 0;
+    for (lv_indev_t* indev = lv_indev_get_next(NULL); indev && g_rec.device_count < INPUT_MAX_DEVICES;
+         indev = lv_indev_get_next(indev)) {
+        lv_indev_read_cb_t read_cb = lv_indev_get_read_cb(indev);
+        if (!read_cb || read_cb == record_read_cb) continue;
+        record_device_t* dev = &g_rec.devices[g_rec.device_count++];
+        memset(dev, 0, sizeof(*dev));
+        dev->indev = indev;
+        dev->read_cb = read_cb;
+        lv_indev_set_read_cb(indev, record_read_cb);
+    }
+    return 1;
+}
+
+uint32_t lvgl_input_record_stop(void) {
+    if (!g_rec.file) return 0;
+    for (int i = 0; i < g_rec.device_count; i++) {
+        lv_indev_set_read_cb(g_rec.devices[i].indev, g_rec.devices[i].read_cb);
+    }
+    g_rec.device_count = 0;
+    fclose(g_rec.file);
+    g_rec.file = NULL;
+    return g_rec.count;
+}
+
+int lvgl_input_replay_start(const char* path) {
+    if (g_replay.active) replay_release();
+
+    FILE* f = lvgl_lua_fopen(path, "rb");
+    if (!f) return 0;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* data = size >= INPUT_HEADER_SIZE ? (uint8_t*)malloc((size_t)size) : NULL;
+    int ok = data && fread(data, 1, (size_t)size, f) == (size_t)size &&
+             memcmp(data, INPUT_MAGIC, 4) == 0 && data[4] == INPUT_VERSION;
+    fclose(f);
+
+    int32_t count = ok ? parse_events(data, (size_t)size, NULL) : -1;
+    input_event_t* events = count > 0 ? (input_event_t*)malloc((size_t)count * sizeof(input_event_t)) : NULL;
+    if (count < 0 || (count > 0 && !events)) {
+        free(data);
+        free(events);
+        return 0;
+    }
+    if (count > 0) parse_events(data, (size_t)size, events);
+    free(data);
+
+    memset(&g_replay, 0, sizeof(g_replay));
+    g_replay.events = events;
+    g_replay.event_count = (uint32_t)count;
+    g_replay.active = 1;
+    g_replay.start_tick = lv_tick_get();
+
+    // Mute the real devices so the trace is the only input
+    for (lv_indev_t* indev = lv_indev_get_next(NULL); indev; indev = lv_indev_get_next(indev)) {
+        if (indev->enabled && g_replay.disabled_count < INPUT_MAX_DEVICES) {
+            lv_indev_enable(indev, false);
+            g_replay.disabled[g_replay.disabled_count++] = indev;
+        }
+    }
+
+    // One virtual device per input type present in the trace
+    static const uint8_t types[] = { LV_INDEV_TYPE_POINTER, LV_INDEV_TYPE_KEYPAD, LV_INDEV_TYPE_ENCODER };
+    for (size_t t = 0; t < sizeof(types); t++) {
+        replay_device_t* dev = &g_replay.devices[g_replay.device_count];
+        dev->type = types[t];
+        dev->cursor = 0;
+        replay_advance(dev);
+        if (dev->cursor >= g_replay.event_count) continue;
+
+        dev->indev = lv_indev_create();
+        lv_indev_set_type(dev->indev, (lv_indev_type_t)dev->type);
+        lv_indev_set_driver_data(dev->indev, dev);
+        lv_indev_set_read_cb(dev->indev, replay_read_cb);
+        if (dev->type != LV_INDEV_TYPE_POINTER && lv_group_get_default()) {
+            lv_indev_set_group(dev->indev, lv_group_get_default());
+        }
+        g_replay.device_count++;
+    }
+
+    g_replay.disp = lv_display_get_default();
+    if (g_replay.disp) {
+        lv_display_add_event_cb(g_replay.disp, replay_disp_event_cb, LV_EVENT_ALL, NULL);
+    }
+    return 1;
+}
+
+int lvgl_input_replay_is_done(void) {
+    return !g_replay.active || (g_replay.delivered >= g_replay.event_count && g_replay.pending_count == 0);
+}
+
+void lvgl_input_replay_print_stats(void) {
+    const lvgl_hist_t* h = &g_replay.latency;
+    printf("Input replay: %u/%u events, %u redrawn, %u without redraw\n",
+           (unsigned)g_replay.delivered, (unsigned)g_replay.event_count, (unsigned)h->count,
+           (unsigned)g_replay.no_redraw);
+    if (h->count) {
+        printf("Input-to-flush latency: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+               lvgl_hist_percentile(h, 0.50) / 1000.0, lvgl_hist_percentile(h, 0.95) / 1000.0,
+               lvgl_hist_percentile(h, 0.99) / 1000.0, h->max / 1000.0);
+    }
+}
+
+// ========== Lua API ==========
+
+static void set_ms_field(lua_State* L, const char* name, uint64_t us) {
+    lua_pushnumber(L, (lua_Number)us / 1000.0);
+    lua_setfield(L, -2, name);
+}
+
+// lv.input_record_start(path) - record all input devices into path
+static int l_lv_input_record_start(lua_State* L) {
+    const char* path = luaL_checkstring(L, 1);
+    if (g_rec.file) return luaL_error(L, "input recording is already running");
+    if (!lvgl_input_record_start(path)) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "cannot open %s", path);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// lv.input_record_stop() - returns the number of recorded events
+static int l_lv_input_record_stop(lua_State* L) {
+    lua_pushinteger(L, (lua_Integer)lvgl_input_record_stop());
+    return 1;
+}
+
+// lv.input_replay(path) - feed a recording back through virtual input devices
+static int l_lv_input_replay(lua_State* L) {
+    const char* path = luaL_checkstring(L, 1);
+    if (!lvgl_input_replay_start(path)) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "cannot load input recording %s", path);
+        return 2;
+    }
+    lua_pushinteger(L, (lua_Integer)g_replay.event_count);
+    return 1;
+}
+
+// lv.input_replay_stop() - end the replay early, returns the number of delivered events
+static int l_lv_input_replay_stop(lua_State* L) {
+    if (g_replay.active) replay_release();
+    lua_pushinteger(L, (lua_Integer)g_replay.delivered);
+    return 1;
+}
+
+// lv.input_replay_stats() - progress and input-to-flush latency of the current replay
+static int l_lv_input_replay_stats(lua_State* L) {
+    const lvgl_hist_t* h = &g_replay.latency;
+    lua_createtable(L, 0, 10);
+    lua_pushinteger(L, (lua_Integer)g_replay.event_count);
+    lua_setfield(L, -2, "events");
+    lua_pushinteger(L, (lua_Integer)g_replay.delivered);
+    lua_setfield(L, -2, "delivered");
+    lua_pushinteger(L, (lua_Integer)h->count);
+    lua_setfield(L, -2, "redrawn");
+    lua_pushinteger(L, (lua_Integer)g_replay.no_redraw);
+    lua_setfield(L, -2, "no_redraw");
+    lua_pushboolean(L, lvgl_input_replay_is_done());
+    lua_setfield(L, -2, "done");
+    set_ms_field(L, "p50_ms", lvgl_hist_percentile(h, 0.50));
+    set_ms_field(L, "p95_ms", lvgl_hist_percentile(h, 0.95));
+    set_ms_field(L, "p99_ms", lvgl_hist_percentile(h, 0.99));
+    set_ms_field(L, "max_ms", h->max);
+    set_ms_field(L, "avg_ms", h->count ? h->sum / h->count : 0);
+    return 1;
+}
+
+static const luaL_Reg lv_input_funcs[] = {
+    {"input_record_start", l_lv_input_record_start},
+    {"input_record_stop", l_lv_input_record_stop},
+    {"input_replay", l_lv_input_replay},
+    {"input_replay_stop", l_lv_input_replay_stop},
+    {"input_replay_stats", l_lv_input_replay_stats},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_input_funcs(void) {
+    return lv_input_funcs;
+}
@@ -0,0 +1,197 @@
+﻿/**
+ * @file lvgl_latency_lua_bindings.c
+ * @brief Input-to-photon latency - from an indev read to the flush of the pixels it changed
+ * 输入到显示延迟：包装输入设备的读取定时器，读取时记录时间戳；读取与事件分发
+ * （包括其中同步执行的 Lua 回调）期间发生的重绘区域归属于这次输入，之后第一次
+ * 刷屏覆盖到该区域时结束计时。结果通过 lv.latency_stats() 查询，追踪开启时
+ * 以异步事件 "input to photon" 写入 lv.trace_dump()。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+#include "lvgl_trace.h"
+#include "lvgl/src/misc/lv_area_private.h"
+#include "lvgl/src/misc/lv_timer_private.h"
+
+// Inputs waiting for their pixels to be flushed
+#define LATENCY_MAX_PENDING 64
+
+typedef struct {
+    uint64_t id;
+    uint64_t read_us;               // start of the indev read
+    lv_area_t area;                 // bounding box of the areas invalidated while handling it
+    int invalidated;
+    int armed;                      // a refresh that redraws the area has started
+} latency_input_t;
+
+static struct {
+    lv_display_t* disp;
+    latency_input_t pending[LATENCY_MAX_PENDING];
+    uint32_t pending_count;
+    latency_input_t* current;       // input being dispatched, NULL outside indev processing
+    int input_event;                // the current read produced a press/release/click/rotary event
+    uint64_t next_id;
+    lvgl_hist_t hist;               // microseconds
+    uint32_t no_redraw;             // inputs whose handlers invalidated nothing
+    uint32_t dropped;               // inputs lost because too many were pending
+} g_lat;
+
+static void latency_complete(uint32_t index, uint64_t now) {
+    latency_input_t* in = &g_lat.pending[index];
+    uint64_t us = now - in->read_us;
+    lvgl_hist_add(&g_lat.hist, us > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)us);
+    if (lvgl_trace_enabled) {
+        lvgl_trace_write_async("input to photon", "latency", 'b', in->id, in->read_us);
+        lvgl_trace_write_async("input to photon", "latency", 'e', in->id, now);
+    }
+    g_lat.pending[index] = g_lat.pending[--g_lat.pending_count];
+}
+
+// Marks reads that delivered an actual input event, not just an unchanged state
+static void latency_indev_event_cb(lv_event_t* e) {
+    (void)e;
+    g_lat.input_event = 1;
+}
+
+// Wraps lv_indev_read_timer_cb: the read and the event dispatch run inside it
+static void latency_read_timer_cb(lv_timer_t* timer) {
+    if (g_lat.pending_count >= LATENCY_MAX_PENDING) {
+        g_lat.dropped++;
+        lv_indev_read_timer_cb(timer);
+        return;
+    }
+    latency_input_t* in = &g_lat.pending[g_lat.pending_count];
+    memset(in, 0, sizeof(*in));
+    in->read_us = lvgl_lua_time_us();
+    g_lat.current = in;
+    g_lat.input_event = 0;
+
+    lv_indev_read_timer_cb(timer);
+
+    g_lat.current = NULL;
+    if (!g_lat.input_event) return;
+    if (!in->invalidated) {
+        g_lat.no_redraw++;
+        return;
+    }
+    in->id = ++g_lat.next_id;
+    g_lat.pending_count++;
+}
+
+// Wrap the read timer of input devices created since the last check
+static void latency_attach_indevs(void) {
+    for (lv_indev_t* indev = lv_indev_get_next(NULL); indev; indev = lv_indev_get_next(indev)) {
+        lv_timer_t* timer = lv_indev_get_read_timer(indev);
+        if (!timer || timer->timer_cb != lv_indev_read_timer_cb) continue;
+        lv_timer_set_cb(timer, latency_read_timer_cb);
+        lv_indev_add_event_cb(indev, latency_indev_event_cb, LV_EVENT_PRESSED, NULL);
+        lv_indev_add_event_cb(indev, latency_indev_event_cb, LV_EVENT_RELEASED, NULL);
+        lv_indev_add_event_cb(indev, latency_indev_event_cb, LV_EVENT_ROTARY, NULL);
+    }
+}
+
+static void latency_disp_event_cb(lv_event_t* e) {
+    uint64_t now;
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_INVALIDATE_AREA: {
+            latency_input_t* in = g_lat.current;
+            const lv_area_t* area = (const lv_area_t*)lv_event_get_param(e);
+            if (!in || !area) break;
+            if (in->invalidated) {
+                lv_area_join(&in->area, &in->area, area);
+            } else {
+                in->area = *area;
+                in->invalidated = 1;
+            }
+            break;
+        }
+        case LV_EVENT_REFR_START:
+            latency_attach_indevs();
+            for (uint32_t i = 0; i < g_lat.pending_count; i++) g_lat.pending[i].armed = 1;
+            break;
+        case LV_EVENT_FLUSH_FINISH: {
+            const lv_area_t* area = (const lv_area_t*)lv_event_get_param(e);
+            if (!area) break;
+            now = lvgl_lua_time_us();
+            for (uint32_t i = 0; i < g_lat.pending_count;) {
+                if (g_lat.pending[i].armed && lv_area_is_on(&g_lat.pending[i].area, area)) {
+                    latency_complete(i, now);
+                } else {
+                    i++;
+                }
+            }
+            break;
+        }
+        case LV_EVENT_REFR_READY:
+            // Areas clipped away or merged into others were still redrawn by this refresh
+            now = lvgl_lua_time_us();
+            for (uint32_t i = 0; i < g_lat.pending_count;) {
+                if (g_lat.pending[i].armed) latency_complete(i, now);
+                else i++;
+            }
+            break;
+        case LV_EVENT_DELETE:
+            g_lat.disp = NULL;
+            g_lat.pending_count = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+// Start measuring on the default display, inputs before the first call are not counted
+static void latency_attach(void) {
+    if (g_lat.disp) return;
+    lv_display_t* disp = lv_display_get_default();
+    if (!disp) return;
+    g_lat.disp = disp;
+    lv_display_add_event_cb(disp, latency_disp_event_cb, LV_EVENT_ALL, NULL);
+    latency_attach_indevs();
+}
+
+// ========== Lua API ==========
+
+static void set_ms_field(lua_State* L, const char* name, uint64_t us) {
+    lua_pushnumber(L, (lua_Number)us / 1000.0);
+    lua_setfield(L, -2, name);
+}
+
+// lv.latency_stats() - input-to-photon latency since the last reset
+static int l_lv_latency_stats(lua_State* L) {
+    latency_attach();
+    const lvgl_hist_t* h = &g_lat.hist;
+    lua_createtable(L, 0, 9);
+    lua_pushinteger(L, (lua_Integer)h->count);
+    lua_setfield(L, -2, "count");
+    set_ms_field(L, "avg_ms", h->count ? h->sum / h->count : 0);
+    set_ms_field(L, "p50_ms", lvgl_hist_percentile(h, 0.50));
+    set_ms_field(L, "p95_ms", lvgl_hist_percentile(h, 0.95));
+    set_ms_field(L, "p99_ms", lvgl_hist_percentile(h, 0.99));
+    set_ms_field(L, "max_ms", h->max);
+    lua_pushinteger(L, (lua_Integer)g_lat.pending_count);
+    lua_setfield(L, -2, "pending");
+    lua_pushinteger(L, (lua_Integer)g_lat.no_redraw);
+    lua_setfield(L, -2, "no_redraw");
+    lua_pushinteger(L, (lua_Integer)g_lat.dropped);
+    lua_setfield(L, -2, "dropped");
+    return 1;
+}
+
+// lv.latency_stats_reset() - also starts measuring
+static int l_lv_latency_stats_reset(lua_State* L) {
+    (void)L;
+    latency_attach();
+    lvgl_hist_reset(&g_lat.hist);
+    g_lat.no_redraw = 0;
+    g_lat.dropped = 0;
+    return 0;
+}
+
+static const luaL_Reg lv_latency_funcs[] = {
+    {"latency_stats", l_lv_latency_stats},
+    {"latency_stats_reset", l_lv_latency_stats_reset},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_latency_funcs(void) {
+    return lv_latency_funcs;
+}
@@ -5,6 +5,7 @@
  */
 
 #include "lvgl_lua_bindings_internal.h"
+#include "lvgl/src/misc/lv_timer_private.h"
 
 static int luaopen_lvgl(lua_State* L);
 
@@ -85,6 +86,25 @@ lv_timer_t* check_lv_timer(lua_State* L, int idx) {
     return NULL;
 }
 
+// Helper: open a file (fopen_s on MSVC), returns NULL on failure
+FILE* lvgl_lua_fopen(const char* path, const char* mode) {
+    FILE* f = NULL;
+#if defined(_MSC_VER)
+    if (fopen_s(&f, path, mode) != 0) f = NULL;
+#else
+    f = fopen(path, mode);
+#endif
+    return f;
+}
+
+// Helper: main thread of L; callbacks stored for later must not keep a coroutine
+lua_State* lvgl_lua_main_thread(lua_State* L) {
+    lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+    lua_State* main = lua_tothread(L, -1);
+    lua_pop(L, 1);
+    return main;
+}
+
 // ========== Timer callback and methods ==========
 
 // Timer callback function
@@ -98,13 +118,30 @@ static void lua_timer_cb(lv_timer_t* timer) {
     // Push timer userdata as argument
     push_lv_timer(L, timer);
     
-    if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+    if (lvgl_lua_call_callback(L, 1, cb_data->stats, timer, NULL) != LUA_OK) {
         const char* err = lua_tostring(L, -1);
         printf("Lua timer callback error: %s\n", err ? err : "unknown");
         lua_pop(L, 1);
     }
 }
 
+void lvgl_lua_release_state(lua_State* L) {
+    lv_timer_t* timer = lv_timer_get_next(NULL);
+    while (timer) {
+        lv_timer_t* next = lv_timer_get_next(timer);
+        lua_timer_cb_data_t* cb_data = (lua_timer_cb_data_t*)lv_timer_get_user_data(timer);
+        if (timer->timer_cb == lua_timer_cb && cb_data && cb_data->L == L) {
+            free(cb_data);
+            lv_timer_delete(timer);
+        }
+        timer = next;
+    }
+    lvgl_watch_release_state(L);
+    lvgl_worker_release_state(L);
+    lvgl_perf_release_state(L);
+    lvgl_profiler_release_state(L);
+}
+
 // timer:delete()
 static int l_timer_delete(lua_State* L) {
     lv_timer_t* timer = check_lv_timer(L, 1);
@@ -217,9 +254,8 @@ static int l_lv_obj_create(lua_State* L) {
     return 1;
 }
 
-// lv.label_create(parent)
-static int l_lv_label_create(lua_State* L) {
-    lv_obj_t* parent = check_lv_obj(L, 1);
+// Helper: create a label using the current TTF font
+lv_obj_t* lvgl_label_create(lv_obj_t* parent) {
     lv_obj_t* label = lv_label_create(parent);
     
     if (label) {
@@ -233,8 +269,12 @@ static int l_lv_label_create(lua_State* L) {
             lv_obj_set_style_text_font(label, font_to_use, 0);
         }
     }
-    
-    push_lv_obj(L, label);
+    return label;
+}
+
+// lv.label_create(parent)
+static int l_lv_label_create(lua_State* L) {
+    push_lv_obj(L, lvgl_label_create(check_lv_obj(L, 1)));
     return 1;
 }
 
@@ -384,7 +424,8 @@ static int l_lv_timer_create(lua_State* L) {
         return 1;
     }
     
-    cb_data->L = L;
+    cb_data->L = lvgl_lua_main_thread(L);
+    cb_data->stats = lvgl_callback_stats_for(L, 1, "timer");
     lua_pushvalue(L, 1);
     cb_data->func_ref = luaL_ref(L, LUA_REGISTRYINDEX);
     
@@ -494,12 +535,78 @@ static int luaopen_lvgl(lua_State* L) {
     lua_setfield(L, -2, "__index");
     lua_pop(L, 1);
     
+    // Create lv_worker metatable
+    luaL_newmetatable(L, "lv_worker");
+    merge_methods_to_table(L, lvgl_get_worker_metamethods());
+    lua_newtable(L);
+    merge_methods_to_table(L, lvgl_get_worker_methods());
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+    
+    // Create lv_watch metatable
+    luaL_newmetatable(L, "lv_watch");
+    merge_methods_to_table(L, lvgl_get_watch_metamethods());
+    lua_newtable(L);
+    merge_methods_to_table(L, lvgl_get_watch_methods());
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+    
+    // Create lv_preview metatable
+    luaL_newmetatable(L, "lv_preview");
+    merge_methods_to_table(L, lvgl_get_preview_metamethods());
+    lua_newtable(L);
+    merge_methods_to_table(L, lvgl_get_preview_methods());
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+    
     // Create module table
     luaL_newlib(L, lvgl_funcs);
     
     // Add clipboard functions
     merge_methods_to_table(L, lvgl_get_clipboard_funcs());
     
+    // Add worker functions
+    merge_methods_to_table(L, lvgl_get_worker_funcs());
+    
+    // Add callback statistics functions
+    merge_methods_to_table(L, lvgl_get_callback_funcs());
+    
+    // Add profiler functions
+    merge_methods_to_table(L, lvgl_get_profiler_funcs());
+    
+    // Add trace functions
+    merge_methods_to_table(L, lvgl_get_trace_funcs());
+    
+    // Add performance statistics functions
+    merge_methods_to_table(L, lvgl_get_perf_funcs());
+    
+    // Add headless display functions
+    merge_methods_to_table(L, lvgl_get_headless_funcs());
+    
+    // Add virtual clock functions
+    merge_methods_to_table(L, lvgl_get_clock_funcs());
+    
+    // Add input record/replay functions
+    merge_methods_to_table(L, lvgl_get_input_funcs());
+    
+    // Add input-to-photon latency functions
+    merge_methods_to_table(L, lvgl_get_latency_funcs());
+    
+    // Add micro-benchmark functions
+    merge_methods_to_table(L, lvgl_get_bench_funcs());
+    
+    // Add bytecode precompilation functions
+    merge_methods_to_table(L, lvgl_get_chunk_funcs());
+    
+    // Add binary page description functions
+    merge_methods_to_table(L, lvgl_get_page_funcs());
+    
+    // Add directory watch functions
+    merge_methods_to_table(L, lvgl_get_watch_funcs());
+    
+    // Add in-process preview functions
+    merge_methods_to_table(L, lvgl_get_preview_funcs());
+    
     // Add constants - Alignment
     lua_pushinteger(L, LV_ALIGN_DEFAULT); lua_setfield(L, -2, "ALIGN_DEFAULT");
     lua_pushinteger(L, LV_ALIGN_TOP_LEFT); lua_setfield(L, -2, "ALIGN_TOP_LEFT");
@@ -660,6 +767,8 @@ void lvgl_lua_register(lua_State* L) {
     lua_setfield(L, -2, "lvgl");
     lua_pop(L, 2);
     
+    lvgl_clock_install_os_hooks(L);
+    
     luaopen_lvgl(L);
     lua_setglobal(L, "lvgl");
 }
@@ -5,7 +5,9 @@
 //公共头文件
 #ifndef LVGL_LUA_BINDINGS_H
 #define LVGL_LUA_BINDINGS_H
-#ifndef LVGLLUABINDING_EXPORTS
+#if !defined(_WIN32)
+#define LVGLLUABINDING_API __attribute__((visibility("default")))
+#elif !defined(LVGLLUABINDING_EXPORTS)
 #define LVGLLUABINDING_API __declspec(dllimport)
 #else
 #define LVGLLUABINDING_API __declspec(dllexport)
@@ -27,6 +29,96 @@ extern "C" {
 LVGLLUABINDING_API void lvgl_lua_register(lua_State* L);
 LVGLLUABINDING_API void set_current_ttf_font(lv_font_t* font);
 LVGLLUABINDING_API lv_font_t* get_current_ttf_font(void);
+
+/**
+ * @brief Create a display without a window, rendering into a memory framebuffer (XRGB8888)
+ * @param width Horizontal resolution
+ * @param height Vertical resolution
+ * @return The display, or NULL on failure
+ */
+LVGLLUABINDING_API lv_display_t* lvgl_headless_create_display(int32_t width, int32_t height);
+
+/**
+ * @brief Save every rendered frame of a headless display to dir/frame_NNNNNN.<format>
+ * @param disp Headless display
+ * @param dir Output directory, NULL or "" stops dumping
+ * @param format "ppm" or "png"
+ * @return 1 on success, 0 if disp is not headless
+ */
+LVGLLUABINDING_API int lvgl_headless_set_frame_dump(lv_display_t* disp, const char* dir, const char* format);
+
+/**
+ * @brief Save the current frame of a headless display, the format follows the extension (.png / .ppm)
+ * @return 1 on success
+ */
+LVGLLUABINDING_API int lvgl_headless_save_frame(lv_display_t* disp, const char* path);
+
+/**
+ * @brief Get the framebuffer of a headless display (stride = width * 4)
+ * @param frame_count Receives the number of frames rendered so far, may be NULL
+ * @return The framebuffer, or NULL if disp is not headless
+ */
+LVGLLUABINDING_API const uint8_t* lvgl_headless_get_framebuffer(lv_display_t* disp, uint32_t* frame_count);
+
+/**
+ * @brief Drive lv_tick, lv_delay_ms and os.time/os.date from a virtual clock
+ * The clock only moves through lvgl_clock_advance() (or lv_delay_ms), call after lv_init().
+ * @param start_epoch_ms Virtual wall-clock time at start, 0 uses the current time
+ */
+LVGLLUABINDING_API void lvgl_clock_set_virtual(int64_t start_epoch_ms);
+
+/**
+ * @brief Check whether the virtual clock is enabled
+ */
+LVGLLUABINDING_API int lvgl_clock_is_virtual(void);
+
+/**
+ * @brief Advance the virtual clock, ignored when it is not enabled
+ */
+LVGLLUABINDING_API void lvgl_clock_advance(uint32_t ms);
+
+/**
+ * @brief Virtual milliseconds elapsed since lvgl_clock_set_virtual()
+ */
+LVGLLUABINDING_API uint64_t lvgl_clock_elapsed_ms(void);
+
+/**
+ * @brief Set how in-process previews (lv.preview_start) create and destroy their display
+ * Without a factory previews render into a headless display.
+ * @param create Creates a display of the given size, may return NULL
+ * @param destroy Destroys a display returned by create (may happen later), NULL uses lv_display_delete
+ */
+LVGLLUABINDING_API void lvgl_preview_set_display_factory(lv_display_t* (*create)(int32_t width, int32_t height),
+                                                         void (*destroy)(lv_display_t* disp));
+
+/**
+ * @brief Record pointer/keypad/encoder state changes of all input devices into a binary file
+ * @return 1 on success, 0 if the file cannot be created or a recording is running
+ */
+LVGLLUABINDING_API int lvgl_input_record_start(const char* path);
+
+/**
+ * @brief Stop recording and close the file
+ * @return Number of recorded events
+ */
+LVGLLUABINDING_API uint32_t lvgl_input_record_stop(void);
+
+/**
+ * @brief Replay a recording through virtual input devices, the real devices are disabled
+ *        until the last event has been rendered
+ * @return 1 on success, 0 if the file cannot be read
+ */
+LVGLLUABINDING_API int lvgl_input_replay_start(const char* path);
+
+/**
+ * @brief Check whether every event was delivered and its latency measured
+ */
+LVGLLUABINDING_API int lvgl_input_replay_is_done(void);
+
+/**
+ * @brief Print the replay progress and input-to-flush latency percentiles to stdout
+ */
+LVGLLUABINDING_API void lvgl_input_replay_print_stats(void);
 #ifdef __cplusplus
 }
 #endif
@@ -9,11 +9,16 @@
 #include "lvgl_lua_bindings.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
+
+// Per-callback statistics entry (defined in lvgl_callback_lua_bindings.c)
+typedef struct lvgl_cb_stats_s lvgl_cb_stats_t;
 
 // Event callback data structure
 typedef struct {
     lua_State* L;
     int func_ref;
+    lvgl_cb_stats_t* stats;
 } lua_event_cb_data_t;
 
 // Timer callback data structure
@@ -21,6 +26,7 @@ typedef struct {
     lua_State* L;
     int func_ref;
     lv_timer_t* timer;
+    lvgl_cb_stats_t* stats;
 } lua_timer_cb_data_t;
 
 // ========== Helper functions (defined in lvgl_lua_bindings.c) ==========
@@ -40,10 +46,19 @@ void push_lv_timer(lua_State* L, lv_timer_t* timer);
 // Helper: get lv_timer_t* from userdata
 lv_timer_t* check_lv_timer(lua_State* L, int idx);
 
+// Helper: open a file (fopen_s on MSVC), returns NULL on failure
+FILE* lvgl_lua_fopen(const char* path, const char* mode);
+
+// Helper: main thread of L; callbacks stored for later must not keep a coroutine
+lua_State* lvgl_lua_main_thread(lua_State* L);
+
 // Global TTF font access
 lv_font_t* get_current_ttf_font(void);
 void set_current_ttf_font(lv_font_t* font);
 
+// Helper: create a label using the current TTF font, as lv.label_create does
+lv_obj_t* lvgl_label_create(lv_obj_t* parent);
+
 // ========== Registration functions for sub-modules ==========
 
 // Register object methods (defined in lvgl_obj_lua_bindings.c)
@@ -64,4 +79,153 @@ const luaL_Reg* lvgl_get_slider_methods(void);
 // Get clipboard functions
 const luaL_Reg* lvgl_get_clipboard_funcs(void);
 
+// Get worker functions, methods and metamethods (defined in lvgl_worker_lua_bindings.c)
+const luaL_Reg* lvgl_get_worker_funcs(void);
+const luaL_Reg* lvgl_get_worker_methods(void);
+const luaL_Reg* lvgl_get_worker_metamethods(void);
+
+// Terminate workers whose handlers live in L
+void lvgl_worker_release_state(lua_State* L);
+
+// ========== Callback timing (defined in lvgl_callback_lua_bindings.c) ==========
+
+// Monotonic time in microseconds
+uint64_t lvgl_lua_time_us(void);
+
+// Log-linear histogram: 4 sub-buckets per power of two
+#define LVGL_HIST_BUCKETS 128
+typedef struct {
+    uint32_t buckets[LVGL_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint32_t max;
+} lvgl_hist_t;
+
+void lvgl_hist_add(lvgl_hist_t* hist, uint32_t value);
+uint32_t lvgl_hist_percentile(const lvgl_hist_t* hist, double p);
+void lvgl_hist_reset(lvgl_hist_t* hist);
+
+// Get the statistics entry for the function at func_idx, keyed by its source location
+lvgl_cb_stats_t* lvgl_callback_stats_for(lua_State* L, int func_idx, const char* kind);
+
+// lua_pcall(L, nargs, 0, 0) with timing and the callback budget applied.
+// target (widget or timer) and detail (static string) are recorded in the trace.
+int lvgl_lua_call_callback(lua_State* L, int nargs, lvgl_cb_stats_t* stats, const void* target, const char* detail);
+
+// Number of Lua callbacks currently running (0 = UI thread is outside Lua)
+int lvgl_lua_callback_depth(void);
+
+// Re-install the budget hook of a running callback on L, or remove the hook
+void lvgl_callback_restore_hook(lua_State* L);
+
+// Get callback statistics functions
+const luaL_Reg* lvgl_get_callback_funcs(void);
+
+// ========== Sampling profiler (defined in lvgl_profiler_lua_bindings.c) ==========
+
+// Record a pending sample from inside a hook, returns 1 if one was taken
+int lvgl_profiler_take_sample(lua_State* L);
+
+// Get profiler functions
+const luaL_Reg* lvgl_get_profiler_funcs(void);
+
+// Stop the profiler if it samples L
+void lvgl_profiler_release_state(lua_State* L);
+
+// ========== Timeline tracer (defined in lvgl_trace_lua_bindings.c) ==========
+
+// Get trace functions
+const luaL_Reg* lvgl_get_trace_funcs(void);
+
+// ========== Performance statistics (defined in lvgl_perf_lua_bindings.c) ==========
+
+// Get performance statistics functions
+const luaL_Reg* lvgl_get_perf_funcs(void);
+
+// Drop the lv.perf_subscribe() callback if it lives in L
+void lvgl_perf_release_state(lua_State* L);
+
+// ========== Headless display (defined in lvgl_headless_lua_bindings.c) ==========
+
+// Get headless display functions
+const luaL_Reg* lvgl_get_headless_funcs(void);
+
+// ========== Virtual clock (defined in lvgl_clock_lua_bindings.c) ==========
+
+// Milliseconds since the Unix epoch, virtual when the clock is enabled
+int64_t lvgl_clock_now_ms(void);
+
+// Replace os.time/os.date with versions that follow the virtual clock
+void lvgl_clock_install_os_hooks(lua_State* L);
+
+// Get virtual clock functions
+const luaL_Reg* lvgl_get_clock_funcs(void);
+
+// ========== Input record/replay (defined in lvgl_input_lua_bindings.c) ==========
+
+// Get input record/replay functions
+const luaL_Reg* lvgl_get_input_funcs(void);
+
+// ========== Input-to-photon latency (defined in lvgl_latency_lua_bindings.c) ==========
+
+// Get latency functions
+const luaL_Reg* lvgl_get_latency_funcs(void);
+
+// ========== Micro-benchmarks (defined in lvgl_bench_lua_bindings.c) ==========
+
+// Get micro-benchmark functions
+const luaL_Reg* lvgl_get_bench_funcs(void);
+
+// ========== Precompilation (defined in lvgl_chunk_lua_bindings.c) ==========
+
+// Get bytecode dump and hashing functions
+const luaL_Reg* lvgl_get_chunk_funcs(void);
+
+// ========== Binary page description (defined in lvgl_page_lua_bindings.c) ==========
+
+// Get page blob functions
+const luaL_Reg* lvgl_get_page_funcs(void);
+
+// ========== Directory watching (defined in lvgl_watch_lua_bindings.c) ==========
+
+// Get directory watch functions, methods and metamethods
+const luaL_Reg* lvgl_get_watch_funcs(void);
+const luaL_Reg* lvgl_get_watch_methods(void);
+const luaL_Reg* lvgl_get_watch_metamethods(void);
+
+// Stop watches whose callbacks live in L
+void lvgl_watch_release_state(lua_State* L);
+
+// ========== In-process preview (defined in lvgl_preview_lua_bindings.c) ==========
+
+// Get preview functions, methods and metamethods
+const luaL_Reg* lvgl_get_preview_funcs(void);
+const luaL_Reg* lvgl_get_preview_methods(void);
+const luaL_Reg* lvgl_get_preview_metamethods(void);
+
+// Display of the preview running in L, callbacks of that state create objects on it; NULL otherwise
+lv_display_t* lvgl_preview_display_for(lua_State* L);
+
+// Delete timers, watches, workers, the perf subscription and the profiler that call back into L,
+// before L is closed (defined in lvgl_lua_bindings.c)
+void lvgl_lua_release_state(lua_State* L);
+
+// ========== Value serialization (defined in lvgl_worker_lua_bindings.c) ==========
+
+// Growable byte buffer
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} lvgl_lua_buf_t;
+
+void lvgl_lua_buf_free(lvgl_lua_buf_t* buf);
+
+// Serialize stack values [first, last] (nil/boolean/number/string/table) into buf.
+// Returns 1 on success, otherwise pushes an error message and returns 0.
+int lvgl_lua_serialize(lua_State* L, int first, int last, lvgl_lua_buf_t* buf);
+
+// Push the values stored by lvgl_lua_serialize, returns the number of values pushed
+int lvgl_lua_deserialize(lua_State* L, const char* data, size_t len);
+
 #endif // LVGL_LUA_BINDINGS_INTERNAL_H
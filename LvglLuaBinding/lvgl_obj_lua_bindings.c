@@ -4,6 +4,7 @@
  */
 
 #include "lvgl_lua_bindings_internal.h"
+#include "lvgl/src/misc/lv_area_private.h"
 
 // ========== Object Methods (for obj:method() syntax) ==========
 
@@ -440,16 +441,28 @@ static void lua_event_cb(lv_event_t* e) {
     if (!cb_data || cb_data->func_ref == LUA_NOREF) return;
     
     lua_State* L = cb_data->L;
+    lv_event_code_t code = lv_event_get_code(e);
     lua_rawgeti(L, LUA_REGISTRYINDEX, cb_data->func_ref);
-    lua_pushinteger(L, lv_event_get_code(e));
+    lua_pushinteger(L, code);
     
-    if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+    if (lvgl_lua_call_callback(L, 1, cb_data->stats, lv_event_get_current_target(e), lv_event_code_get_name(code)) != LUA_OK) {
         const char* err = lua_tostring(L, -1);
         printf("Lua event callback error: %s\n", err ? err : "unknown");
         lua_pop(L, 1);
     }
 }
 
+// Release the Lua callback when its object is deleted (registered after the callback itself,
+// so a Lua handler for LV_EVENT_DELETE still runs first)
+static void lua_event_free_cb(lv_event_t* e) {
+    lua_event_cb_data_t* cb_data = (lua_event_cb_data_t*)lv_event_get_user_data(e);
+    if (!cb_data) return;
+    if (cb_data->func_ref != LUA_NOREF) {
+        luaL_unref(cb_data->L, LUA_REGISTRYINDEX, cb_data->func_ref);
+    }
+    free(cb_data);
+}
+
 // obj:add_event_cb(callback, event_code)
 static int l_obj_add_event_cb(lua_State* L) {
     lv_obj_t* obj = check_lv_obj(L, 1);
@@ -459,14 +472,26 @@ static int l_obj_add_event_cb(lua_State* L) {
     if (!obj) return 0;
     
     lua_event_cb_data_t* cb_data = (lua_event_cb_data_t*)malloc(sizeof(lua_event_cb_data_t));
-    cb_data->L = L;
+    if (!cb_data) return luaL_error(L, "not enough memory");
+    cb_data->L = lvgl_lua_main_thread(L);
+    cb_data->stats = lvgl_callback_stats_for(L, 2, "event");
     lua_pushvalue(L, 2);
     cb_data->func_ref = luaL_ref(L, LUA_REGISTRYINDEX);
     
     lv_obj_add_event_cb(obj, lua_event_cb, event_code, cb_data);
+    lv_obj_add_event_cb(obj, lua_event_free_cb, LV_EVENT_DELETE, cb_data);
     return 0;
 }
 
+// obj:send_event(event_code) - dispatch an event to the object's handlers
+static int l_obj_send_event(lua_State* L) {
+    lv_obj_t* obj = check_lv_obj(L, 1);
+    lv_event_code_t event_code = (lv_event_code_t)luaL_checkinteger(L, 2);
+    lv_result_t res = obj ? lv_obj_send_event(obj, event_code, NULL) : LV_RESULT_INVALID;
+    lua_pushboolean(L, res == LV_RESULT_OK);
+    return 1;
+}
+
 // obj:set_text(text)
 static int l_obj_set_text(lua_State* L) {
     lv_obj_t* obj = check_lv_obj(L, 1);
@@ -508,6 +533,98 @@ static int l_obj_invalidate(lua_State* L) {
     return 0;
 }
 
+// Grid drawn under the children of an object
+typedef struct {
+    int32_t size;
+    lv_color_t color;
+    lv_opa_t opa;
+} obj_grid_t;
+
+static void obj_grid_event_cb(lv_event_t* e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    obj_grid_t* grid = (obj_grid_t*)lv_event_get_user_data(e);
+    if (code == LV_EVENT_DELETE) {
+        free(grid);
+        return;
+    }
+    if (code != LV_EVENT_DRAW_MAIN_END) return;
+
+    lv_obj_t* obj = lv_event_get_current_target_obj(e);
+    lv_layer_t* layer = lv_event_get_layer(e);
+    lv_area_t area;
+    lv_obj_get_content_coords(obj, &area);
+    lv_area_t clip;
+    if (!lv_area_intersect(&clip, &area, &layer->_clip_area)) return;
+
+    lv_draw_line_dsc_t dsc;
+    lv_draw_line_dsc_init(&dsc);
+    dsc.color = grid->color;
+    dsc.opa = grid->opa;
+    dsc.width = 1;
+
+    // Only the lines crossing the area being redrawn
+    int32_t first = (clip.x1 - area.x1 + grid->size - 1) / grid->size;
+    if (first < 1) first = 1;
+    for (int32_t x = area.x1 + first * grid->size; x <= clip.x2; x += grid->size) {
+        dsc.p1.x = x;
+        dsc.p1.y = clip.y1;
+        dsc.p2.x = x;
+        dsc.p2.y = clip.y2;
+        lv_draw_line(layer, &dsc);
+    }
+    first = (clip.y1 - area.y1 + grid->size - 1) / grid->size;
+    if (first < 1) first = 1;
+    for (int32_t y = area.y1 + first * grid->size; y <= clip.y2; y += grid->size) {
+        dsc.p1.x = clip.x1;
+        dsc.p1.y = y;
+        dsc.p2.x = clip.x2;
+        dsc.p2.y = y;
+        lv_draw_line(layer, &dsc);
+    }
+}
+
+static obj_grid_t* obj_find_grid(lv_obj_t* obj, lv_event_dsc_t** dsc_out) {
+    uint32_t count = lv_obj_get_event_count(obj);
+    for (uint32_t i = 0; i < count; i++) {
+        lv_event_dsc_t* dsc = lv_obj_get_event_dsc(obj, i);
+        if (lv_event_dsc_get_cb(dsc) == obj_grid_event_cb) {
+            if (dsc_out) *dsc_out = dsc;
+            return (obj_grid_t*)lv_event_dsc_get_user_data(dsc);
+        }
+    }
+    return NULL;
+}
+
+// obj:set_grid(size[, color=0x2A2A2A, opa=128]) - draw grid lines every size pixels under the children; size 0 or nil removes it
+static int l_obj_set_grid(lua_State* L) {
+    lv_obj_t* obj = check_lv_obj(L, 1);
+    int32_t size = (int32_t)luaL_optinteger(L, 2, 0);
+    uint32_t color_hex = (uint32_t)luaL_optinteger(L, 3, 0x2A2A2A);
+    lv_opa_t opa = (lv_opa_t)luaL_optinteger(L, 4, 128);
+    if (!obj) return 0;
+
+    lv_event_dsc_t* dsc = NULL;
+    obj_grid_t* grid = obj_find_grid(obj, &dsc);
+    if (size <= 0) {
+        if (grid) {
+            lv_obj_remove_event_dsc(obj, dsc);
+            free(grid);
+            lv_obj_invalidate(obj);
+        }
+        return 0;
+    }
+    if (!grid) {
+        grid = (obj_grid_t*)malloc(sizeof(obj_grid_t));
+        if (!grid) return luaL_error(L, "out of memory");
+        lv_obj_add_event_cb(obj, obj_grid_event_cb, LV_EVENT_ALL, grid);
+    }
+    grid->size = size;
+    grid->color = lv_color_hex(color_hex);
+    grid->opa = opa;
+    lv_obj_invalidate(obj);
+    return 0;
+}
+
 // obj:set_style_text_font(font_or_size, selector)
 static int l_obj_set_style_text_font(lua_State* L) {
     lv_obj_t* obj = check_lv_obj(L, 1);
@@ -778,9 +895,11 @@ static const luaL_Reg lv_obj_methods[] = {
     {"move_foreground", l_obj_move_foreground},
     {"move_background", l_obj_move_background},
     {"add_event_cb", l_obj_add_event_cb},
+    {"send_event", l_obj_send_event},
     {"set_text", l_obj_set_text},
     {"get_text", l_obj_get_text},
     {"invalidate", l_obj_invalidate},
+    {"set_grid", l_obj_set_grid},
     {"set_content_width", l_obj_set_content_width},
     {"set_content_height", l_obj_set_content_height},
     {"scroll_to_view", l_obj_scroll_to_view},
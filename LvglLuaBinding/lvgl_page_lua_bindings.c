@@ -0,0 +1,158 @@
+﻿/**
+ * @file lvgl_page_lua_bindings.c
+ * @brief Binary page description - static widgets created in one C call
+ * 图页二进制描述：ProjectCompiler 把没有脚本行为的控件（无事件处理、无表达式、无实例名）
+ * 编码为紧凑的记录（类型、位置尺寸、字符串表），lv.build_page 一次创建全部 LVGL 对象，
+ * 不经过控件模块的 Lua 构造函数。对象结构必须与对应控件模块的 new() 一致。
+ *
+ * 格式（小端）：
+ *   "VPB2"  u16 字符串数  u16 记录数
+ *   字符串：u16 长度 + 内容 + '\0'
+ *   记录：  u8 类型  i16 x  i16 y  i16 宽  i16 高  u16 文本（字符串序号，0xFFFF 为无）
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+
+#define PAGE_BLOB_MAGIC "VPB2"
+#define PAGE_BLOB_HEADER_SIZE 8
+#define PAGE_BLOB_RECORD_SIZE 11
+#define PAGE_BLOB_NO_TEXT 0xFFFFu
+
+// Record types
+enum {
+    PAGE_WIDGET_BUTTON = 1,     // widgets.button: lv_button with a centered label
+};
+
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+} page_reader_t;
+
+static int reader_has(const page_reader_t* r, size_t n) {
+    return (size_t)(r->end - r->p) >= n;
+}
+
+static uint16_t read_u16(page_reader_t* r) {
+    uint16_t v = (uint16_t)(r->p[0] | (r->p[1] << 8));
+    r->p += 2;
+    return v;
+}
+
+// Walk the string table, fills strings[] when given; returns 0 if the blob is truncated
+static int read_strings(page_reader_t* r, uint16_t count, const char** strings) {
+    for (uint16_t i = 0; i < count; i++) {
+        if (!reader_has(r, 2)) return 0;
+        uint16_t len = read_u16(r);
+        if (!reader_has(r, (size_t)len + 1) || r->p[len] != '\0') return 0;
+        if (strings) strings[i] = (const char*)r->p;
+        r->p += len + 1;
+    }
+    return 1;
+}
+
+// Check every record before creating anything so a bad blob leaves the parent untouched
+static int validate_records(page_reader_t r, uint16_t count, uint16_t string_count) {
+    for (uint16_t i = 0; i < count; i++) {
+        if (!reader_has(&r, PAGE_BLOB_RECORD_SIZE)) return 0;
+        uint8_t type = r.p[0];
+        r.p += 9;
+        uint16_t text = read_u16(&r);
+        if (type != PAGE_WIDGET_BUTTON) return 0;
+        if (text != PAGE_BLOB_NO_TEXT && text >= string_count) return 0;
+    }
+    return 1;
+}
+
+static lv_style_t* center_style(void) {
+    static lv_style_t style;
+    static int initialized = 0;
+    if (!initialized) {
+        lv_style_init(&style);
+        lv_style_set_align(&style, LV_ALIGN_CENTER);
+        initialized = 1;
+    }
+    return &style;
+}
+
+// Same objects as widgets/button.lua Button.new
+static void build_button(lv_obj_t* parent, int32_t x, int32_t y, int32_t w, int32_t h, const char* text) {
+    lv_obj_t* btn = lv_button_create(parent);
+    lv_obj_set_size(btn, w, h);
+    lv_obj_set_pos(btn, x, y);
+
+    // Same font as lv.label_create
+    lv_obj_t* label = lvgl_label_create(btn);
+    lv_label_set_text(label, text ? text : "");
+    // Same result as lv_obj_center() with one shared style instead of three local properties
+    lv_obj_add_style(label, center_style(), 0);
+}
+
+// Refresh an object created with style refresh disabled, and its children
+static void refresh_tree(lv_obj_t* obj) {
+    lv_obj_refresh_style(obj, LV_PART_ANY, LV_STYLE_PROP_ANY);
+    uint32_t count = lv_obj_get_child_count(obj);
+    for (uint32_t i = 0; i < count; i++) {
+        refresh_tree(lv_obj_get_child(obj, (int32_t)i));
+    }
+}
+
+// lv.build_page(blob, parent) - create the widgets of a page blob, returns the number created
+static int l_lv_build_page(lua_State* L) {
+    size_t len = 0;
+    const char* data = luaL_checklstring(L, 1, &len);
+    lv_obj_t* parent = check_lv_obj(L, 2);
+    luaL_argcheck(L, parent != NULL, 2, "parent object expected");
+
+    page_reader_t r = { (const uint8_t*)data, (const uint8_t*)data + len };
+    if (!reader_has(&r, PAGE_BLOB_HEADER_SIZE) || memcmp(r.p, PAGE_BLOB_MAGIC, 4) != 0) {
+        return luaL_error(L, "invalid page blob: bad header");
+    }
+    r.p += 4;
+    uint16_t string_count = read_u16(&r);
+    uint16_t record_count = read_u16(&r);
+
+    const char** strings = NULL;
+    if (string_count) {
+        strings = (const char**)malloc(string_count * sizeof(*strings));
+        if (!strings) return luaL_error(L, "not enough memory");
+    }
+    if (!read_strings(&r, string_count, strings) || !validate_records(r, record_count, string_count)) {
+        free(strings);
+        return luaL_error(L, "invalid page blob: truncated or unknown record");
+    }
+
+    // Style changes are not refreshed while creating: the theme styles, position, size and
+    // alignment of every object would each invalidate and mark the layout dirty.
+    // Each new object is refreshed once afterwards instead.
+    uint32_t first_child = lv_obj_get_child_count(parent);
+    lv_obj_enable_style_refresh(false);
+    for (uint16_t i = 0; i < record_count; i++) {
+        uint8_t type = r.p[0];
+        r.p += 1;
+        int32_t x = (int16_t)read_u16(&r);
+        int32_t y = (int16_t)read_u16(&r);
+        int32_t w = (int16_t)read_u16(&r);
+        int32_t h = (int16_t)read_u16(&r);
+        uint16_t text = read_u16(&r);
+        const char* str = text == PAGE_BLOB_NO_TEXT ? NULL : strings[text];
+        if (type == PAGE_WIDGET_BUTTON) build_button(parent, x, y, w, h, str);
+    }
+    free(strings);
+    lv_obj_enable_style_refresh(true);
+    uint32_t child_count = lv_obj_get_child_count(parent);
+    for (uint32_t i = first_child; i < child_count; i++) {
+        refresh_tree(lv_obj_get_child(parent, (int32_t)i));
+    }
+
+    lua_pushinteger(L, record_count);
+    return 1;
+}
+
+static const luaL_Reg lv_page_funcs[] = {
+    {"build_page", l_lv_build_page},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_page_funcs(void) {
+    return lv_page_funcs;
+}
@@ -0,0 +1,357 @@
+﻿/**
+ * @file lvgl_perf_lua_bindings.c
+ * @brief Performance statistics - frame timing, dirty area and heap usage as Lua values
+ * 性能统计：通过显示器事件测量每帧的刷新/渲染/刷屏耗时与脏区域面积，
+ * 供 lv.perf_stats() 查询，或通过 lv.perf_subscribe() 每 N 帧回调一次；
+ * lv.resource_stats() 统计存活的对象、定时器和 Lua 注册表引用，用于泄漏检测。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+#include "lvgl/src/display/lv_display_private.h"
+
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Statistics accumulated over a window of frames
+typedef struct {
+    uint64_t start_us;
+    lvgl_hist_t refr;               // REFR_START -> REFR_READY, rendered frames only
+    lvgl_hist_t render;             // rendering without flushing
+    lvgl_hist_t flush;              // flushing and waiting for flush
+    uint64_t dirty_sum;             // invalidated pixels
+    uint32_t dirty_max;
+} perf_window_t;
+
+static struct {
+    lv_display_t* disp;
+    // Current frame
+    uint64_t refr_start_us;
+    uint64_t render_start_us;
+    uint64_t flush_start_us;
+    uint64_t flush_us;
+    uint64_t render_us;
+    uint32_t dirty_px;
+    int rendered;
+    // lv.perf_stats() window
+    perf_window_t query;
+    // lv.perf_subscribe() window
+    perf_window_t sub;
+    lua_State* sub_L;
+    int sub_ref;
+    uint32_t sub_every;
+} g_perf = { .sub_ref = LUA_NOREF };
+
+static void window_reset(perf_window_t* w) {
+    memset(w, 0, sizeof(*w));
+    w->start_us = lvgl_lua_time_us();
+}
+
+static void window_add(perf_window_t* w, uint32_t refr_us, uint32_t render_us, uint32_t flush_us, uint32_t dirty) {
+    lvgl_hist_add(&w->refr, refr_us);
+    lvgl_hist_add(&w->render, render_us);
+    lvgl_hist_add(&w->flush, flush_us);
+    w->dirty_sum += dirty;
+    if (dirty > w->dirty_max) w->dirty_max = dirty;
+}
+
+static uint32_t clamp_u32(uint64_t us) {
+    return us > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)us;
+}
+
+// Sum of the areas that will be redrawn, joined areas are already merged into others
+static uint32_t dirty_area(lv_display_t* disp) {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < disp->inv_p; i++) {
+        if (disp->inv_area_joined[i]) continue;
+        sum += (uint64_t)lv_area_get_size(&disp->inv_areas[i]);
+    }
+    return clamp_u32(sum);
+}
+
+static void push_stats(lua_State* L, const perf_window_t* w, int with_heap);
+
+static void deliver_subscription(void) {
+    lua_State* L = g_perf.sub_L;
+    lua_rawgeti(L, LUA_REGISTRYINDEX, g_perf.sub_ref);
+    // Heap sampling walks the C runtime heap on Windows, keep it out of the display event path
+    push_stats(L, &g_perf.sub, 0);
+    window_reset(&g_perf.sub);
+    if (lvgl_lua_call_callback(L, 1, NULL, g_perf.disp, "perf") != LUA_OK) {
+        const char* err = lua_tostring(L, -1);
+        printf("Lua perf callback error: %s\n", err ? err : "unknown");
+        lua_pop(L, 1);
+    }
+}
+
+static void perf_disp_event_cb(lv_event_t* e) {
+    lv_display_t* disp = (lv_display_t*)lv_event_get_target(e);
+    uint64_t now = lvgl_lua_time_us();
+
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_REFR_START:
+            g_perf.refr_start_us = now;
+            g_perf.flush_us = 0;
+            g_perf.render_us = 0;
+            g_perf.dirty_px = 0;
+            g_perf.rendered = 0;
+            break;
+        case LV_EVENT_RENDER_START:
+            g_perf.render_start_us = now;
+            g_perf.dirty_px = dirty_area(disp);
+            g_perf.rendered = 1;
+            break;
+        case LV_EVENT_RENDER_READY: {
+            // Flushes so far happened while rendering, don't count them twice
+            uint64_t render = now - g_perf.render_start_us;
+            g_perf.render_us = render > g_perf.flush_us ? render - g_perf.flush_us : 0;
+            break;
+        }
+        case LV_EVENT_FLUSH_START:
+        case LV_EVENT_FLUSH_WAIT_START:
+            g_perf.flush_start_us = now;
+            break;
+        case LV_EVENT_FLUSH_FINISH:
+        case LV_EVENT_FLUSH_WAIT_FINISH:
+            g_perf.flush_us += now - g_perf.flush_start_us;
+            break;
+        case LV_EVENT_REFR_READY: {
+            // Refresh periods without invalidated areas are not frames
+            if (!g_perf.rendered) break;
+            uint32_t refr_us = clamp_u32(now - g_perf.refr_start_us);
+            uint32_t render_us = clamp_u32(g_perf.render_us);
+            uint32_t flush_us = clamp_u32(g_perf.flush_us);
+            window_add(&g_perf.query, refr_us, render_us, flush_us, g_perf.dirty_px);
+            window_add(&g_perf.sub, refr_us, render_us, flush_us, g_perf.dirty_px);
+            if (g_perf.sub_ref != LUA_NOREF && g_perf.sub.refr.count >= g_perf.sub_every) {
+                deliver_subscription();
+            }
+            break;
+        }
+        case LV_EVENT_DELETE:
+            g_perf.disp = NULL;
+            break;
+        default:
+            break;
+    }
+}
+
+// Start measuring the default display, frames before the first call are not counted
+static void perf_attach(void) {
+    if (g_perf.disp) return;
+    lv_display_t* disp = lv_display_get_default();
+    if (!disp) return;
+    g_perf.disp = disp;
+    window_reset(&g_perf.query);
+    window_reset(&g_perf.sub);
+    lv_display_add_event_cb(disp, perf_disp_event_cb, LV_EVENT_ALL, NULL);
+}
+
+// ========== Heap ==========
+
+// Fill mon from the LVGL heap, or from the C runtime heap when LVGL uses the C library allocator
+static int heap_monitor(lv_mem_monitor_t* mon) {
+    memset(mon, 0, sizeof(*mon));
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
+    lv_mem_monitor(mon);
+    return 1;
+#elif defined(_WIN32)
+    _HEAPINFO info;
+    int status;
+    info._pentry = NULL;
+    while ((status = _heapwalk(&info)) == _HEAPOK) {
+        if (info._useflag == _USEDENTRY) {
+            mon->used_cnt++;
+            mon->total_size += info._size;
+        } else {
+            mon->free_cnt++;
+            mon->free_size += info._size;
+            if (info._size > mon->free_biggest_size) mon->free_biggest_size = info._size;
+        }
+    }
+    if (status != _HEAPEND && status != _HEAPEMPTY) return 0;
+    mon->max_used = mon->total_size;
+    mon->total_size += mon->free_size;
+#elif defined(__GLIBC__) && defined(__GLIBC_PREREQ) && __GLIBC_PREREQ(2, 33)
+    struct mallinfo2 mi = mallinfo2();
+    mon->max_used = mi.uordblks;
+    mon->free_size = mi.fordblks;
+    mon->free_cnt = mi.ordblks;
+    mon->total_size = mi.uordblks + mi.fordblks;
+    // glibc does not report the biggest free chunk, treat the heap as unfragmented
+    mon->free_biggest_size = mi.fordblks;
+#else
+    return 0;
+#endif
+    if (mon->total_size) {
+        mon->used_pct = (uint8_t)(100 - (mon->free_size * 100) / mon->total_size);
+    }
+    if (mon->free_size) {
+        mon->frag_pct = (uint8_t)(100 - (mon->free_biggest_size * 100) / mon->free_size);
+    }
+    return 1;
+}
+
+// ========== Lua API ==========
+
+static void set_ms_field(lua_State* L, const char* name, uint64_t us) {
+    lua_pushnumber(L, (lua_Number)us / 1000.0);
+    lua_setfield(L, -2, name);
+}
+
+static void set_int_field(lua_State* L, const char* name, lua_Integer value) {
+    lua_pushinteger(L, value);
+    lua_setfield(L, -2, name);
+}
+
+static void set_hist_fields(lua_State* L, const char* prefix, const lvgl_hist_t* h) {
+    char name[32];
+    snprintf(name, sizeof(name), "%s_avg_ms", prefix);
+    set_ms_field(L, name, h->count ? h->sum / h->count : 0);
+    snprintf(name, sizeof(name), "%s_p99_ms", prefix);
+    set_ms_field(L, name, lvgl_hist_percentile(h, 0.99));
+    snprintf(name, sizeof(name), "%s_max_ms", prefix);
+    set_ms_field(L, name, h->max);
+}
+
+static void push_stats(lua_State* L, const perf_window_t* w, int with_heap) {
+    uint64_t elapsed = lvgl_lua_time_us() - w->start_us;
+    uint64_t frames = w->refr.count;
+    lv_mem_monitor_t mon;
+
+    lua_createtable(L, 0, 24);
+    set_int_field(L, "frames", (lua_Integer)frames);
+    set_ms_field(L, "elapsed_ms", elapsed);
+    lua_pushnumber(L, elapsed ? (lua_Number)frames * 1000000.0 / (lua_Number)elapsed : 0);
+    lua_setfield(L, -2, "fps");
+    set_int_field(L, "cpu", 100 - (lua_Integer)lv_timer_get_idle());
+
+    set_hist_fields(L, "refr", &w->refr);
+    set_hist_fields(L, "render", &w->render);
+    set_hist_fields(L, "flush", &w->flush);
+
+    set_int_field(L, "dirty_px", frames ? (lua_Integer)(w->dirty_sum / frames) : 0);
+    set_int_field(L, "dirty_max_px", w->dirty_max);
+    if (g_perf.disp) {
+        uint64_t screen = (uint64_t)lv_display_get_horizontal_resolution(g_perf.disp) *
+                          (uint64_t)lv_display_get_vertical_resolution(g_perf.disp);
+        lua_pushnumber(L, screen && frames ? (lua_Number)w->dirty_sum * 100.0 / ((lua_Number)screen * frames) : 0);
+        lua_setfield(L, -2, "dirty_pct");
+    }
+
+    lua_pushnumber(L, (lua_Number)lua_gc(L, LUA_GCCOUNT) + (lua_Number)lua_gc(L, LUA_GCCOUNTB) / 1024.0);
+    lua_setfield(L, -2, "lua_kb");
+    if (with_heap && heap_monitor(&mon)) {
+        set_int_field(L, "heap_used", (lua_Integer)(mon.total_size - mon.free_size));
+        set_int_field(L, "heap_free", (lua_Integer)mon.free_size);
+        set_int_field(L, "heap_biggest_free", (lua_Integer)mon.free_biggest_size);
+        set_int_field(L, "heap_used_pct", mon.used_pct);
+        set_int_field(L, "heap_frag_pct", mon.frag_pct);
+    }
+}
+
+// lv.perf_stats() - statistics since the first call or the last lv.perf_stats_reset()
+static int l_lv_perf_stats(lua_State* L) {
+    perf_attach();
+    push_stats(L, &g_perf.query, 1);
+    return 1;
+}
+
+// lv.perf_stats_reset()
+static int l_lv_perf_stats_reset(lua_State* L) {
+    (void)L;
+    perf_attach();
+    window_reset(&g_perf.query);
+    return 0;
+}
+
+// lv.perf_subscribe(callback, frames) - call callback(stats) every N rendered frames, nil unsubscribes
+// The stats carry no heap fields, use lv.perf_stats() or lv.resource_stats() for those
+static int l_lv_perf_subscribe(lua_State* L) {
+    if (g_perf.sub_ref != LUA_NOREF) {
+        luaL_unref(g_perf.sub_L, LUA_REGISTRYINDEX, g_perf.sub_ref);
+        g_perf.sub_ref = LUA_NOREF;
+    }
+    if (lua_isnoneornil(L, 1)) return 0;
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    lua_Integer every = luaL_optinteger(L, 2, 60);
+    luaL_argcheck(L, every > 0, 2, "frame count must be positive");
+
+    perf_attach();
+    lua_pushvalue(L, 1);
+    g_perf.sub_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    g_perf.sub_L = lvgl_lua_main_thread(L);
+    g_perf.sub_every = (uint32_t)every;
+    window_reset(&g_perf.sub);
+    return 0;
+}
+
+void lvgl_perf_release_state(lua_State* L) {
+    if (g_perf.sub_ref != LUA_NOREF && g_perf.sub_L == L) {
+        luaL_unref(L, LUA_REGISTRYINDEX, g_perf.sub_ref);
+        g_perf.sub_ref = LUA_NOREF;
+        g_perf.sub_L = NULL;
+    }
+}
+
+// Count an object and all of its descendants
+static uint32_t count_objects(lv_obj_t* obj) {
+    uint32_t count = 1;
+    uint32_t children = lv_obj_get_child_count(obj);
+    for (uint32_t i = 0; i < children; i++) {
+        count += count_objects(lv_obj_get_child(obj, (int32_t)i));
+    }
+    return count;
+}
+
+// lv.resource_stats() - live objects (all screens and layers), timers, Lua registry references and heap
+static int l_lv_resource_stats(lua_State* L) {
+    lua_Integer objects = 0;
+    lua_Integer screens = 0;
+    for (lv_display_t* disp = lv_display_get_next(NULL); disp; disp = lv_display_get_next(disp)) {
+        for (uint32_t i = 0; i < disp->screen_cnt; i++) {
+            objects += count_objects(disp->screens[i]);
+            screens++;
+        }
+    }
+
+    lua_Integer timers = 0;
+    for (lv_timer_t* t = lv_timer_get_next(NULL); t; t = lv_timer_get_next(t)) {
+        timers++;
+    }
+
+    // Released luaL_ref slots hold the free list as integers, only count live references
+    lua_Integer registry = 0;
+    lua_pushnil(L);
+    while (lua_next(L, LUA_REGISTRYINDEX)) {
+        if (lua_type(L, -1) != LUA_TNUMBER) registry++;
+        lua_pop(L, 1);
+    }
+
+    lv_mem_monitor_t mon;
+    lua_createtable(L, 0, 6);
+    set_int_field(L, "objects", objects);
+    set_int_field(L, "screens", screens);
+    set_int_field(L, "timers", timers);
+    set_int_field(L, "registry", registry);
+    lua_pushnumber(L, (lua_Number)lua_gc(L, LUA_GCCOUNT) + (lua_Number)lua_gc(L, LUA_GCCOUNTB) / 1024.0);
+    lua_setfield(L, -2, "lua_kb");
+    if (heap_monitor(&mon)) {
+        set_int_field(L, "heap_used", (lua_Integer)(mon.total_size - mon.free_size));
+    }
+    return 1;
+}
+
+static const luaL_Reg lv_perf_funcs[] = {
+    {"perf_stats", l_lv_perf_stats},
+    {"perf_stats_reset", l_lv_perf_stats_reset},
+    {"perf_subscribe", l_lv_perf_subscribe},
+    {"resource_stats", l_lv_resource_stats},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_perf_funcs(void) {
+    return lv_perf_funcs;
+}
@@ -0,0 +1,274 @@
+﻿/**
+ * @file lvgl_preview_lua_bindings.c
+ * @brief In-process preview - run a compiled project in a second Lua state on its own display
+ * 编辑器内预览：在同一进程中创建第二个 lua_State 和显示运行编译后的工程，
+ * 与编辑器共用 LVGL、已加载的 TTF 字体和图片缓存，省去启动仿真器进程、加载字体和复制脚本的时间。
+ * 预览状态的回调运行期间默认显示切换为预览显示，lv.scr_act() 等返回预览的屏幕。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+
+// Default preview size (same as VduSimulator)
+#define PREVIEW_DEFAULT_WIDTH 1024
+#define PREVIEW_DEFAULT_HEIGHT 768
+
+typedef struct lua_preview_s {
+    struct lua_preview_s* next;
+    lua_State* L;           // preview state, NULL once stopped
+    lv_display_t* disp;     // NULL once deleted
+    int release_pending;    // display was deleted from outside, state is released asynchronously
+} lua_preview_t;
+
+static lua_preview_t* g_previews;
+
+static lv_display_t* (*g_create_display)(int32_t width, int32_t height);
+static void (*g_destroy_display)(lv_display_t* disp);
+
+void lvgl_preview_set_display_factory(lv_display_t* (*create)(int32_t width, int32_t height),
+                                      void (*destroy)(lv_display_t* disp)) {
+    g_create_display = create;
+    g_destroy_display = destroy;
+}
+
+lv_display_t* lvgl_preview_display_for(lua_State* L) {
+    for (lua_preview_t* p = g_previews; p; p = p->next) {
+        if (p->L == L) return p->disp;
+    }
+    return NULL;
+}
+
+static void preview_unlink(lua_preview_t* p) {
+    for (lua_preview_t** pp = &g_previews; *pp; pp = &(*pp)->next) {
+        if (*pp == p) {
+            *pp = p->next;
+            break;
+        }
+    }
+    p->next = NULL;
+}
+
+static void preview_display_delete_cb(lv_event_t* e);
+
+// Stop the preview while the state is still open: objects are deleted first (their Lua delete
+// handlers may delete timers), then the remaining timers, watches and workers of the state
+static void preview_release(lua_preview_t* p) {
+    lua_State* L = p->L;
+    lv_display_t* disp = p->disp;
+    if (!L) return;
+    preview_unlink(p);
+    if (disp) {
+        p->disp = NULL;
+        lv_display_remove_event_cb_with_user_data(disp, preview_display_delete_cb, p);
+        lv_obj_clean(lv_display_get_screen_active(disp));
+        lv_obj_clean(lv_display_get_layer_top(disp));
+        lv_obj_clean(lv_display_get_layer_sys(disp));
+        lv_obj_clean(lv_display_get_layer_bottom(disp));
+    }
+    lvgl_lua_release_state(L);
+    if (disp) {
+        if (g_destroy_display) g_destroy_display(disp);
+        else lv_display_delete(disp);
+    }
+    p->L = NULL;
+    lua_close(L);
+}
+
+static void preview_async_release(void* user_data) {
+    lua_preview_t* p = (lua_preview_t*)user_data;
+    p->release_pending = 0;
+    preview_release(p);
+}
+
+// The display was deleted from outside (preview window closed)
+static void preview_display_delete_cb(lv_event_t* e) {
+    lua_preview_t* p = (lua_preview_t*)lv_event_get_user_data(e);
+    p->disp = NULL;
+    if (p->L && !p->release_pending) {
+        p->release_pending = 1;
+        lv_async_call(preview_async_release, p);
+    }
+}
+
+// Copy a string field of package (path, cpath) from one state to another
+static void copy_package_field(lua_State* from, lua_State* to, const char* field) {
+    lua_getglobal(from, "package");
+    lua_getglobal(to, "package");
+    if (lua_istable(from, -1) && lua_istable(to, -1)) {
+        lua_getfield(from, -1, field);
+        if (lua_isstring(from, -1)) {
+            lua_pushstring(to, lua_tostring(from, -1));
+            lua_setfield(to, -2, field);
+        }
+        lua_pop(from, 1);
+    }
+    lua_pop(from, 1);
+    lua_pop(to, 1);
+}
+
+// Run the chunk on top of P with the preview display as default, returns the status
+static int preview_call(lua_preview_t* p, int nargs) {
+    lv_display_t* old_disp = lv_display_get_default();
+    lv_display_set_default(p->disp);
+    int status = lua_pcall(p->L, nargs, 0, 0);
+    lv_display_set_default(old_disp);
+    return status;
+}
+
+static lua_preview_t* check_preview(lua_State* L, int idx) {
+    lua_preview_t** ud = (lua_preview_t**)luaL_checkudata(L, idx, "lv_preview");
+    return *ud;
+}
+
+// lv.preview_start(script_path [, width, height]) - run a script in a new Lua state on its own display,
+// the script receives its path as argument (like VduSimulator); returns the preview or nil and an error
+static int l_lv_preview_start(lua_State* L) {
+    const char* path = luaL_checkstring(L, 1);
+    int32_t width = (int32_t)luaL_optinteger(L, 2, PREVIEW_DEFAULT_WIDTH);
+    int32_t height = (int32_t)luaL_optinteger(L, 3, PREVIEW_DEFAULT_HEIGHT);
+
+    lua_preview_t* p = (lua_preview_t*)calloc(1, sizeof(lua_preview_t));
+    if (!p) return luaL_error(L, "not enough memory");
+    lua_preview_t** ud = (lua_preview_t**)lua_newuserdata(L, sizeof(lua_preview_t*));
+    *ud = p;
+    luaL_setmetatable(L, "lv_preview");
+
+    p->disp = g_create_display ? g_create_display(width, height) : lvgl_headless_create_display(width, height);
+    if (!p->disp) {
+        lua_pushnil(L);
+        lua_pushstring(L, "cannot create preview display");
+        return 2;
+    }
+    p->L = luaL_newstate();
+    if (!p->L) {
+        if (g_destroy_display) g_destroy_display(p->disp);
+        else lv_display_delete(p->disp);
+        p->disp = NULL;
+        return luaL_error(L, "not enough memory");
+    }
+
+    // Same libraries, module path and APP_DIR as the calling state
+    luaL_openlibs(p->L);
+    copy_package_field(L, p->L, "path");
+    copy_package_field(L, p->L, "cpath");
+    lua_getglobal(L, "APP_DIR");
+    if (lua_isstring(L, -1)) {
+        lua_pushstring(p->L, lua_tostring(L, -1));
+        lua_setglobal(p->L, "APP_DIR");
+    }
+    lua_pop(L, 1);
+    lua_pushboolean(p->L, 1);
+    lua_setglobal(p->L, "VDU_PREVIEW");
+    lvgl_lua_register(p->L);
+
+    // The TTF font is already loaded by the host
+    lv_font_t* font = get_current_ttf_font();
+    if (font) lv_obj_set_style_text_font(lv_display_get_screen_active(p->disp), font, 0);
+
+    p->next = g_previews;
+    g_previews = p;
+    lv_display_add_event_cb(p->disp, preview_display_delete_cb, LV_EVENT_DELETE, p);
+
+    int status = luaL_loadfile(p->L, path);
+    if (status == LUA_OK) {
+        lua_pushstring(p->L, path);
+        status = preview_call(p, 1);
+    }
+    if (status != LUA_OK) {
+        const char* err = lua_tostring(p->L, -1);
+        lua_pushnil(L);
+        lua_pushstring(L, err ? err : "unknown error");
+        preview_release(p);
+        return 2;
+    }
+    return 1;
+}
+
+// preview:stop()
+static int l_preview_stop(lua_State* L) {
+    lua_preview_t* p = check_preview(L, 1);
+    if (p) preview_release(p);
+    return 0;
+}
+
+// preview:is_running()
+static int l_preview_is_running(lua_State* L) {
+    lua_preview_t* p = check_preview(L, 1);
+    lua_pushboolean(L, p && p->L && p->disp);
+    return 1;
+}
+
+// preview:run(source) - run a chunk in the preview state, returns true or false and the error
+static int l_preview_run(lua_State* L) {
+    lua_preview_t* p = check_preview(L, 1);
+    size_t len = 0;
+    const char* source = luaL_checklstring(L, 2, &len);
+    if (!p || !p->L || !p->disp) return luaL_error(L, "preview is not running");
+
+    int top = lua_gettop(p->L);
+    int status = luaL_loadbufferx(p->L, source, len, "=preview", "t");
+    if (status == LUA_OK) status = preview_call(p, 0);
+    if (status != LUA_OK) {
+        const char* err = lua_tostring(p->L, -1);
+        lua_pushboolean(L, 0);
+        lua_pushstring(L, err ? err : "unknown error");
+        lua_settop(p->L, top);
+        return 2;
+    }
+    lua_settop(p->L, top);
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// preview:save_frame(path) - headless previews only
+static int l_preview_save_frame(lua_State* L) {
+    lua_preview_t* p = check_preview(L, 1);
+    const char* path = luaL_checkstring(L, 2);
+    lua_pushboolean(L, p && p->disp && lvgl_headless_save_frame(p->disp, path));
+    return 1;
+}
+
+// __gc
+static int l_preview_gc(lua_State* L) {
+    lua_preview_t** ud = (lua_preview_t**)luaL_checkudata(L, 1, "lv_preview");
+    lua_preview_t* p = *ud;
+    if (p) {
+        if (p->release_pending) lv_async_call_cancel(preview_async_release, p);
+        preview_release(p);
+        free(p);
+        *ud = NULL;
+    }
+    return 0;
+}
+
+// Preview methods table
+static const luaL_Reg lv_preview_methods[] = {
+    {"stop", l_preview_stop},
+    {"is_running", l_preview_is_running},
+    {"run", l_preview_run},
+    {"save_frame", l_preview_save_frame},
+    {NULL, NULL}
+};
+
+// Preview metamethods table
+static const luaL_Reg lv_preview_metamethods[] = {
+    {"__gc", l_preview_gc},
+    {NULL, NULL}
+};
+
+// Preview module functions
+static const luaL_Reg lv_preview_funcs[] = {
+    {"preview_start", l_lv_preview_start},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_preview_funcs(void) {
+    return lv_preview_funcs;
+}
+
+const luaL_Reg* lvgl_get_preview_methods(void) {
+    return lv_preview_methods;
+}
+
+const luaL_Reg* lvgl_get_preview_metamethods(void) {
+    return lv_preview_metamethods;
+}
@@ -0,0 +1,292 @@
+﻿/**
+ * @file lvgl_profiler_lua_bindings.c
+ * @brief Sampling profiler for Lua scripts - collapsed stack (flamegraph) output
+ * 采样分析器：采样线程按固定频率异步安装 lua_sethook，钩子在下一条指令
+ * （或当前 C 绑定函数返回时）记录调用栈，按栈聚合计数，输出 collapsed 格式。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+#include "lvgl/src/osal/lv_os_private.h"
+
+// Default and maximum sampling rate
+#define PROFILER_DEFAULT_HZ 250
+#define PROFILER_MAX_HZ 1000
+
+// Deepest stack recorded per sample
+#define PROFILER_MAX_DEPTH 64
+
+// Size of the collapsed stack key buffer
+#define PROFILER_KEY_SIZE 4096
+
+// Number of hash buckets for the stack table
+#define PROFILER_HASH_SIZE 1024
+
+// Root frames
+#define PROFILER_LUA_ROOT "[lua]"
+#define PROFILER_NATIVE_ROOT "[lvgl]"
+
+// Aggregated stack
+typedef struct profiler_stack_s {
+    struct profiler_stack_s* next;
+    uint32_t hash;
+    uint64_t count;
+    char key[1];
+} profiler_stack_t;
+
+static struct {
+    lua_State* L;
+    volatile int running;
+    volatile int pending;           // a sample is armed in the hook
+    uint32_t period_ms;
+    uint64_t native_samples;        // samples taken while no Lua callback was running
+    uint64_t lua_samples;
+    uint64_t dropped;
+    profiler_stack_t* table[PROFILER_HASH_SIZE];
+#if LV_USE_OS != LV_OS_NONE
+    lv_thread_t thread;
+    lv_thread_sync_t exited;
+#endif
+} g_prof;
+
+// ========== Stack aggregation (UI thread) ==========
+
+static uint32_t hash_string(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void profiler_count(const char* key) {
+    uint32_t h = hash_string(key);
+    profiler_stack_t** slot = &g_prof.table[h % PROFILER_HASH_SIZE];
+    for (profiler_stack_t* s = *slot; s; s = s->next) {
+        if (s->hash == h && strcmp(s->key, key) == 0) {
+            s->count++;
+            return;
+        }
+    }
+    size_t len = strlen(key);
+    profiler_stack_t* s = (profiler_stack_t*)malloc(sizeof(profiler_stack_t) + len);
+    if (!s) {
+        g_prof.dropped++;
+        return;
+    }
+    s->hash = h;
+    s->count = 1;
+    memcpy(s->key, key, len + 1);
+    s->next = *slot;
+    *slot = s;
+}
+
+static void profiler_clear(void) {
+    for (int i = 0; i < PROFILER_HASH_SIZE; i++) {
+        profiler_stack_t* s = g_prof.table[i];
+        while (s) {
+            profiler_stack_t* next = s->next;
+            free(s);
+            s = next;
+        }
+        g_prof.table[i] = NULL;
+    }
+    g_prof.native_samples = 0;
+    g_prof.lua_samples = 0;
+    g_prof.dropped = 0;
+}
+
+// Append a frame name, ';' and spaces separate frames and counts in the output format
+static size_t append_frame(char* buf, size_t pos, const char* text) {
+    if (pos + 1 < PROFILER_KEY_SIZE) buf[pos++] = ';';
+    for (; *text && pos + 1 < PROFILER_KEY_SIZE; text++) {
+        buf[pos++] = (*text == ';' || *text == '\n') ? ':' : *text;
+    }
+    buf[pos] = '\0';
+    return pos;
+}
+
+// Record the current Lua stack, leaf first on the stack so walk it backwards
+static void profiler_record(lua_State* L) {
+    lua_Debug frames[PROFILER_MAX_DEPTH];
+    char key[PROFILER_KEY_SIZE];
+    char name[256];
+    int depth = 0;
+
+    while (depth < PROFILER_MAX_DEPTH && lua_getstack(L, depth, &frames[depth])) {
+        lua_getinfo(L, "Sn", &frames[depth]);
+        depth++;
+    }
+
+    size_t pos = (size_t)snprintf(key, sizeof(key), "%s", PROFILER_LUA_ROOT);
+    for (int i = depth - 1; i >= 0; i--) {
+        const lua_Debug* ar = &frames[i];
+        if (ar->what[0] == 'C') {
+            snprintf(name, sizeof(name), "%s [C]", ar->name ? ar->name : "?");
+        } else if (ar->what[0] == 'm') {
+            snprintf(name, sizeof(name), "main (%s)", ar->short_src);
+        } else {
+            snprintf(name, sizeof(name), "%s (%s:%d)", ar->name ? ar->name : "?", ar->short_src, ar->linedefined);
+        }
+        pos = append_frame(key, pos, name);
+    }
+    profiler_count(key);
+    g_prof.lua_samples++;
+}
+
+int lvgl_profiler_take_sample(lua_State* L) {
+    if (!g_prof.pending || L != g_prof.L) return 0;
+    g_prof.pending = 0;
+    profiler_record(L);
+    return 1;
+}
+
+// Armed asynchronously by the sampler thread
+static void profiler_hook(lua_State* L, lua_Debug* ar) {
+    (void)ar;
+    lvgl_profiler_take_sample(L);
+    // Hand the hook back to the callback budget watchdog (or remove it)
+    lvgl_callback_restore_hook(L);
+}
+
+#if LV_USE_OS != LV_OS_NONE
+
+// ========== Sampler thread ==========
+
+static void sampler_thread_main(void* user_data) {
+    (void)user_data;
+    while (g_prof.running) {
+        lv_sleep_ms(g_prof.period_ms);
+        if (!g_prof.running) break;
+        if (lvgl_lua_callback_depth() == 0) {
+            // UI thread is rendering, inside LVGL or idle
+            g_prof.pending = 0;
+            g_prof.native_samples++;
+        } else if (!g_prof.pending) {
+            g_prof.pending = 1;
+            lua_sethook(g_prof.L, profiler_hook, LUA_MASKCOUNT | LUA_MASKRET, 1);
+        }
+    }
+    lv_thread_sync_signal(&g_prof.exited);
+}
+
+// lv.profiler_start([hz]) - start sampling the calling Lua state
+static int l_lv_profiler_start(lua_State* L) {
+    lua_Integer hz = luaL_optinteger(L, 1, PROFILER_DEFAULT_HZ);
+    if (g_prof.running) return luaL_error(L, "profiler is already running");
+    if (hz < 1) hz = 1;
+    if (hz > PROFILER_MAX_HZ) hz = PROFILER_MAX_HZ;
+
+    profiler_clear();
+    g_prof.L = lvgl_lua_main_thread(L);
+    g_prof.period_ms = (uint32_t)(1000 / hz);
+    g_prof.pending = 0;
+    g_prof.running = 1;
+
+    if (lv_thread_sync_init(&g_prof.exited) != LV_RESULT_OK) {
+        g_prof.running = 0;
+        return luaL_error(L, "cannot start profiler thread");
+    }
+    if (lv_thread_init(&g_prof.thread, "lua_profiler", LV_THREAD_PRIO_HIGHEST, sampler_thread_main,
+                       32 * 1024, NULL) != LV_RESULT_OK) {
+        g_prof.running = 0;
+        lv_thread_sync_delete(&g_prof.exited);
+        return luaL_error(L, "cannot start profiler thread");
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static void profiler_join(void) {
+    g_prof.running = 0;
+    lv_thread_sync_wait(&g_prof.exited);
+    lv_thread_delete(&g_prof.thread);
+    lv_thread_sync_delete(&g_prof.exited);
+    g_prof.pending = 0;
+}
+
+#else
+
+static int l_lv_profiler_start(lua_State* L) {
+    return luaL_error(L, "lv.profiler_start requires LV_USE_OS");
+}
+
+static void profiler_join(void) {
+}
+
+#endif // LV_USE_OS != LV_OS_NONE
+
+// Write all stacks as "frame;frame;frame count" lines
+static void profiler_write(luaL_Buffer* b) {
+    char line[64];
+    for (int i = 0; i < PROFILER_HASH_SIZE; i++) {
+        for (profiler_stack_t* s = g_prof.table[i]; s; s = s->next) {
+            luaL_addstring(b, s->key);
+            snprintf(line, sizeof(line), " %llu\n", (unsigned long long)s->count);
+            luaL_addstring(b, line);
+        }
+    }
+    if (g_prof.native_samples) {
+        snprintf(line, sizeof(line), "%s %llu\n", PROFILER_NATIVE_ROOT, (unsigned long long)g_prof.native_samples);
+        luaL_addstring(b, line);
+    }
+}
+
+// lv.profiler_stop([path]) - stop sampling; writes collapsed stacks to path or returns them as a string
+static int l_lv_profiler_stop(lua_State* L) {
+    const char* path = luaL_optstring(L, 1, NULL);
+    if (!g_prof.running) return luaL_error(L, "profiler is not running");
+    profiler_join();
+    lvgl_callback_restore_hook(g_prof.L);
+
+    luaL_Buffer b;
+    luaL_buffinit(L, &b);
+    profiler_write(&b);
+    luaL_pushresult(&b);
+
+    uint64_t total = g_prof.lua_samples + g_prof.native_samples;
+    if (g_prof.dropped) {
+        printf("Lua profiler: %llu samples dropped (out of memory)\n", (unsigned long long)g_prof.dropped);
+    }
+    profiler_clear();
+
+    if (!path) return 1;
+
+    FILE* f = lvgl_lua_fopen(path, "wb");
+    if (!f) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "cannot open %s", path);
+        return 2;
+    }
+    size_t len = 0;
+    const char* text = lua_tolstring(L, -1, &len);
+    fwrite(text, 1, len, f);
+    fclose(f);
+    lua_pushinteger(L, (lua_Integer)total);
+    return 1;
+}
+
+void lvgl_profiler_release_state(lua_State* L) {
+    if (!g_prof.running || g_prof.L != L) return;
+    profiler_join();
+    lvgl_callback_restore_hook(L);
+    profiler_clear();
+    g_prof.L = NULL;
+}
+
+// lv.profiler_is_running()
+static int l_lv_profiler_is_running(lua_State* L) {
+    lua_pushboolean(L, g_prof.running);
+    return 1;
+}
+
+static const luaL_Reg lv_profiler_funcs[] = {
+    {"profiler_start", l_lv_profiler_start},
+    {"profiler_stop", l_lv_profiler_stop},
+    {"profiler_is_running", l_lv_profiler_is_running},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_profiler_funcs(void) {
+    return lv_profiler_funcs;
+}
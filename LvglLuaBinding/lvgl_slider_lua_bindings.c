@@ -24,8 +24,15 @@ static int l_slider_get_value(lua_State* L) {
 }
 
 // slider:set_range(min, max)
+// Shares the merged lv_obj method table with chart:set_range(axis, min, max),
+// lv_slider_set_range on a chart would overwrite its fields
 static int l_slider_set_range(lua_State* L) {
     lv_obj_t* obj = check_lv_obj(L, 1);
+    if (obj && lv_obj_check_type(obj, &lv_chart_class)) {
+        lv_chart_axis_t axis = (lv_chart_axis_t)luaL_checkinteger(L, 2);
+        lv_chart_set_axis_range(obj, axis, (int32_t)luaL_checkinteger(L, 3), (int32_t)luaL_checkinteger(L, 4));
+        return 0;
+    }
     int32_t min = (int32_t)luaL_checkinteger(L, 2);
     int32_t max = (int32_t)luaL_checkinteger(L, 3);
     if (obj) lv_slider_set_range(obj, min, max);
@@ -0,0 +1,36 @@
+﻿/**
+ * @file lvgl_trace.h
+ * @brief Timeline tracer - LVGL profiler port (LV_PROFILER_INCLUDE)
+ * 时间线追踪：LVGL 内部的 LV_PROFILER_* 宏与 Lua 回调都写入每线程的环形缓冲区，
+ * 由 lv.trace_dump() 导出为 Chrome trace JSON（chrome://tracing / Perfetto）。
+ */
+#ifndef LVGL_TRACE_H
+#define LVGL_TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Non-zero while tracing, checked before every write
+extern volatile int lvgl_trace_enabled;
+
+// Record a 'B' (begin) or 'E' (end) event on the calling thread.
+// name, cat and detail must be static strings (they are stored by pointer).
+void lvgl_trace_write(const char* name, const char* cat, char phase, const void* target, const char* detail);
+
+// Record an async 'b' (begin) or 'e' (end) event with an explicit timestamp (lvgl_lua_time_us).
+// Spans with the same cat, name and id are paired, they may start and end on different threads.
+void lvgl_trace_write_async(const char* name, const char* cat, char phase, uint64_t id, uint64_t ts);
+
+#define LVGL_TRACE_BEGIN_TAG(tag) \
+    do { if (lvgl_trace_enabled) lvgl_trace_write((tag), "lvgl", 'B', 0, 0); } while (0)
+#define LVGL_TRACE_END_TAG(tag) \
+    do { if (lvgl_trace_enabled) lvgl_trace_write((tag), "lvgl", 'E', 0, 0); } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LVGL_TRACE_H
@@ -0,0 +1,284 @@
+﻿/**
+ * @file lvgl_trace_lua_bindings.c
+ * @brief Timeline tracer - per-thread event buffers and Chrome trace JSON output
+ * 时间线追踪：每个线程首次写入时分配自己的环形缓冲区，写入路径无锁；
+ * 缓冲区满后覆盖最旧的事件，因此长时间运行时始终保留最近的一段时间线。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+#include "lvgl_trace.h"
+#include "lvgl/src/osal/lv_os_private.h"
+
+// Events kept per thread, must be a power of two
+#define TRACE_EVENTS_PER_THREAD (64 * 1024)
+
+#if defined(_MSC_VER)
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct {
+    uint64_t ts;
+    const char* name;
+    const char* cat;
+    const char* detail;
+    const void* target;
+    uint64_t id;                    // async events only
+    char phase;
+} trace_event_t;
+
+// Buffer owned by one thread, only that thread writes to it
+typedef struct trace_thread_s {
+    struct trace_thread_s* next;
+    uint32_t tid;
+    volatile uint32_t epoch;        // trace session the events belong to
+    volatile uint32_t head;         // total events written in this session
+    trace_event_t events[TRACE_EVENTS_PER_THREAD];
+} trace_thread_t;
+
+volatile int lvgl_trace_enabled = 0;
+
+static struct {
+    trace_thread_t* threads;        // all buffers ever allocated, never freed
+    trace_thread_t* ui_thread;      // buffer of the thread that called trace_start
+    uint32_t next_tid;
+    volatile uint32_t epoch;
+    uint64_t start_us;
+#if LV_USE_OS != LV_OS_NONE
+    lv_mutex_t lock;                // serializes adding to the thread list
+    int lock_inited;
+#endif
+} g_trace;
+
+static TRACE_THREAD_LOCAL trace_thread_t* t_trace;
+
+// Allocate the calling thread's buffer, or start a new session in it
+static trace_thread_t* trace_attach(void) {
+    trace_thread_t* t = t_trace;
+    if (t) {
+        t->head = 0;
+        t->epoch = g_trace.epoch;
+        return t;
+    }
+    t = (trace_thread_t*)malloc(sizeof(trace_thread_t));
+    if (!t) return NULL;
+    t->head = 0;
+    t->epoch = g_trace.epoch;
+#if LV_USE_OS != LV_OS_NONE
+    lv_mutex_lock(&g_trace.lock);
+#endif
+    t->tid = ++g_trace.next_tid;
+    t->next = g_trace.threads;
+    g_trace.threads = t;
+#if LV_USE_OS != LV_OS_NONE
+    lv_mutex_unlock(&g_trace.lock);
+#endif
+    t_trace = t;
+    return t;
+}
+
+static void trace_push(uint64_t ts, const char* name, const char* cat, char phase, const void* target,
+                       const char* detail, uint64_t id) {
+    trace_thread_t* t = t_trace;
+    if (!t || t->epoch != g_trace.epoch) {
+        t = trace_attach();
+        if (!t) return;
+    }
+    uint32_t h = t->head;
+    trace_event_t* ev = &t->events[h & (TRACE_EVENTS_PER_THREAD - 1)];
+    ev->ts = ts;
+    ev->name = name;
+    ev->cat = cat;
+    ev->detail = detail;
+    ev->target = target;
+    ev->id = id;
+    ev->phase = phase;
+    t->head = h + 1;
+}
+
+void lvgl_trace_write(const char* name, const char* cat, char phase, const void* target, const char* detail) {
+    if (!lvgl_trace_enabled) return;
+    trace_push(lvgl_lua_time_us(), name, cat, phase, target, detail, 0);
+}
+
+void lvgl_trace_write_async(const char* name, const char* cat, char phase, uint64_t id, uint64_t ts) {
+    if (!lvgl_trace_enabled) return;
+    trace_push(ts, name, cat, phase, NULL, NULL, id);
+}
+
+// ========== JSON output ==========
+
+static void add_json_string(luaL_Buffer* b, const char* s) {
+    luaL_addchar(b, '"');
+    for (; s && *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            luaL_addchar(b, '\\');
+            luaL_addchar(b, (char)c);
+        } else if (c < 0x20) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            luaL_addstring(b, esc);
+        } else {
+            luaL_addchar(b, (char)c);
+        }
+    }
+    luaL_addchar(b, '"');
+}
+
+static void add_event(luaL_Buffer* b, const trace_event_t* ev, uint32_t tid, int* first) {
+    char num[96];
+    if (!*first) luaL_addstring(b, ",\n");
+    *first = 0;
+    luaL_addstring(b, "{\"name\":");
+    add_json_string(b, ev->name ? ev->name : "?");
+    luaL_addstring(b, ",\"cat\":");
+    add_json_string(b, ev->cat ? ev->cat : "lvgl");
+    uint64_t ts = ev->ts > g_trace.start_us ? ev->ts - g_trace.start_us : 0;
+    snprintf(num, sizeof(num), ",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%u",
+             ev->phase, (unsigned long long)ts, (unsigned)tid);
+    luaL_addstring(b, num);
+    if (ev->phase == 'b' || ev->phase == 'e') {
+        snprintf(num, sizeof(num), ",\"id\":\"0x%llx\"", (unsigned long long)ev->id);
+        luaL_addstring(b, num);
+    }
+    if (ev->phase == 'B' && (ev->target || ev->detail)) {
+        luaL_addstring(b, ",\"args\":{");
+        if (ev->target) {
+            snprintf(num, sizeof(num), "\"target\":\"%p\"", ev->target);
+            luaL_addstring(b, num);
+            if (ev->detail) luaL_addchar(b, ',');
+        }
+        if (ev->detail) {
+            luaL_addstring(b, "\"detail\":");
+            add_json_string(b, ev->detail);
+        }
+        luaL_addchar(b, '}');
+    }
+    luaL_addchar(b, '}');
+}
+
+static void add_thread_name(luaL_Buffer* b, uint32_t tid, const char* name, int* first) {
+    char line[160];
+    if (!*first) luaL_addstring(b, ",\n");
+    *first = 0;
+    snprintf(line, sizeof(line),
+             "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+             (unsigned)tid, name);
+    luaL_addstring(b, line);
+}
+
+// Append one thread's events, oldest first. Returns the number of overwritten events.
+static uint64_t add_thread_events(luaL_Buffer* b, trace_thread_t* t, int* first) {
+    if (t->epoch != g_trace.epoch) return 0;
+    uint32_t head = t->head;
+    uint32_t start = head > TRACE_EVENTS_PER_THREAD ? head - TRACE_EVENTS_PER_THREAD : 0;
+    uint32_t count = head - start;
+    if (count == 0) return 0;
+
+    trace_event_t* copy = (trace_event_t*)malloc(count * sizeof(trace_event_t));
+    if (!copy) return 0;
+    for (uint32_t i = 0; i < count; i++) {
+        copy[i] = t->events[(start + i) & (TRACE_EVENTS_PER_THREAD - 1)];
+    }
+    // Events the writer overwrote while they were copied are skipped
+    uint32_t head_after = t->head;
+    uint32_t skip = 0;
+    if (t->epoch == g_trace.epoch && head_after - start > TRACE_EVENTS_PER_THREAD) {
+        skip = head_after - start - TRACE_EVENTS_PER_THREAD;
+        if (skip > count) skip = count;
+    }
+
+    char name[32];
+    if (t == g_trace.ui_thread) {
+        add_thread_name(b, t->tid, "LVGL", first);
+    } else {
+        snprintf(name, sizeof(name), "thread %u", (unsigned)t->tid);
+        add_thread_name(b, t->tid, name, first);
+    }
+    for (uint32_t i = skip; i < count; i++) {
+        add_event(b, &copy[i], t->tid, first);
+    }
+    free(copy);
+    return (uint64_t)start + skip;
+}
+
+// ========== Lua API ==========
+
+// lv.trace_start() - start a new trace session, previous events are discarded
+static int l_lv_trace_start(lua_State* L) {
+    (void)L;
+#if LV_USE_OS != LV_OS_NONE
+    if (!g_trace.lock_inited) {
+        lv_mutex_init(&g_trace.lock);
+        g_trace.lock_inited = 1;
+    }
+#endif
+    lvgl_trace_enabled = 0;
+    g_trace.epoch++;
+    g_trace.start_us = lvgl_lua_time_us();
+    lvgl_trace_enabled = 1;
+    g_trace.ui_thread = trace_attach();
+    return 0;
+}
+
+// lv.trace_stop() - stop recording, the events stay available to trace_dump
+static int l_lv_trace_stop(lua_State* L) {
+    (void)L;
+    lvgl_trace_enabled = 0;
+    return 0;
+}
+
+// lv.trace_is_running()
+static int l_lv_trace_is_running(lua_State* L) {
+    lua_pushboolean(L, lvgl_trace_enabled);
+    return 1;
+}
+
+// lv.trace_dump([path]) - write Chrome trace JSON to path or return it as a string
+static int l_lv_trace_dump(lua_State* L) {
+    const char* path = luaL_optstring(L, 1, NULL);
+    uint64_t overwritten = 0;
+    int first = 1;
+
+    luaL_Buffer b;
+    luaL_buffinit(L, &b);
+    luaL_addstring(&b, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    // The list only ever grows at the head, so it can be walked without the lock
+    for (trace_thread_t* t = g_trace.threads; t; t = t->next) {
+        overwritten += add_thread_events(&b, t, &first);
+    }
+    luaL_addstring(&b, "\n]}\n");
+    luaL_pushresult(&b);
+
+    if (overwritten) {
+        printf("Lua trace: %llu oldest events were overwritten\n", (unsigned long long)overwritten);
+    }
+    if (!path) return 1;
+
+    FILE* f = lvgl_lua_fopen(path, "wb");
+    if (!f) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "cannot open %s", path);
+        return 2;
+    }
+    size_t len = 0;
+    const char* text = lua_tolstring(L, -1, &len);
+    fwrite(text, 1, len, f);
+    fclose(f);
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static const luaL_Reg lv_trace_funcs[] = {
+    {"trace_start", l_lv_trace_start},
+    {"trace_stop", l_lv_trace_stop},
+    {"trace_is_running", l_lv_trace_is_running},
+    {"trace_dump", l_lv_trace_dump},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_trace_funcs(void) {
+    return lv_trace_funcs;
+}
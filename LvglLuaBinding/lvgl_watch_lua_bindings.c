@@ -0,0 +1,248 @@
+﻿/**
+ * @file lvgl_watch_lua_bindings.c
+ * @brief Directory watching - change notifications polled from an lv_timer
+ * 目录监视：Linux 使用 inotify，Windows 使用 FindFirstChangeNotification，
+ * 在 UI 线程的 lv_timer 中以非阻塞方式检查，目录中有文件写入、创建、删除或改名时调用 Lua 回调。
+ * 分页编译的工程在仿真器中据此重新加载变化的图页模块。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+#include "lvgl/src/misc/lv_timer_private.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+// Default polling period
+#define WATCH_DEFAULT_PERIOD_MS 100
+
+// Size of the inotify read buffer
+#define WATCH_EVENT_BUF_SIZE 4096
+
+typedef struct {
+    lua_State* L;
+    int func_ref;
+    lvgl_cb_stats_t* stats;
+    lv_timer_t* timer;
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int fd;
+#endif
+} lua_watch_t;
+
+static void watch_close(lua_watch_t* w) {
+    if (w->timer) {
+        lv_timer_delete(w->timer);
+        w->timer = NULL;
+    }
+    if (w->func_ref != LUA_NOREF) {
+        luaL_unref(w->L, LUA_REGISTRYINDEX, w->func_ref);
+        w->func_ref = LUA_NOREF;
+    }
+#ifdef _WIN32
+    if (w->handle != INVALID_HANDLE_VALUE) {
+        FindCloseChangeNotification(w->handle);
+        w->handle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (w->fd >= 0) {
+        close(w->fd);
+        w->fd = -1;
+    }
+#endif
+}
+
+// Push the changed file names as a list; returns 0 when nothing changed.
+// Windows notifications carry no names, the list is empty then.
+static int watch_poll(lua_watch_t* w, lua_State* L) {
+#ifdef _WIN32
+    if (WaitForSingleObject(w->handle, 0) != WAIT_OBJECT_0) return 0;
+    FindNextChangeNotification(w->handle);
+    lua_newtable(L);
+    return 1;
+#elif defined(__linux__)
+    char buf[WATCH_EVENT_BUF_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int changed = 0;
+    int n = 0;
+    for (;;) {
+        ssize_t len = read(w->fd, buf, sizeof(buf));
+        if (len <= 0) break;
+        if (!changed) {
+            lua_newtable(L);   // list
+            lua_newtable(L);   // set of names already in the list
+            changed = 1;
+        }
+        for (char* p = buf; p < buf + len;) {
+            const struct inotify_event* ev = (const struct inotify_event*)p;
+            if (ev->len > 0 && ev->name[0]) {
+                if (lua_getfield(L, -1, ev->name) == LUA_TNIL) {
+                    lua_pushboolean(L, 1);
+                    lua_setfield(L, -3, ev->name);
+                    lua_pushstring(L, ev->name);
+                    lua_rawseti(L, -4, ++n);
+                }
+                lua_pop(L, 1);
+            }
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+    if (changed) lua_pop(L, 1);
+    return changed;
+#else
+    (void)w;
+    (void)L;
+    return 0;
+#endif
+}
+
+static void watch_timer_cb(lv_timer_t* timer) {
+    lua_watch_t* w = (lua_watch_t*)lv_timer_get_user_data(timer);
+    if (!w || w->func_ref == LUA_NOREF) return;
+
+    lua_State* L = w->L;
+    int top = lua_gettop(L);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, w->func_ref);
+    if (!watch_poll(w, L)) {
+        lua_settop(L, top);
+        return;
+    }
+    // The callback may close the watch, w must not be used afterwards
+    if (lvgl_lua_call_callback(L, 1, w->stats, timer, NULL) != LUA_OK) {
+        const char* err = lua_tostring(L, -1);
+        printf("Lua watch callback error: %s\n", err ? err : "unknown");
+    }
+    lua_settop(L, top);
+}
+
+void lvgl_watch_release_state(lua_State* L) {
+    lv_timer_t* timer = lv_timer_get_next(NULL);
+    while (timer) {
+        lv_timer_t* next = lv_timer_get_next(timer);
+        if (timer->timer_cb == watch_timer_cb) {
+            lua_watch_t* w = (lua_watch_t*)lv_timer_get_user_data(timer);
+            if (w && w->L == L) watch_close(w);
+        }
+        timer = next;
+    }
+}
+
+static lua_watch_t* check_watch(lua_State* L, int idx) {
+    lua_watch_t** ud = (lua_watch_t**)luaL_checkudata(L, idx, "lv_watch");
+    return *ud;
+}
+
+// lv.watch_dir(path, callback [, period_ms]) - callback(names) when files in path change,
+// watching stops on watch:close() or when the returned handle is collected
+static int l_lv_watch_dir(lua_State* L) {
+    const char* path = luaL_checkstring(L, 1);
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+    lua_Integer period = luaL_optinteger(L, 3, WATCH_DEFAULT_PERIOD_MS);
+    if (period < 1) period = 1;
+
+#ifdef _WIN32
+    wchar_t wpath[MAX_PATH];
+    if (!MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, MAX_PATH)) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "invalid path %s", path);
+        return 2;
+    }
+    HANDLE handle = FindFirstChangeNotificationW(wpath, FALSE,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    if (handle == INVALID_HANDLE_VALUE) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "cannot watch %s", path);
+        return 2;
+    }
+#elif defined(__linux__)
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || inotify_add_watch(fd, path, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE) < 0) {
+        int err = errno;
+        if (fd >= 0) close(fd);
+        lua_pushnil(L);
+        lua_pushfstring(L, "cannot watch %s: %s", path, strerror(err));
+        return 2;
+    }
+#else
+    lua_pushnil(L);
+    lua_pushstring(L, "directory watching is not supported on this platform");
+    return 2;
+#endif
+
+    lua_watch_t* w = (lua_watch_t*)calloc(1, sizeof(lua_watch_t));
+    if (!w) {
+#ifdef _WIN32
+        FindCloseChangeNotification(handle);
+#else
+        close(fd);
+#endif
+        return luaL_error(L, "not enough memory");
+    }
+    w->L = lvgl_lua_main_thread(L);
+    w->stats = lvgl_callback_stats_for(L, 2, "watch");
+#ifdef _WIN32
+    w->handle = handle;
+#else
+    w->fd = fd;
+#endif
+    lua_pushvalue(L, 2);
+    w->func_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    lua_watch_t** ud = (lua_watch_t**)lua_newuserdata(L, sizeof(lua_watch_t*));
+    *ud = w;
+    luaL_setmetatable(L, "lv_watch");
+    w->timer = lv_timer_create(watch_timer_cb, (uint32_t)period, w);
+    return 1;
+}
+
+// watch:close()
+static int l_watch_close(lua_State* L) {
+    lua_watch_t* w = check_watch(L, 1);
+    if (w) watch_close(w);
+    return 0;
+}
+
+// __gc
+static int l_watch_gc(lua_State* L) {
+    lua_watch_t** ud = (lua_watch_t**)luaL_checkudata(L, 1, "lv_watch");
+    if (*ud) {
+        watch_close(*ud);
+        free(*ud);
+        *ud = NULL;
+    }
+    return 0;
+}
+
+// Watch methods table
+static const luaL_Reg lv_watch_methods[] = {
+    {"close", l_watch_close},
+    {NULL, NULL}
+};
+
+// Watch metamethods table
+static const luaL_Reg lv_watch_metamethods[] = {
+    {"__gc", l_watch_gc},
+    {NULL, NULL}
+};
+
+// Watch module functions
+static const luaL_Reg lv_watch_funcs[] = {
+    {"watch_dir", l_lv_watch_dir},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_watch_methods(void) {
+    return lv_watch_methods;
+}
+
+const luaL_Reg* lvgl_get_watch_metamethods(void) {
+    return lv_watch_metamethods;
+}
+
+const luaL_Reg* lvgl_get_watch_funcs(void) {
+    return lv_watch_funcs;
+}
@@ -0,0 +1,919 @@
+﻿/**
+ * @file lvgl_worker_lua_bindings.c
+ * @brief Worker Lua states - run heavy Lua chunks on a thread pool
+ * 后台工作线程：每个 worker 拥有独立的 lua_State（不能访问 LVGL），
+ * 通过序列化后的消息与 UI 线程通信，消息在 UI 线程的 lv_timer 中派发。
+ */
+
+#include "lvgl_lua_bindings_internal.h"
+#include "lvgl/src/osal/lv_os_private.h"
+
+// Maximum number of pool threads (threads are created on demand)
+#ifndef LVGL_LUA_WORKER_THREADS
+#define LVGL_LUA_WORKER_THREADS 4
+#endif
+
+// Stack size of a pool thread
+#define WORKER_THREAD_STACK_SIZE (512 * 1024)
+
+// Period of the UI-side drain timer
+#define WORKER_DRAIN_PERIOD_MS 10
+
+// Maximum number of messages dispatched per drain tick (keeps frames responsive)
+#define WORKER_DRAIN_MAX_MSGS 64
+
+// Instruction count between two terminate checks inside a worker
+#define WORKER_HOOK_COUNT 1000
+
+// Maximum table nesting depth accepted by the serializer
+#define SERIALIZE_MAX_DEPTH 32
+
+// ========== Value serialization ==========
+
+// Value tags
+#define SER_NIL     'n'
+#define SER_FALSE   'f'
+#define SER_TRUE    't'
+#define SER_INT     'i'
+#define SER_NUM     'd'
+#define SER_STR     's'
+#define SER_TABLE   'T'
+#define SER_END     'E'
+
+static int buf_reserve(lvgl_lua_buf_t* buf, size_t extra) {
+    if (buf->len + extra <= buf->cap) return 1;
+    size_t cap = buf->cap ? buf->cap * 2 : 64;
+    while (cap < buf->len + extra) cap *= 2;
+    char* data = (char*)realloc(buf->data, cap);
+    if (!data) return 0;
+    buf->data = data;
+    buf->cap = cap;
+    return 1;
+}
+
+static int buf_write(lvgl_lua_buf_t* buf, const void* src, size_t len) {
+    if (!buf_reserve(buf, len)) return 0;
+    memcpy(buf->data + buf->len, src, len);
+    buf->len += len;
+    return 1;
+}
+
+static int buf_write_tag(lvgl_lua_buf_t* buf, char tag) {
+    return buf_write(buf, &tag, 1);
+}
+
+void lvgl_lua_buf_free(lvgl_lua_buf_t* buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+}
+
+// Serialize one value, on failure push an error message and return 0
+static int serialize_value(lua_State* L, int idx, lvgl_lua_buf_t* buf, int depth) {
+    idx = lua_absindex(L, idx);
+    switch (lua_type(L, idx)) {
+    case LUA_TNIL:
+        return buf_write_tag(buf, SER_NIL);
+    case LUA_TBOOLEAN:
+        return buf_write_tag(buf, lua_toboolean(L, idx) ? SER_TRUE : SER_FALSE);
+    case LUA_TNUMBER:
+        if (lua_isinteger(L, idx)) {
+            lua_Integer i = lua_tointeger(L, idx);
+            return buf_write_tag(buf, SER_INT) && buf_write(buf, &i, sizeof(i));
+        } else {
+            lua_Number n = lua_tonumber(L, idx);
+            return buf_write_tag(buf, SER_NUM) && buf_write(buf, &n, sizeof(n));
+        }
+    case LUA_TSTRING: {
+        size_t len = 0;
+        const char* s = lua_tolstring(L, idx, &len);
+        return buf_write_tag(buf, SER_STR) && buf_write(buf, &len, sizeof(len)) && buf_write(buf, s, len);
+    }
+    case LUA_TTABLE:
+        if (depth >= SERIALIZE_MAX_DEPTH) {
+            lua_pushstring(L, "table nesting too deep (cyclic table?)");
+            return 0;
+        }
+        luaL_checkstack(L, 3, "serialize");
+        if (!buf_write_tag(buf, SER_TABLE)) break;
+        lua_pushnil(L);
+        while (lua_next(L, idx) != 0) {
+            if (!serialize_value(L, -2, buf, depth + 1) || !serialize_value(L, -1, buf, depth + 1)) {
+                // Keep the error message, drop key and value
+                lua_replace(L, -3);
+                lua_pop(L, 1);
+                return 0;
+            }
+            lua_pop(L, 1);
+        }
+        return buf_write_tag(buf, SER_END);
+    default:
+        lua_pushfstring(L, "cannot send a %s value to another Lua state", luaL_typename(L, idx));
+        return 0;
+    }
+    lua_pushstring(L, "not enough memory");
+    return 0;
+}
+
+int lvgl_lua_serialize(lua_State* L, int first, int last, lvgl_lua_buf_t* buf) {
+    first = lua_absindex(L, first);
+    last = lua_absindex(L, last);
+    uint32_t count = (uint32_t)(last >= first ? last - first + 1 : 0);
+    if (!buf_write(buf, &count, sizeof(count))) {
+        lua_pushstring(L, "not enough memory");
+        return 0;
+    }
+    for (int i = first; i <= last; i++) {
+        if (!serialize_value(L, i, buf, 0)) return 0;
+    }
+    return 1;
+}
+
+// Read one value, returns a pointer past it or NULL on malformed data
+static const char* deserialize_value(lua_State* L, const char* p, const char* end) {
+    if (p >= end) return NULL;
+    luaL_checkstack(L, 3, "deserialize");
+    char tag = *p++;
+    switch (tag) {
+    case SER_NIL:   lua_pushnil(L); return p;
+    case SER_FALSE: lua_pushboolean(L, 0); return p;
+    case SER_TRUE:  lua_pushboolean(L, 1); return p;
+    case SER_INT: {
+        lua_Integer i;
+        if ((size_t)(end - p) < sizeof(i)) return NULL;
+        memcpy(&i, p, sizeof(i));
+        lua_pushinteger(L, i);
+        return p + sizeof(i);
+    }
+    case SER_NUM: {
+        lua_Number n;
+        if ((size_t)(end - p) < sizeof(n)) return NULL;
+        memcpy(&n, p, sizeof(n));
+        lua_pushnumber(L, n);
+        return p + sizeof(n);
+    }
+    case SER_STR: {
+        size_t len;
+        if ((size_t)(end - p) < sizeof(len)) return NULL;
+        memcpy(&len, p, sizeof(len));
+        p += sizeof(len);
+        if ((size_t)(end - p) < len) return NULL;
+        lua_pushlstring(L, p, len);
+        return p + len;
+    }
+    case SER_TABLE:
+        lua_newtable(L);
+        while (p < end && *p != SER_END) {
+            p = deserialize_value(L, p, end);
+            if (!p) return NULL;
+            p = deserialize_value(L, p, end);
+            if (!p) return NULL;
+            lua_rawset(L, -3);
+        }
+        return p < end ? p + 1 : NULL;
+    default:
+        return NULL;
+    }
+}
+
+int lvgl_lua_deserialize(lua_State* L, const char* data, size_t len) {
+    const char* p = data;
+    const char* end = data + len;
+    uint32_t count;
+    if (len < sizeof(count)) return 0;
+    memcpy(&count, p, sizeof(count));
+    p += sizeof(count);
+    int top = lua_gettop(L);
+    for (uint32_t i = 0; i < count; i++) {
+        p = deserialize_value(L, p, end);
+        if (!p) {
+            lua_settop(L, top);
+            return 0;
+        }
+    }
+    return (int)count;
+}
+
+#if LV_USE_OS != LV_OS_NONE
+
+// ========== Worker data structures ==========
+
+// Serialized message
+typedef struct worker_msg_s {
+    struct worker_msg_s* next;
+    size_t len;
+    // payload follows the header
+} worker_msg_t;
+
+typedef struct {
+    worker_msg_t* head;
+    worker_msg_t* tail;
+} worker_queue_t;
+
+typedef enum {
+    WORKER_PENDING = 0,
+    WORKER_RUNNING,
+    WORKER_FINISHED,
+} worker_state_t;
+
+typedef struct lua_worker_s {
+    // Shared between UI thread and pool thread (guarded by lock)
+    lv_mutex_t lock;
+    lv_thread_sync_t inbox_sync;
+    worker_queue_t inbox;       // UI -> worker
+    worker_queue_t outbox;      // worker -> UI
+    worker_state_t state;
+    worker_msg_t* result;       // serialized return values or error message
+    int failed;
+    int terminate;
+    int refs;                   // UI userdata + pool thread + drain in progress
+
+    // Read-only after creation
+    char* source;
+    size_t source_len;
+    worker_msg_t* args;
+    char* package_path;
+    char* package_cpath;
+
+    // Pool queue link
+    struct lua_worker_s* pool_next;
+
+    // UI thread only
+    struct lua_worker_s* next;
+    int in_list;
+    lua_State* L;
+    int self_ref;
+    int on_message_ref;
+    int on_error_ref;
+    int on_done_ref;
+} lua_worker_t;
+
+// Thread pool
+static struct {
+    int initialized;
+    lv_mutex_t lock;
+    lv_thread_sync_t sync;
+    lua_worker_t* head;
+    lua_worker_t* tail;
+    int idle;
+    int thread_cnt;
+    lv_thread_t threads[LVGL_LUA_WORKER_THREADS];
+} g_pool;
+
+// Live workers (UI thread only)
+static lua_worker_t* g_workers = NULL;
+static lv_timer_t* g_drain_timer = NULL;
+static uint32_t g_workers_gen = 0;
+
+// ========== Message helpers ==========
+
+static worker_msg_t* msg_from_buf(const lvgl_lua_buf_t* buf) {
+    worker_msg_t* msg = (worker_msg_t*)malloc(sizeof(worker_msg_t) + buf->len);
+    if (!msg) return NULL;
+    msg->next = NULL;
+    msg->len = buf->len;
+    if (buf->len) memcpy(msg + 1, buf->data, buf->len);
+    return msg;
+}
+
+// Serialize stack values [first, top] into a message, raises a Lua error on failure
+static worker_msg_t* msg_from_stack(lua_State* L, int first) {
+    lvgl_lua_buf_t buf = {0};
+    if (!lvgl_lua_serialize(L, first, lua_gettop(L), &buf)) {
+        lvgl_lua_buf_free(&buf);
+        lua_error(L);
+    }
+    worker_msg_t* msg = msg_from_buf(&buf);
+    lvgl_lua_buf_free(&buf);
+    if (!msg) luaL_error(L, "not enough memory");
+    return msg;
+}
+
+static int msg_push(lua_State* L, const worker_msg_t* msg) {
+    return lvgl_lua_deserialize(L, (const char*)(msg + 1), msg->len);
+}
+
+static void queue_push(worker_queue_t* q, worker_msg_t* msg) {
+    msg->next = NULL;
+    if (q->tail) q->tail->next = msg;
+    else q->head = msg;
+    q->tail = msg;
+}
+
+static worker_msg_t* queue_pop(worker_queue_t* q) {
+    worker_msg_t* msg = q->head;
+    if (msg) {
+        q->head = msg->next;
+        if (!q->head) q->tail = NULL;
+    }
+    return msg;
+}
+
+static void queue_clear(worker_queue_t* q) {
+    worker_msg_t* msg;
+    while ((msg = queue_pop(q)) != NULL) free(msg);
+}
+
+static char* dup_string(const char* s) {
+    if (!s) return NULL;
+    size_t len = strlen(s) + 1;
+    char* d = (char*)malloc(len);
+    if (d) memcpy(d, s, len);
+    return d;
+}
+
+static void worker_retain(lua_worker_t* w) {
+    lv_mutex_lock(&w->lock);
+    w->refs++;
+    lv_mutex_unlock(&w->lock);
+}
+
+// Drop one reference, the last one frees the worker
+static void worker_release(lua_worker_t* w) {
+    lv_mutex_lock(&w->lock);
+    int refs = --w->refs;
+    lv_mutex_unlock(&w->lock);
+    if (refs > 0) return;
+
+    queue_clear(&w->inbox);
+    queue_clear(&w->outbox);
+    free(w->result);
+    free(w->args);
+    free(w->source);
+    free(w->package_path);
+    free(w->package_cpath);
+    lv_thread_sync_delete(&w->inbox_sync);
+    lv_mutex_delete(&w->lock);
+    free(w);
+}
+
+// Ask the chunk to stop and wake it if it waits in receive()
+static void worker_request_terminate(lua_worker_t* w) {
+    lv_mutex_lock(&w->lock);
+    w->terminate = 1;
+    lv_mutex_unlock(&w->lock);
+    lv_thread_sync_signal(&w->inbox_sync);
+}
+
+static int worker_is_terminated(lua_worker_t* w) {
+    lv_mutex_lock(&w->lock);
+    int terminate = w->terminate;
+    lv_mutex_unlock(&w->lock);
+    return terminate;
+}
+
+// ========== Worker side (runs on a pool thread) ==========
+
+static lua_worker_t* worker_self(lua_State* L) {
+    return (lua_worker_t*)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+// Abort the chunk once terminate() was requested
+static void worker_hook(lua_State* L, lua_Debug* ar) {
+    (void)ar;
+    lua_worker_t* w = *(lua_worker_t**)lua_getextraspace(L);
+    if (w && worker_is_terminated(w)) {
+        luaL_error(L, "worker terminated");
+    }
+}
+
+// worker.post(...) - send values to the UI thread
+static int l_worker_side_post(lua_State* L) {
+    lua_worker_t* w = worker_self(L);
+    worker_msg_t* msg = msg_from_stack(L, 1);
+    lv_mutex_lock(&w->lock);
+    queue_push(&w->outbox, msg);
+    lv_mutex_unlock(&w->lock);
+    return 0;
+}
+
+// Pop one inbox message, optionally blocking until one arrives
+static int worker_side_receive(lua_State* L, int block) {
+    lua_worker_t* w = worker_self(L);
+    worker_msg_t* msg;
+    lv_mutex_lock(&w->lock);
+    while ((msg = queue_pop(&w->inbox)) == NULL && block && !w->terminate) {
+        lv_mutex_unlock(&w->lock);
+        lv_thread_sync_wait(&w->inbox_sync);
+        lv_mutex_lock(&w->lock);
+    }
+    lv_mutex_unlock(&w->lock);
+    if (!msg) return 0;
+    int n = msg_push(L, msg);
+    free(msg);
+    return n;
+}
+
+// worker.receive() - wait for a message posted by the UI thread
+static int l_worker_side_receive(lua_State* L) {
+    return worker_side_receive(L, 1);
+}
+
+// worker.try_receive() - return a pending message or nothing
+static int l_worker_side_try_receive(lua_State* L) {
+    return worker_side_receive(L, 0);
+}
+
+// worker.terminated() - true once the UI side called terminate()
+static int l_worker_side_terminated(lua_State* L) {
+    lua_pushboolean(L, worker_is_terminated(worker_self(L)));
+    return 1;
+}
+
+static const luaL_Reg worker_side_funcs[] = {
+    {"post", l_worker_side_post},
+    {"receive", l_worker_side_receive},
+    {"try_receive", l_worker_side_try_receive},
+    {"terminated", l_worker_side_terminated},
+    {NULL, NULL}
+};
+
+static void set_package_field(lua_State* L, const char* field, const char* value) {
+    if (!value) return;
+    lua_getglobal(L, "package");
+    lua_pushstring(L, value);
+    lua_setfield(L, -2, field);
+    lua_pop(L, 1);
+}
+
+// Write a single error string as a serialized message, without the Lua state
+static void buf_write_error(lvgl_lua_buf_t* buf, const char* err) {
+    uint32_t count = 1;
+    size_t len = strlen(err);
+    buf->len = 0;
+    buf_write(buf, &count, sizeof(count));
+    buf_write_tag(buf, SER_STR);
+    buf_write(buf, &len, sizeof(len));
+    buf_write(buf, err, len);
+}
+
+// Protected part of worker_serialize: (buf, values...), raises the error message on failure
+static int l_worker_serialize(lua_State* L) {
+    lvgl_lua_buf_t* buf = (lvgl_lua_buf_t*)lua_touserdata(L, 1);
+    if (!lvgl_lua_serialize(L, 2, lua_gettop(L), buf)) {
+        return lua_error(L);
+    }
+    return 0;
+}
+
+// Serialize the values from first to the top and pop them.
+// Runs in a protected call: a memory error must not panic the pool thread.
+// Returns 0 on failure with the error message on top, or nothing if there is no stack space.
+static int worker_serialize(lua_State* L, int first, lvgl_lua_buf_t* buf) {
+    int nargs = lua_gettop(L) - first + 1;
+    if (!lua_checkstack(L, 2)) {
+        lua_settop(L, 0);
+        return 0;
+    }
+    lua_pushcfunction(L, l_worker_serialize);
+    lua_insert(L, first);
+    lua_pushlightuserdata(L, buf);
+    lua_insert(L, first + 1);
+    if (lua_pcall(L, nargs + 1, 0, 0) == LUA_OK) return 1;
+    buf->len = 0;
+    return 0;
+}
+
+// Run the worker chunk and store its results
+static void worker_run(lua_worker_t* w) {
+    lvgl_lua_buf_t buf = {0};
+    int failed = 1;
+    lua_State* L = luaL_newstate();
+
+    if (!L) {
+        buf_write_error(&buf, "cannot create Lua state");
+    } else {
+        luaL_openlibs(L);
+        lvgl_clock_install_os_hooks(L);
+        set_package_field(L, "path", w->package_path);
+        set_package_field(L, "cpath", w->package_cpath);
+
+        *(lua_worker_t**)lua_getextraspace(L) = w;
+        lua_sethook(L, worker_hook, LUA_MASKCOUNT, WORKER_HOOK_COUNT);
+
+        lua_newtable(L);
+        lua_pushlightuserdata(L, w);
+        luaL_setfuncs(L, worker_side_funcs, 1);
+        lua_setglobal(L, "worker");
+
+        int status = luaL_loadbuffer(L, w->source, w->source_len, "=worker");
+        if (status == LUA_OK) {
+            int nargs = w->args ? msg_push(L, w->args) : 0;
+            status = lua_pcall(L, nargs, LUA_MULTRET, 0);
+        }
+        // Return values that cannot be sent back are reported as an error
+        if (status == LUA_OK && worker_serialize(L, 1, &buf)) {
+            failed = 0;
+        } else if (lua_gettop(L) > 0 && lua_type(L, -1) == LUA_TSTRING) {
+            lua_insert(L, 1);
+            lua_settop(L, 1);
+            if (!worker_serialize(L, 1, &buf)) buf_write_error(&buf, "not enough memory");
+        } else {
+            buf_write_error(&buf, "unknown error");
+        }
+        lua_close(L);
+    }
+
+    worker_msg_t* result = msg_from_buf(&buf);
+    lvgl_lua_buf_free(&buf);
+
+    lv_mutex_lock(&w->lock);
+    w->result = result;
+    w->failed = failed;
+    w->state = WORKER_FINISHED;
+    lv_mutex_unlock(&w->lock);
+}
+
+// Pool thread main loop
+static void worker_thread_main(void* user_data) {
+    (void)user_data;
+    while (1) {
+        lv_mutex_lock(&g_pool.lock);
+        g_pool.idle++;
+        while (!g_pool.head) {
+            lv_mutex_unlock(&g_pool.lock);
+            lv_thread_sync_wait(&g_pool.sync);
+            lv_mutex_lock(&g_pool.lock);
+        }
+        g_pool.idle--;
+        lua_worker_t* w = g_pool.head;
+        g_pool.head = w->pool_next;
+        if (!g_pool.head) g_pool.tail = NULL;
+        int more = g_pool.head != NULL;
+        lv_mutex_unlock(&g_pool.lock);
+
+        // The sync object only remembers one signal, pass it on
+        if (more) lv_thread_sync_signal(&g_pool.sync);
+
+        lv_mutex_lock(&w->lock);
+        int skip = w->terminate;
+        w->state = skip ? WORKER_FINISHED : WORKER_RUNNING;
+        lv_mutex_unlock(&w->lock);
+
+        if (!skip) worker_run(w);
+        worker_release(w);
+    }
+}
+
+static int pool_submit(lua_worker_t* w) {
+    if (!g_pool.initialized) {
+        if (lv_mutex_init(&g_pool.lock) != LV_RESULT_OK) return 0;
+        if (lv_thread_sync_init(&g_pool.sync) != LV_RESULT_OK) {
+            lv_mutex_delete(&g_pool.lock);
+            return 0;
+        }
+        g_pool.initialized = 1;
+    }
+
+    lv_mutex_lock(&g_pool.lock);
+    w->pool_next = NULL;
+    if (g_pool.tail) g_pool.tail->pool_next = w;
+    else g_pool.head = w;
+    g_pool.tail = w;
+    int need_thread = g_pool.idle == 0 && g_pool.thread_cnt < LVGL_LUA_WORKER_THREADS;
+    lv_mutex_unlock(&g_pool.lock);
+
+    if (need_thread) {
+        lv_thread_t* thread = &g_pool.threads[g_pool.thread_cnt];
+        if (lv_thread_init(thread, "lua_worker", LV_THREAD_PRIO_LOW, worker_thread_main,
+                           WORKER_THREAD_STACK_SIZE, NULL) == LV_RESULT_OK) {
+            g_pool.thread_cnt++;
+        } else if (g_pool.thread_cnt == 0) {
+            // No thread would ever pick the job up, take it back out of the queue
+            lv_mutex_lock(&g_pool.lock);
+            lua_worker_t** pp = &g_pool.head;
+            lua_worker_t* prev = NULL;
+            while (*pp && *pp != w) {
+                prev = *pp;
+                pp = &(*pp)->pool_next;
+            }
+            if (*pp) {
+                *pp = w->pool_next;
+                if (g_pool.tail == w) g_pool.tail = prev;
+            }
+            lv_mutex_unlock(&g_pool.lock);
+            return 0;
+        }
+    }
+    lv_thread_sync_signal(&g_pool.sync);
+    return 1;
+}
+
+// ========== UI side ==========
+
+static void worker_unref_handlers(lua_worker_t* w) {
+    lua_State* L = w->L;
+    luaL_unref(L, LUA_REGISTRYINDEX, w->on_message_ref);
+    luaL_unref(L, LUA_REGISTRYINDEX, w->on_error_ref);
+    luaL_unref(L, LUA_REGISTRYINDEX, w->on_done_ref);
+    luaL_unref(L, LUA_REGISTRYINDEX, w->self_ref);
+    w->on_message_ref = LUA_NOREF;
+    w->on_error_ref = LUA_NOREF;
+    w->on_done_ref = LUA_NOREF;
+    w->self_ref = LUA_NOREF;
+}
+
+static void drain_timer_cb(lv_timer_t* timer);
+
+// Remove a worker from the drain list, the timer stops with the last one
+static void worker_unlink(lua_worker_t* w) {
+    if (!w->in_list) return;
+    for (lua_worker_t** pp = &g_workers; *pp; pp = &(*pp)->next) {
+        if (*pp == w) {
+            *pp = w->next;
+            break;
+        }
+    }
+    w->in_list = 0;
+    w->next = NULL;
+    g_workers_gen++;
+    if (!g_workers && g_drain_timer) {
+        lv_timer_delete(g_drain_timer);
+        g_drain_timer = NULL;
+    }
+}
+
+// Call a handler with the values of a message
+static void worker_dispatch(lua_worker_t* w, int func_ref, const worker_msg_t* msg, const char* what) {
+    lua_State* L = w->L;
+    int top = lua_gettop(L);
+    if (func_ref == LUA_NOREF || func_ref == LUA_REFNIL) {
+        if (msg && strcmp(what, "error") == 0) {
+            msg_push(L, msg);
+            const char* err = lua_tostring(L, top + 1);
+            printf("Lua worker error: %s\n", err ? err : "unknown");
+            lua_settop(L, top);
+        }
+        return;
+    }
+    lua_rawgeti(L, LUA_REGISTRYINDEX, func_ref);
+    int nargs = msg ? msg_push(L, msg) : 0;
+    if (lua_pcall(L, nargs, 0, 0) != LUA_OK) {
+        const char* err = lua_tostring(L, -1);
+        printf("Lua worker %s callback error: %s\n", what, err ? err : "unknown");
+    }
+    lua_settop(L, top);
+}
+
+// Drain worker queues on the UI thread
+static void drain_timer_cb(lv_timer_t* timer) {
+    (void)timer;
+    int budget = WORKER_DRAIN_MAX_MSGS;
+    lua_worker_t* w = g_workers;
+    while (w && budget > 0) {
+        uint32_t gen = g_workers_gen;
+        worker_msg_t* msg = NULL;
+        int finished = 0;
+
+        // A handler may terminate the worker and let the userdata be collected, keep w alive
+        worker_retain(w);
+
+        do {
+            lv_mutex_lock(&w->lock);
+            msg = queue_pop(&w->outbox);
+            finished = w->state == WORKER_FINISHED && !w->outbox.head;
+            lv_mutex_unlock(&w->lock);
+            if (msg) {
+                worker_dispatch(w, w->on_message_ref, msg, "message");
+                free(msg);
+                budget--;
+            }
+            // A handler may have terminated the worker
+            if (!w->in_list) break;
+        } while (msg && budget > 0);
+
+        if (w->in_list && finished) {
+            lv_mutex_lock(&w->lock);
+            worker_msg_t* result = w->result;
+            w->result = NULL;
+            int failed = w->failed;
+            lv_mutex_unlock(&w->lock);
+
+            // Unlink first so handlers may post to new workers safely
+            worker_unlink(w);
+            if (result) {
+                worker_dispatch(w, failed ? w->on_error_ref : w->on_done_ref, result,
+                                failed ? "error" : "done");
+                free(result);
+            }
+            worker_unref_handlers(w);
+        }
+        // Handlers may have unlinked other workers, restart from the head then
+        lua_worker_t* next = gen == g_workers_gen ? w->next : g_workers;
+        worker_release(w);
+        w = next;
+    }
+}
+
+static lua_worker_t* check_worker(lua_State* L, int idx) {
+    lua_worker_t** ud = (lua_worker_t**)luaL_checkudata(L, idx, "lv_worker");
+    return *ud;
+}
+
+// lv.worker(source, ...) - start a Lua chunk on the worker pool
+static int l_lv_worker(lua_State* L) {
+    size_t source_len = 0;
+    const char* source = luaL_checklstring(L, 1, &source_len);
+    worker_msg_t* args = msg_from_stack(L, 2);
+
+    lua_worker_t* w = (lua_worker_t*)calloc(1, sizeof(lua_worker_t));
+    if (!w) {
+        free(args);
+        return luaL_error(L, "not enough memory");
+    }
+    w->source = (char*)malloc(source_len + 1);
+    if (!w->source) {
+        free(args);
+        free(w);
+        return luaL_error(L, "not enough memory");
+    }
+    memcpy(w->source, source, source_len + 1);
+    w->source_len = source_len;
+    w->args = args;
+    w->refs = 2;
+    w->L = lvgl_lua_main_thread(L);
+    w->on_message_ref = LUA_NOREF;
+    w->on_error_ref = LUA_NOREF;
+    w->on_done_ref = LUA_NOREF;
+
+    // Workers see the same module search path as the UI state
+    lua_getglobal(L, "package");
+    if (lua_istable(L, -1)) {
+        lua_getfield(L, -1, "path");
+        w->package_path = dup_string(lua_tostring(L, -1));
+        lua_getfield(L, -2, "cpath");
+        w->package_cpath = dup_string(lua_tostring(L, -1));
+        lua_pop(L, 2);
+    }
+    lua_pop(L, 1);
+
+    if (lv_mutex_init(&w->lock) != LV_RESULT_OK) {
+        free(w->package_path);
+        free(w->package_cpath);
+        free(w->source);
+        free(args);
+        free(w);
+        return luaL_error(L, "cannot create worker lock");
+    }
+    if (lv_thread_sync_init(&w->inbox_sync) != LV_RESULT_OK) {
+        lv_mutex_delete(&w->lock);
+        free(w->package_path);
+        free(w->package_cpath);
+        free(w->source);
+        free(args);
+        free(w);
+        return luaL_error(L, "cannot create worker sync object");
+    }
+
+    lua_worker_t** ud = (lua_worker_t**)lua_newuserdata(L, sizeof(lua_worker_t*));
+    *ud = w;
+    luaL_setmetatable(L, "lv_worker");
+
+    // Keep the userdata alive until the worker has reported back
+    lua_pushvalue(L, -1);
+    w->self_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    w->next = g_workers;
+    g_workers = w;
+    w->in_list = 1;
+    if (!g_drain_timer) {
+        g_drain_timer = lv_timer_create(drain_timer_cb, WORKER_DRAIN_PERIOD_MS, NULL);
+    }
+
+    if (!pool_submit(w)) {
+        worker_unlink(w);
+        worker_unref_handlers(w);
+        w->refs = 1;
+        return luaL_error(L, "cannot start worker thread");
+    }
+    return 1;
+}
+
+// worker:post(...) - send values to the worker chunk
+static int l_worker_post(lua_State* L) {
+    lua_worker_t* w = check_worker(L, 1);
+    worker_msg_t* msg = msg_from_stack(L, 2);
+    lv_mutex_lock(&w->lock);
+    int accept = w->state != WORKER_FINISHED && !w->terminate;
+    if (accept) queue_push(&w->inbox, msg);
+    lv_mutex_unlock(&w->lock);
+    if (accept) lv_thread_sync_signal(&w->inbox_sync);
+    else free(msg);
+    lua_pushboolean(L, accept);
+    return 1;
+}
+
+// worker:on(event, callback) - event is "message", "error" or "done"
+static int l_worker_on(lua_State* L) {
+    static const char* const events[] = {"message", "error", "done", NULL};
+    lua_worker_t* w = check_worker(L, 1);
+    int event = luaL_checkoption(L, 2, NULL, events);
+    if (!lua_isnoneornil(L, 3)) luaL_checktype(L, 3, LUA_TFUNCTION);
+    int* ref = event == 0 ? &w->on_message_ref : (event == 1 ? &w->on_error_ref : &w->on_done_ref);
+
+    if (!w->in_list) return 0;
+    luaL_unref(L, LUA_REGISTRYINDEX, *ref);
+    lua_pushvalue(L, 3);
+    *ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// worker:terminate() - abort the chunk, no further callbacks are delivered
+static int l_worker_terminate(lua_State* L) {
+    lua_worker_t* w = check_worker(L, 1);
+    worker_request_terminate(w);
+    worker_unlink(w);
+    worker_unref_handlers(w);
+    return 0;
+}
+
+// worker:is_running()
+static int l_worker_is_running(lua_State* L) {
+    lua_worker_t* w = check_worker(L, 1);
+    lv_mutex_lock(&w->lock);
+    int running = w->state != WORKER_FINISHED && !w->terminate;
+    lv_mutex_unlock(&w->lock);
+    lua_pushboolean(L, running);
+    return 1;
+}
+
+void lvgl_worker_release_state(lua_State* L) {
+    lua_worker_t* w = g_workers;
+    while (w) {
+        lua_worker_t* next = w->next;
+        if (w->L == L) {
+            worker_request_terminate(w);
+            worker_unlink(w);
+            worker_unref_handlers(w);
+        }
+        w = next;
+    }
+}
+
+// __gc
+static int l_worker_gc(lua_State* L) {
+    lua_worker_t** ud = (lua_worker_t**)luaL_checkudata(L, 1, "lv_worker");
+    lua_worker_t* w = *ud;
+    if (w) {
+        worker_request_terminate(w);
+        worker_unlink(w);
+        worker_release(w);
+        *ud = NULL;
+    }
+    return 0;
+}
+
+#else
+
+// lv.worker(source, ...) - needs an OS layer for threads
+static int l_lv_worker(lua_State* L) {
+    return luaL_error(L, "lv.worker requires LV_USE_OS");
+}
+
+static int l_worker_gc(lua_State* L) {
+    (void)L;
+    return 0;
+}
+
+void lvgl_worker_release_state(lua_State* L) {
+    (void)L;
+}
+
+#endif // LV_USE_OS != LV_OS_NONE
+
+// Worker methods table
+static const luaL_Reg lv_worker_methods[] = {
+#if LV_USE_OS != LV_OS_NONE
+    {"post", l_worker_post},
+    {"on", l_worker_on},
+    {"terminate", l_worker_terminate},
+    {"is_running", l_worker_is_running},
+#endif
+    {NULL, NULL}
+};
+
+// Worker metamethods table
+static const luaL_Reg lv_worker_metamethods[] = {
+    {"__gc", l_worker_gc},
+    {NULL, NULL}
+};
+
+// Worker module functions
+static const luaL_Reg lv_worker_funcs[] = {
+    {"worker", l_lv_worker},
+    {NULL, NULL}
+};
+
+const luaL_Reg* lvgl_get_worker_methods(void) {
+    return lv_worker_methods;
+}
+
+const luaL_Reg* lvgl_get_worker_metamethods(void) {
+    return lv_worker_metamethods;
+}
+
+const luaL_Reg* lvgl_get_worker_funcs(void) {
+    return lv_worker_funcs;
+}
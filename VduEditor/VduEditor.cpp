@@ -271,6 +271,46 @@ static bool load_lua_script(const char* script_path)
     return true;
 }
 
+/**
+ * @brief 创建进程内仿真预览的显示器（独立窗口，带鼠标和键盘输入）
+ * @param width 显示宽度
+ * @param height 显示高度
+ * @return 成功返回显示器，失败返回 nullptr
+ */
+static lv_display_t* create_preview_display(int32_t width, int32_t height)
+{
+    lv_display_t* display = lv_windows_create_display(
+        L"VduEditor - 仿真预览", width, height, 100, false, false);
+    if (!display) {
+        std::cerr << "Failed to create preview display" << std::endl;
+        return nullptr;
+    }
+    lv_windows_acquire_pointer_indev(display);
+    lv_windows_acquire_keypad_indev(display);
+    return display;
+}
+
+/**
+ * @brief 关闭仿真预览的显示器
+ * 窗口在自己的线程中处理 WM_CLOSE，销毁时删除显示器
+ * @param display 显示器
+ */
+static void destroy_preview_display(lv_display_t* display)
+{
+    lv_indev_t* indev = lv_indev_get_next(nullptr);
+    while (indev) {
+        lv_indev_t* next = lv_indev_get_next(indev);
+        if (lv_indev_get_display(indev) == display) {
+            lv_indev_delete(indev);
+        }
+        indev = next;
+    }
+    HWND window_handle = lv_windows_get_display_window_handle(display);
+    if (window_handle) {
+        PostMessageW(window_handle, WM_CLOSE, 0, 0);
+    }
+}
+
 /**
  * @brief 清理 Lua 状态机资源
  */
@@ -372,6 +412,9 @@ int main(int argc, char* argv[])
         std::cerr << "Warning: Chinese font not loaded, Chinese text may not display correctly" << std::endl;
     }
 
+    // 仿真预览在编辑器进程内运行，显示在单独的窗口中
+    lvgl_preview_set_display_factory(create_preview_display, destroy_preview_display);
+
     // 初始化 Lua
     if (!init_lua()) {
         std::cerr << "Failed to initialize Lua" << std::endl;
@@ -35,11 +35,19 @@ function CanvasArea.new(parent, props)
         show_page_border = props.show_page_border ~= false,  -- 默认显示边界线
         page_border_color = props.page_border_color or 0xFF6600,  -- 橙色边界线
         page_border_width = props.page_border_width or 2,
+        -- 保留控件的最近使用图页数量
+        page_cache_size = props.page_cache_size or 8,
     }
     
-    -- 放置的控件列表
+    -- 放置的控件列表（当前图页的控件，即 self._pages[当前图页].widgets）
     self._widgets = {}
     
+    -- 图页缓存：图页 -> { layer, widgets, source }，按最近使用排序的图页列表
+    self._pages = {}
+    self._page_order = {}
+    self._page_key = nil
+    self._layer = nil
+    
     -- 选中的控件（支持多选）
     self._selected_widgets = {}
     self._selection_boxes = {}
@@ -318,32 +326,9 @@ end
 
 -- ========== 网格绘制 ==========
 
+-- 网格由画布容器在绘制子对象之前直接画出，不为每条网格线创建对象
 function CanvasArea:_draw_grid()
-    local grid_size = self.props.grid_size
-    local width = self.props.width
-    local height = self.props.height
-    
-    for x = grid_size, width - 1, grid_size do
-        local line = lv.obj_create(self.container)
-        line:set_pos(x, 0)
-        line:set_size(1, height)
-        line:set_style_bg_color(self.props.grid_color, 0)
-        line:set_style_bg_opa(128, 0)
-        line:set_style_radius(0, 0)
-        line:set_style_border_width(0, 0)
-        line:remove_flag(lv.OBJ_FLAG_CLICKABLE)
-    end
-    
-    for y = grid_size, height - 1, grid_size do
-        local line = lv.obj_create(self.container)
-        line:set_pos(0, y)
-        line:set_size(width, 1)
-        line:set_style_bg_color(self.props.grid_color, 0)
-        line:set_style_bg_opa(128, 0)
-        line:set_style_radius(0, 0)
-        line:set_style_border_width(0, 0)
-        line:remove_flag(lv.OBJ_FLAG_CLICKABLE)
-    end
+    self.container:set_grid(self.props.grid_size, self.props.grid_color, 128)
 end
 
 function CanvasArea:snap_position(x, y)
@@ -377,6 +362,27 @@ end
 
 -- ========== 控件管理 ==========
 
+-- 拆出非字符串属性上的表达式（"=..."），设计模式下以默认值显示，导出时写回
+local function extract_design_expressions(widget_module, props)
+    local meta = widget_module.__widget_meta
+    if not meta or not meta.properties then return props, nil end
+    local create_props, expressions = props, nil
+    for _, p in ipairs(meta.properties) do
+        local value = props[p.name]
+        if p.type ~= "string" and p.type ~= "code" and type(value) == "string"
+            and value:sub(1, 1) == "=" and value:sub(2, 2) ~= "=" then
+            if not expressions then
+                expressions = {}
+                create_props = {}
+                for k, v in pairs(props) do create_props[k] = v end
+            end
+            expressions[p.name] = { expr = value, placeholder = p.default }
+            create_props[p.name] = p.default
+        end
+    end
+    return create_props, expressions
+end
+
 function CanvasArea:add_widget(widget_module, props)
     props = props or {}
     
@@ -403,7 +409,8 @@ function CanvasArea:add_widget(widget_module, props)
         end
     end
     
-    local widget_instance = widget_module.new(self.container, props)
+    local create_props, expressions = extract_design_expressions(widget_module, props)
+    local widget_instance = widget_module.new(self:_get_layer(), create_props)
     local main_obj = widget_instance.btn or widget_instance.container or widget_instance.obj or widget_instance.chart
     
     if widget_instance.stop then
@@ -419,6 +426,7 @@ function CanvasArea:add_widget(widget_module, props)
         module = widget_module,
         instance = widget_instance,
         props = props,
+        expressions = expressions,
     }
     
     table.insert(self._widgets, widget_entry)
@@ -947,8 +955,10 @@ function CanvasArea:_update_all_selection_boxes()
     end
 end
 
+-- 同一秒内的随机数可能重复，ID 重复时删除控件会移除错误的列表项，改用递增序号
 function CanvasArea:_generate_id()
-    return "widget_" .. os.time() .. "_" .. math.random(1000, 9999)
+    self._id_counter = (self._id_counter or 0) + 1
+    return "widget_" .. os.time() .. "_" .. self._id_counter
 end
 
 -- ========== 删除操作 ==========
@@ -984,7 +994,11 @@ end
 
 -- ========== 获取方法 ==========
 
-function CanvasArea:get_widgets()
+function CanvasArea:get_widgets(key)
+    if key ~= nil then
+        local page = self._pages[key]
+        return page and page.widgets or {}
+    end
     return self._widgets
 end
 
@@ -1005,30 +1019,157 @@ end
 
 -- ========== 导出/清空 ==========
 
-function CanvasArea:export_state()
+function CanvasArea:export_state(key)
     local state = { widgets = {} }
-    for _, w in ipairs(self._widgets) do
+    for _, w in ipairs(self:get_widgets(key)) do
+        local props = w.instance:to_state()
+        if w.expressions then
+            -- 属性仍是占位默认值时写回表达式（在属性面板中修改过则以新值为准）
+            local merged = {}
+            for k, v in pairs(props) do merged[k] = v end
+            for name, e in pairs(w.expressions) do
+                if merged[name] == e.placeholder then
+                    merged[name] = e.expr
+                end
+            end
+            props = merged
+        end
         local widget_state = {
             id = w.id,
             type = w.module.__widget_meta and w.module.__widget_meta.id or "unknown",
-            props = w.instance:to_state()
+            props = props
         }
         table.insert(state.widgets, widget_state)
     end
     return state
 end
 
+-- 清空当前图页的控件，并释放其他缓存的图页
 function CanvasArea:clear()
+    self:deselect_all()
+    for i = #self._page_order, 1, -1 do
+        local key = self._page_order[i]
+        if key ~= self._page_key then
+            self:drop_page(key)
+        end
+    end
     for _, w in ipairs(self._widgets) do
         local instance = w.instance
         local main_obj = instance.btn or instance.container or instance.obj or instance.chart
         if main_obj then main_obj:delete() end
     end
-    self._widgets = {}
-    self:deselect_all()
+    for i = #self._widgets, 1, -1 do
+        self._widgets[i] = nil
+    end
     self:_emit("canvas_cleared")
 end
 
+-- ========== 图页缓存 ==========
+-- 每个图页的控件放在画布容器中各自的透明图层里，切换图页时只切换图层的显示。
+-- source 是创建控件时使用的图页数据，与调用方当前的数据不同时重新创建。
+
+function CanvasArea:_create_layer()
+    local layer = lv.obj_create(self.container)
+    layer:set_pos(0, 0)
+    layer:set_size(lv.pct(100), lv.pct(100))
+    layer:set_style_bg_opa(0, 0)
+    layer:set_style_border_width(0, 0)
+    layer:set_style_radius(0, 0)
+    layer:set_style_pad_all(0, 0)
+    layer:remove_flag(lv.OBJ_FLAG_CLICKABLE)
+    layer:remove_flag(lv.OBJ_FLAG_SCROLLABLE)
+    return layer
+end
+
+-- 控件所在的图层，还没有切换过图页时创建一个不属于任何图页的图层
+function CanvasArea:_get_layer()
+    if not self._layer then
+        self._layer = self:_create_layer()
+    end
+    return self._layer
+end
+
+-- 切换到图页 key，返回 true 表示缓存的控件可直接使用，返回 false 时调用方需要为空图层添加控件
+function CanvasArea:show_page(key, source)
+    self:deselect_all()
+    local page = self._pages[key]
+    local cached = page ~= nil and page.source == source
+    if page and not cached then
+        self:drop_page(key)
+        page = nil
+    end
+    if self._layer and (not page or self._layer ~= page.layer) then
+        if self._page_key ~= nil then
+            self._layer:add_flag(lv.OBJ_FLAG_HIDDEN)
+        else
+            -- 未属于任何图页的图层没有保存的必要，直接删除
+            self._layer:delete()
+        end
+    end
+    if not page then
+        page = { layer = self:_create_layer(), widgets = {}, source = source }
+        self._pages[key] = page
+    end
+    page.layer:remove_flag(lv.OBJ_FLAG_HIDDEN)
+    self._page_key = key
+    self._layer = page.layer
+    self._widgets = page.widgets
+    
+    -- 更新最近使用顺序，超出缓存数量时释放最久未使用的图页
+    for i, k in ipairs(self._page_order) do
+        if k == key then
+            table.remove(self._page_order, i)
+            break
+        end
+    end
+    table.insert(self._page_order, key)
+    while #self._page_order > math.max(1, self.props.page_cache_size) do
+        local oldest = self._page_order[1]
+        self:_emit("page_evicting", oldest)
+        self:drop_page(oldest)
+    end
+    return cached
+end
+
+-- 释放图页 key 的控件
+function CanvasArea:drop_page(key)
+    local page = self._pages[key]
+    if not page then return end
+    if key == self._page_key then
+        self:deselect_all()
+        self._page_key = nil
+        self._layer = nil
+        self._widgets = {}
+    end
+    page.layer:delete()
+    self._pages[key] = nil
+    for i, k in ipairs(self._page_order) do
+        if k == key then
+            table.remove(self._page_order, i)
+            break
+        end
+    end
+end
+
+-- 图页 key 的控件保存到新的图页数据后更新 source，保持缓存有效
+function CanvasArea:set_page_source(key, source)
+    local page = self._pages[key]
+    if page then
+        page.source = source
+    end
+end
+
+-- 缓存的图页是否仍与图页数据 source 一致
+function CanvasArea:is_page_cached(key, source)
+    local page = self._pages[key]
+    return page ~= nil and page.source == source
+end
+
+-- 当前图页
+function CanvasArea:get_current_page()
+    return self._page_key
+end
+
 -- ========== 网格控制 ==========
 
 function CanvasArea:toggle_grid()
@@ -1062,26 +1203,10 @@ function CanvasArea:is_snap_to_grid()
 end
 
 function CanvasArea:_refresh_grid()
-    local children_to_delete = {}
-    local child_count = self.container:get_child_count()
-    
-    for i = 0, child_count - 1 do
-        local child = self.container:get_child(i)
-        if child then
-            local w = child:get_width()
-            local h = child:get_height()
-            if (w == 1 or h == 1) and not child:has_flag(lv.OBJ_FLAG_CLICKABLE) then
-                table.insert(children_to_delete, child)
-            end
-        end
-    end
-    
-    for _, child in ipairs(children_to_delete) do
-        child:delete()
-    end
-    
     if self.props.show_grid then
         self:_draw_grid()
+    else
+        self.container:set_grid(0)
     end
 end
 
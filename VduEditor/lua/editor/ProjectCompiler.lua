@@ -1,6 +1,7 @@
 ﻿ -- ProjectCompiler.lua
 -- 工程编译器：将JSON工程文件转换为可运行的Lua脚本
 
+local lv = require("lvgl")
 local json = require("json")
 
 local ProjectCompiler = {}
@@ -39,6 +40,31 @@ local EVENT_DEFAULT_PARAMS = {
     ["time_tick"] = "self, time_str",
 }
 
+-- 单个函数最多 200 个局部变量，图页控件数超过该值时未命名控件放入独立的 do ... end 作用域
+local MAX_PAGE_LOCALS = 180
+
+-- 默认保留的隐藏图页数量（工程 settings.page_cache 可覆盖）
+local DEFAULT_PAGE_CACHE = 3
+
+-- 默认每帧用于创建图页的时间（工程 settings.page_build_budget_ms 可覆盖）
+local DEFAULT_BUILD_BUDGET_MS = 8
+
+-- 分帧创建定时器的周期（与 LV_DEF_REFR_PERIOD 一致）
+local BUILD_PERIOD_MS = 10
+
+-- 一个二进制图页描述最多包含的控件数（分帧创建时每段之间检查一次预算）
+local MAX_BLOB_WIDGETS = 128
+
+-- 二进制图页描述的记录类型（与 lvgl_page_lua_bindings.c 一致）
+local BLOB_WIDGET_BUTTON = 1
+local BLOB_NO_TEXT = 0xFFFF
+
+-- widgets.button 构造函数使用的默认值
+local BUTTON_DEFAULTS = { x = 0, y = 0, width = 100, height = 40, label = "OK" }
+
+-- 生成代码格式的版本，格式变化时递增，使已有的编译缓存失效
+local COMPILER_VERSION = 5
+
 -- actions 模块列表（需要引入到生成代码中）
 local ACTION_MODULES = {
     "actions.page_navigation",
@@ -117,7 +143,19 @@ local function value_to_string(value, indent)
             return "{ " .. table.concat(parts, ", " .. indent) .. " }"
         else
             local new_indent = indent .. "    "
-            for k, v in pairs(value) do
+            -- 按键排序，相同内容的表生成相同的代码（共享属性表依赖这一点）
+            local keys = {}
+            for k in pairs(value) do
+                keys[#keys + 1] = k
+            end
+            table.sort(keys, function(a, b)
+                if type(a) == type(b) and type(a) ~= "boolean" then
+                    return a < b
+                end
+                return tostring(a) < tostring(b)
+            end)
+            for _, k in ipairs(keys) do
+                local v = value[k]
                 local key_str
                 if type(k) == "string" and k:match("^[%a_][%w_]*$") then
                     key_str = k
@@ -198,12 +236,354 @@ local function preprocess_color_properties(props)
     return props
 end
 
+-- 检查属性值是否是表达式（"=" 开头；"==" 开头表示以 "=" 开头的普通字符串）
+local function is_expression(name, value)
+    if type(value) ~= "string" or name == "instance_name" or name:match("^on_.*_handler$") then
+        return false
+    end
+    return value:sub(1, 1) == "=" and value:sub(2, 2) ~= "="
+end
+
+-- 提取表达式依赖的变量名（tags.NAME 或 tags["NAME"]）
+local function extract_dependencies(expr)
+    local deps, seen = {}, {}
+    local function add(name)
+        if not seen[name] then
+            seen[name] = true
+            table.insert(deps, name)
+        end
+    end
+    for name in expr:gmatch("tags%s*%[%s*\"([^\"]+)\"%s*%]") do add(name) end
+    for name in expr:gmatch("tags%s*%[%s*'([^']+)'%s*%]") do add(name) end
+    -- 去掉字符串常量后再匹配 tags.NAME，避免误判
+    local code = expr:gsub('"[^"]*"', '""'):gsub("'[^']*'", "''")
+    for name in code:gmatch("tags%s*%.%s*([%a_][%w_]*)") do add(name) end
+    -- 动态下标无法静态分析
+    local dynamic = code:gsub("tags%s*%[%s*[\"'][^\"']*[\"']%s*%]", ""):match("tags%s*%[") ~= nil
+    return deps, dynamic
+end
+
+-- 编译表达式，返回函数源码和依赖列表
+-- 表达式单独占一行，末尾的 -- 注释不会吞掉 end；检查的就是生成的代码（括号保证它是单个值）
+local function compile_expression(expr, chunk_name)
+    local body = expr:sub(2)
+    local code = "function(tags) return " .. body .. "\nend"
+    local ok, err = load("return (" .. code .. ")", "=" .. chunk_name)
+    if not ok then
+        return nil, nil, "表达式语法错误 (" .. chunk_name .. "): " .. tostring(err)
+    end
+    local deps, dynamic = extract_dependencies(body)
+    if dynamic then
+        print("[ProjectCompiler] 警告: " .. chunk_name .. " 使用动态下标访问 tags，依赖无法自动提取")
+    end
+    return code, deps, nil
+end
+
+-- 将依赖列表转换为代码
+local function deps_to_string(deps)
+    local parts = {}
+    for _, name in ipairs(deps) do
+        table.insert(parts, '"' .. escape_string(name) .. '"')
+    end
+    return "{ " .. table.concat(parts, ", ") .. " }"
+end
+
+-- 拆分静态属性与表达式属性（按属性名排序，保证生成结果稳定）
+local function split_expression_props(props)
+    local static_props, expressions = {}, {}
+    for name, value in pairs(props) do
+        if is_expression(name, value) then
+            table.insert(expressions, { name = name, expr = value })
+        elseif type(value) == "string" and value:sub(1, 2) == "==" then
+            static_props[name] = value:sub(2)
+        else
+            static_props[name] = value
+        end
+    end
+    table.sort(expressions, function(a, b) return a.name < b.name end)
+    return static_props, expressions
+end
+
+-- 检查工程是否使用了表达式或变量
+local function project_uses_reactive(project_data)
+    if project_data.tags and next(project_data.tags) ~= nil then
+        return true
+    end
+    for _, page in ipairs(project_data.pages or {}) do
+        for _, widget in ipairs(page.widgets or {}) do
+            for name, value in pairs(widget.props or {}) do
+                if is_expression(name, value) then
+                    return true
+                end
+            end
+        end
+    end
+    return false
+end
+
+-- 从事件处理代码中找出图页跳转动作可到达的图页（用于预创建）
+local function collect_page_links(project_data, page_index, page_count)
+    local page = project_data.pages[page_index]
+    local found, links = {}, {}
+    local function add(target)
+        if target and target >= 1 and target <= page_count and target ~= page_index and not found[target] then
+            found[target] = true
+            table.insert(links, target)
+        end
+    end
+    for _, widget in ipairs(page.widgets or {}) do
+        for name, code in pairs(widget.props or {}) do
+            if type(code) == "string" and name:match("^on_.*_handler$") then
+                for target in code:gmatch("goto_page%s*%(%s*(%d+)%s*%)") do
+                    add(tonumber(target))
+                end
+                for target_name in code:gmatch("goto_page_by_name%s*%(%s*[\"'](.-)[\"']%s*%)") do
+                    for i, p in ipairs(project_data.pages) do
+                        if p.name == target_name then
+                            add(i)
+                            break
+                        end
+                    end
+                end
+                if code:find("goto_next_page", 1, true) then add(page_index + 1) end
+                if code:find("goto_prev_page", 1, true) then add(page_index - 1) end
+                if code:find("goto_first_page", 1, true) then add(1) end
+                if code:find("goto_last_page", 1, true) then add(page_count) end
+            end
+        end
+    end
+    table.sort(links)
+    return links
+end
+
+-- 没有脚本行为的按钮（无事件处理、无表达式、无实例名）可以由 lv.build_page 直接创建，
+-- 返回按钮构造函数使用的属性，不满足时返回 nil
+local function static_button_props(widget)
+    local widget_type = widget.type or "custom_button"
+    if widget.module_path or (WIDGET_TYPE_TO_MODULE[widget_type] or "widgets.button") ~= "widgets.button" then
+        return nil
+    end
+    local props = widget.props or {}
+    if make_valid_var_name(props.instance_name) then
+        return nil
+    end
+    local static_props, expressions = split_expression_props(props)
+    if #expressions > 0 then
+        return nil
+    end
+    for name, value in pairs(static_props) do
+        if name:match("^on_.+_handler$") and value ~= "" then
+            return nil
+        end
+    end
+    local result = {}
+    for name, default in pairs(BUTTON_DEFAULTS) do
+        local value = static_props[name]
+        if value == nil then
+            value = default
+        end
+        if name == "label" then
+            if type(value) ~= "string" and type(value) ~= "number" then
+                return nil
+            end
+            value = tostring(value)
+        elseif math.type(value) == "float" and value == math.floor(value) then
+            value = math.tointeger(value)
+        end
+        if name ~= "label" and (math.type(value) ~= "integer" or value < -32768 or value > 32767) then
+            return nil
+        end
+        result[name] = value
+    end
+    return result
+end
+
+-- 二进制字符串写成 Lua 字符串常量
+local function blob_literal(blob)
+    return '"' .. blob:gsub('[%c"\\\128-\255]', function(c)
+        return string.format("\\%03d", c:byte())
+    end) .. '"'
+end
+
+-- 编码一段连续的静态按钮：头部、字符串表、记录（格式见 lvgl_page_lua_bindings.c）
+local function encode_page_blob(buttons)
+    local strings, string_index = {}, {}
+    local records = {}
+    for _, props in ipairs(buttons) do
+        local text = props.label
+        local index = string_index[text]
+        if not index then
+            strings[#strings + 1] = string.pack("<s2", text) .. "\0"
+            index = #strings - 1
+            string_index[text] = index
+        end
+        records[#records + 1] = string.pack("<BhhhhI2", BLOB_WIDGET_BUTTON,
+            props.x, props.y, props.width, props.height, index)
+    end
+    return "VPB2" .. string.pack("<I2I2", #strings, #records) .. table.concat(strings) .. table.concat(records)
+end
+
+-- ========== 优化 ==========
+
+-- 控件模块的属性元数据：name -> { default, type }，模块无法加载时为 false
+local widget_meta_cache = {}
+
+local function widget_meta_properties(module_path)
+    local cached = widget_meta_cache[module_path]
+    if cached ~= nil then
+        return cached
+    end
+    local result = false
+    local ok, module = pcall(require, module_path)
+    if ok and type(module) == "table" and module.__widget_meta and module.__widget_meta.properties then
+        result = {}
+        for _, p in ipairs(module.__widget_meta.properties) do
+            result[p.name] = p
+        end
+    end
+    widget_meta_cache[module_path] = result
+    return result
+end
+
+-- 工程内容用到的控件模块的元数据哈希（属性名、类型和默认值）。
+-- optimize_props 删除与默认值相同的属性，默认值改变后已编译的代码不再等价，
+-- 因此编译缓存的键和分页编译的图页哈希都要包含它
+local function widget_meta_hash(content)
+    local seen, paths = {}, {}
+    local function add(path)
+        if not seen[path] then
+            seen[path] = true
+            table.insert(paths, path)
+        end
+    end
+    for _, path in pairs(WIDGET_TYPE_TO_MODULE) do
+        add(path)
+    end
+    for path in content:gmatch('"module_path"%s*:%s*"([^"]+)"') do
+        add(path)
+    end
+    table.sort(paths)
+
+    local parts = {}
+    for _, path in ipairs(paths) do
+        table.insert(parts, path)
+        local meta = widget_meta_properties(path)
+        if meta then
+            local names = {}
+            for name in pairs(meta) do
+                table.insert(names, name)
+            end
+            table.sort(names)
+            for _, name in ipairs(names) do
+                local p = meta[name]
+                local ok, default = pcall(json.encode, p.default)
+                table.insert(parts, name .. "=" .. tostring(p.type) .. ":" .. (ok and default or tostring(p.default)))
+            end
+        else
+            table.insert(parts, "-")
+        end
+    end
+    return lv.hash(table.concat(parts, "\0"))
+end
+
+-- "#RRGGBB" 转为整数，其他值不变
+local function color_to_int(value)
+    if type(value) == "string" and value:match("^#%x%x%x%x%x%x$") then
+        return tonumber(value:sub(2), 16)
+    end
+    return value
+end
+
+-- 控件构造函数只读取元数据中的属性，缺省时使用元数据默认值：
+-- 删除与默认值相同的属性、设计期字段（实例名、事件处理代码，后者另外生成为 :on 调用）
+-- 和构造函数不读取的属性，颜色转换为整数
+local function optimize_props(props, module_path, stats)
+    local meta = widget_meta_properties(module_path)
+    if not meta then
+        return
+    end
+    for name, value in pairs(props) do
+        local p = meta[name]
+        if not p or name == "instance_name" or p.type == "code" then
+            props[name] = nil
+            stats.fields = stats.fields + 1
+        else
+            local default = p.default
+            if p.type == "color" then
+                local converted = color_to_int(value)
+                if converted ~= value then
+                    value = converted
+                    props[name] = value
+                    stats.colors = stats.colors + 1
+                end
+                default = color_to_int(default)
+            end
+            if value == default then
+                props[name] = nil
+                stats.defaults = stats.defaults + 1
+            end
+        end
+    end
+end
+
+-- 属性表引用：先生成占位符，全部图页生成后出现多次的表提升为共享常量（控件构造函数不修改传入的表）
+local function props_ref(ctx, props)
+    local key = value_to_string(props, "")
+    local entry = ctx.props_by_key[key]
+    if not entry then
+        entry = { id = #ctx.props_list + 1, key = key, props = props, count = 0 }
+        ctx.props_by_key[key] = entry
+        ctx.props_list[entry.id] = entry
+    end
+    entry.count = entry.count + 1
+    return "\0PROPS" .. entry.id .. "\0"
+end
+
+-- 替换属性表占位符，返回共享常量的定义代码
+local function resolve_props(code, ctx)
+    local shared_lines = {}
+    for _, entry in ipairs(ctx.props_list) do
+        if ctx.optimize and entry.count > 1 then
+            ctx.stats.shared = ctx.stats.shared + 1
+            ctx.stats.shared_uses = ctx.stats.shared_uses + entry.count
+            entry.shared = #shared_lines + 1
+            shared_lines[entry.shared] = "SHARED_PROPS[" .. entry.shared .. "] = " .. entry.key
+        end
+    end
+    code = code:gsub("\0PROPS(%d+)\0", function(id)
+        local entry = ctx.props_list[tonumber(id)]
+        if entry.shared then
+            return "SHARED_PROPS[" .. entry.shared .. "]"
+        end
+        return value_to_string(entry.props, "    ")
+    end)
+    return code, shared_lines
+end
+
+-- 删除生成代码中没有使用的 local xxx = require("...")
+local function remove_unused_requires(code, stats)
+    local out = {}
+    for line in (code .. "\n"):gmatch("(.-)\n") do
+        local name = line:match('^local ([%w_]+) = require%("[^"]+"%)$')
+        if name and not code:find("%f[%w_]" .. name .. "%f[^%w_]", (code:find(line, 1, true) or 0) + #line) then
+            stats.requires = stats.requires + 1
+        else
+            out[#out + 1] = line
+        end
+    end
+    return table.concat(out, "\n")
+end
+
 -- 生成控件创建代码
-local function generate_widget_code(widget, index, page_var, used_names)
+local function generate_widget_code(widget, index, page_var, used_names, scoped, ctx)
     local lines = {}
     local widget_type = widget.type or "custom_button"
     local module_path = widget.module_path or WIDGET_TYPE_TO_MODULE[widget_type] or "widgets.button"
-    local props = widget.props or {}
+    -- 复制属性表，编译不修改工程数据（分页编译按工程内容计算哈希）
+    local props = {}
+    for k, v in pairs(widget.props or {}) do
+        props[k] = v
+    end
     
     -- 确保 design_mode = false
     props.design_mode = false
@@ -219,6 +599,7 @@ local function generate_widget_code(widget, index, page_var, used_names)
         -- 没有有效的实例名称，使用默认名称
         var_name = "widget_" .. index
     else
+        scoped = false
         -- 检查变量名是否重复
         if used_names[var_name] then
             -- 如果重复，添加索引后缀
@@ -229,8 +610,14 @@ local function generate_widget_code(widget, index, page_var, used_names)
     -- 记录已使用的变量名
     used_names[var_name] = true
     
+    -- 表达式属性不写入初始属性表，由 reactive 运行时计算后设置
+    local static_props, expressions = split_expression_props(props)
+    if ctx.optimize then
+        optimize_props(static_props, module_path, ctx.stats)
+    end
+    
     -- 生成属性表
-    local props_str = value_to_string(props, "    ")
+    local props_str = props_ref(ctx, static_props)
     
     -- 生成注释，包含实例名称信息
     local comment = "控件 " .. index .. ": " .. widget_type
@@ -239,9 +626,23 @@ local function generate_widget_code(widget, index, page_var, used_names)
     end
     
     table.insert(lines, "    -- " .. comment)
+    if scoped then
+        table.insert(lines, "    do")
+    end
     table.insert(lines, "    local " .. var_name .. " = " .. module_path:gsub("%.", "_") .. ".new(" .. page_var .. ", " .. props_str .. ")")
     table.insert(lines, "")
     
+    -- 生成表达式绑定代码
+    for _, item in ipairs(expressions) do
+        local fn_code, deps, err = compile_expression(item.expr, var_name .. "." .. item.name)
+        if not fn_code then
+            return nil, err
+        end
+        table.insert(lines, "    -- 表达式绑定: " .. item.name .. " " .. (item.expr:match("^[^\n]*")))
+        table.insert(lines, "    reactive.bind(" .. var_name .. ', "' .. item.name .. '", ' .. fn_code .. ", " .. deps_to_string(deps) .. ")")
+        table.insert(lines, "")
+    end
+    
     -- 获取该控件类型支持的事件列表
     local events = WIDGET_EVENTS[widget_type] or { "clicked", "single_clicked", "double_clicked" }
     
@@ -272,16 +673,67 @@ local function generate_widget_code(widget, index, page_var, used_names)
         end
     end
     
+    if scoped then
+        table.insert(lines, "    end")
+        table.insert(lines, "")
+    end
+    
     return table.concat(lines, "\n"), module_path, var_name
 end
 
+-- 生成工程变量代码
+-- tags 支持数组形式 { { name = "FT101", value = 0 }, ... } 或键值形式 { FT101 = 0 }，
+-- value 为 "=表达式" 时定义计算变量
+local function generate_tags_code(tags)
+    local lines = {}
+    local items = {}
+    for k, v in pairs(tags or {}) do
+        if type(k) == "number" and type(v) == "table" then
+            table.insert(items, { index = k, name = v.name, value = v.value })
+        else
+            table.insert(items, { name = k, value = v })
+        end
+    end
+    table.sort(items, function(a, b)
+        if a.index and b.index then return a.index < b.index end
+        if a.index or b.index then return a.index ~= nil end
+        return tostring(a.name) < tostring(b.name)
+    end)
+    if #items == 0 then
+        return lines
+    end
+    
+    table.insert(lines, "-- ========== 工程变量 ==========")
+    for _, item in ipairs(items) do
+        if type(item.name) ~= "string" or item.name == "" then
+            return nil, "无效的变量名: " .. tostring(item.name)
+        end
+        local name_str = '"' .. escape_string(item.name) .. '"'
+        if is_expression(item.name, item.value) then
+            local fn_code, deps, err = compile_expression(item.value, "tags." .. item.name)
+            if not fn_code then
+                return nil, err
+            end
+            table.insert(lines, "reactive.define_tag(" .. name_str .. ", " .. fn_code .. ", " .. deps_to_string(deps) .. ")")
+        else
+            local value = item.value
+            if type(value) == "string" and value:sub(1, 2) == "==" then
+                value = value:sub(2)
+            end
+            table.insert(lines, "reactive.set_tag(" .. name_str .. ", " .. value_to_string(value) .. ")")
+        end
+    end
+    table.insert(lines, "")
+    return lines
+end
+
 -- 生成图页代码
-local function generate_page_code(page, page_index)
+local function generate_page_code(page, page_index, ctx)
     local lines = {}
     local page_var = "page_" .. page_index
     local required_modules = {}
     local widget_vars = {}  -- 记录控件变量名
-    local used_names = {}   -- 记录已使用的变量名
+    local used_names = { tags = true, reactive = true, build_begin = true, build_step = true, SHARED_PROPS = true }   -- 记录已使用的变量名（预留运行时名称）
     
     -- 获取图页属性
     local page_width = page.width or 800
@@ -301,17 +753,49 @@ local function generate_page_code(page, page_index)
     table.insert(lines, "    container:set_style_border_width(0, 0)")
     table.insert(lines, "    container:remove_flag(lv.OBJ_FLAG_SCROLLABLE)")
     table.insert(lines, "    container:clear_layout()")
+    table.insert(lines, "    build_begin(container)")
     table.insert(lines, "")
     
+    -- 连续的静态按钮合并为一个二进制描述，由 lv.build_page 一次创建
+    local run, run_first = {}, nil
+    local function flush_run()
+        if #run == 0 then return end
+        local last = run_first + #run - 1
+        local range = run_first == last and tostring(run_first) or (run_first .. "-" .. last)
+        table.insert(lines, "    -- 控件 " .. range .. ": button（无脚本行为，二进制描述）")
+        table.insert(lines, "    lv.build_page(" .. blob_literal(encode_page_blob(run)) .. ", container)")
+        table.insert(lines, "    build_step()")
+        table.insert(lines, "")
+        run, run_first = {}, nil
+    end
+
     -- 生成控件代码
     if page.widgets and #page.widgets > 0 then
+        local scoped = #page.widgets > MAX_PAGE_LOCALS
         for i, widget in ipairs(page.widgets) do
-            local widget_code, module_path, var_name = generate_widget_code(widget, i, "container", used_names)
+            local static_props = ctx.use_blob and static_button_props(widget)
+            if static_props then
+                run_first = run_first or i
+                run[#run + 1] = static_props
+                if #run >= MAX_BLOB_WIDGETS then
+                    flush_run()
+                end
+                goto continue
+            end
+            flush_run()
+            local widget_code, module_path, var_name = generate_widget_code(widget, i, "container", used_names, scoped, ctx)
+            if not widget_code then
+                return nil, module_path
+            end
             table.insert(lines, widget_code)
+            table.insert(lines, "    build_step()")
+            table.insert(lines, "")
             required_modules[module_path] = true
             table.insert(widget_vars, var_name)
+            ::continue::
         end
     end
+    flush_run()
     
     table.insert(lines, "    return container")
     table.insert(lines, "end")
@@ -320,8 +804,87 @@ local function generate_page_code(page, page_index)
     return table.concat(lines, "\n"), required_modules, widget_vars
 end
 
+-- 把共享属性表的定义代码插入到 "\0SHARED_PROPS\0" 占位行
+local function insert_shared_props(code, ctx)
+    local shared_lines
+    code, shared_lines = resolve_props(code, ctx)
+    local shared_code = ""
+    if #shared_lines > 0 then
+        table.insert(shared_lines, 1, "-- ========== 共享属性表（多个控件使用相同的初始属性） ==========")
+        table.insert(shared_lines, 2, "local SHARED_PROPS = {}")
+        shared_code = table.concat(shared_lines, "\n") .. "\n"
+    end
+    return (code:gsub("\0SHARED_PROPS\0\n", function() return shared_code end))
+end
+
+-- 生成单个图页的模块（分页编译）：模块以根脚本传入的运行时表为参数，返回图页创建函数
+-- 图页使用自己的模块引用和共享属性表，与其他图页的内容无关
+local function generate_page_module(page, page_index, ctx, uses_reactive)
+    local page_ctx = {
+        use_blob = ctx.use_blob,
+        optimize = ctx.optimize,
+        stats = ctx.stats,
+        props_by_key = {},
+        props_list = {},
+    }
+    local page_code, modules = generate_page_code(page, page_index, page_ctx)
+    if not page_code then
+        return nil, modules
+    end
+
+    local lines = {}
+    table.insert(lines, "-- 自动生成的图页模块，由工程根脚本加载")
+    table.insert(lines, "local rt = ...")
+    table.insert(lines, "local lv = require(\"lvgl\")")
+    local module_paths = {}
+    for module_path, _ in pairs(modules) do
+        module_paths[#module_paths + 1] = module_path
+    end
+    table.sort(module_paths)
+    for _, module_path in ipairs(module_paths) do
+        table.insert(lines, "local " .. module_path:gsub("%.", "_") .. " = require(\"" .. module_path .. "\")")
+    end
+    for _, action_module in ipairs(ACTION_MODULES) do
+        table.insert(lines, "local " .. action_module:gsub("%.", "_") .. " = require(\"" .. action_module .. "\")")
+    end
+    if uses_reactive then
+        table.insert(lines, "local reactive = require(\"sim.reactive\")")
+        table.insert(lines, "local tags = reactive.tags")
+    end
+    table.insert(lines, "local build_begin, build_step = rt.build_begin, rt.build_step")
+    table.insert(lines, "local scr, scr_width, scr_height = rt.scr, rt.scr_width, rt.scr_height")
+    table.insert(lines, "")
+    table.insert(lines, "\0SHARED_PROPS\0")
+    table.insert(lines, page_code)
+    table.insert(lines, "return create_page_" .. page_index)
+    table.insert(lines, "")
+
+    local code = insert_shared_props(table.concat(lines, "\n"), page_ctx)
+    if ctx.optimize then
+        code = remove_unused_requires(code, ctx.stats)
+    end
+    return code
+end
+
+-- 分页编译时图页的哈希：图页内容（JSON）、控件元数据和影响图页代码的编译选项
+local function page_hash(page_json, page_index, ctx, uses_reactive, format)
+    return lv.hash(table.concat({
+        COMPILER_VERSION, format, page_index, tostring(ctx.use_blob), tostring(ctx.optimize),
+        tostring(uses_reactive), widget_meta_hash(page_json), page_json,
+    }, "\0"))
+end
+
+-- 分页编译时图页模块的文件名
+local function page_file_name(page_index)
+    return string.format("page_%03d.lua", page_index)
+end
+
 -- 编译工程JSON为Lua脚本
-function ProjectCompiler:compile(project_data)
+-- compile_options.optimize 覆盖工程 settings.optimize（默认开启优化）；
+-- compile_options.split = { dir, page_json, previous, format } 时每个图页生成单独的模块（见 compile_split），
+-- 哈希与 previous[index] 相同的图页不重新生成；图页模块保存在 self.page_modules
+-- 优化统计保存在 self.stats
+function ProjectCompiler:compile(project_data, compile_options)
     if not project_data then
         return nil, "无效的工程数据"
     end
@@ -329,6 +892,7 @@ function ProjectCompiler:compile(project_data)
     local lines = {}
     local all_required_modules = {}
     local has_status_bar = project_data.status_bar and project_data.status_bar.enabled
+    local uses_reactive = project_uses_reactive(project_data)
     
     -- 文件头
     table.insert(lines, "-- ==============================================")
@@ -364,7 +928,12 @@ function ProjectCompiler:compile(project_data)
     
     -- 引用控件模块
     table.insert(lines, "-- 引用控件模块")
+    local module_paths = {}
     for module_path, _ in pairs(all_required_modules) do
+        module_paths[#module_paths + 1] = module_path
+    end
+    table.sort(module_paths)
+    for _, module_path in ipairs(module_paths) do
         local var_name = module_path:gsub("%.", "_")
         table.insert(lines, "local " .. var_name .. " = require(\"" .. module_path .. "\")")
     end
@@ -378,6 +947,22 @@ function ProjectCompiler:compile(project_data)
     end
     table.insert(lines, "")
     
+    -- 引用响应式运行时（工程使用了表达式属性或变量时）
+    if uses_reactive then
+        local tag_lines, tag_err = generate_tags_code(project_data.tags)
+        if not tag_lines then
+            return nil, tag_err
+        end
+        table.insert(lines, "-- 引用响应式运行时")
+        table.insert(lines, "local reactive = require(\"sim.reactive\")")
+        table.insert(lines, "local tags = reactive.tags")
+        table.insert(lines, "_G.tags = tags")
+        table.insert(lines, "")
+        for _, line in ipairs(tag_lines) do
+            table.insert(lines, line)
+        end
+    end
+    
     -- 获取屏幕
     table.insert(lines, "-- 获取活动屏幕")
     table.insert(lines, "local scr = lv.scr_act()")
@@ -430,46 +1015,351 @@ function ProjectCompiler:compile(project_data)
         table.insert(lines, "")
     end
     
-    -- 生成每个图页的代码
+    -- 分帧创建辅助函数（图页创建函数中调用）
+    table.insert(lines, "-- ========== 分帧创建 ==========")
+    table.insert(lines, "-- 图页创建函数在 PageManager 的协程中运行时按帧预算分段执行：每创建一个控件检查一次，")
+    table.insert(lines, "-- 超出预算则让出到下一帧；直接调用（批量渲染等工具）时一次创建完成。")
+    table.insert(lines, "local build_deadline = nil   -- 本帧预算的截止时间（微秒），只在分段创建期间设置")
+    table.insert(lines, "")
+    table.insert(lines, "-- 正在创建的图页：协程 -> { container, scope }，创建失败或被取消时用来删除容器并解除绑定")
+    table.insert(lines, 'local build_handles = setmetatable({}, { __mode = "k" })')
+    table.insert(lines, "")
+    table.insert(lines, "-- 分段创建期间图页容器保持隐藏，完成后整体显示")
+    table.insert(lines, "local function build_begin(container)")
+    if uses_reactive then
+        table.insert(lines, "    build_handles[coroutine.running()] = { container = container, scope = reactive.current_scope() }")
+    else
+        table.insert(lines, "    build_handles[coroutine.running()] = { container = container }")
+    end
+    table.insert(lines, "    if build_deadline then")
+    table.insert(lines, "        container:add_flag(lv.OBJ_FLAG_HIDDEN)")
+    table.insert(lines, "    end")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 删除协程 co 中未创建完成的图页容器，并解除已经创建的表达式绑定")
+    table.insert(lines, "local function discard_build(co)")
+    table.insert(lines, "    local handle = build_handles[co]")
+    table.insert(lines, "    if not handle then return end")
+    table.insert(lines, "    build_handles[co] = nil")
+    if uses_reactive then
+        table.insert(lines, "    if handle.scope then")
+        table.insert(lines, "        reactive.dispose(handle.scope)")
+        table.insert(lines, "    end")
+    end
+    table.insert(lines, "    handle.container:delete()")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "local function build_step()")
+    table.insert(lines, "    if build_deadline and lv.time_us() > build_deadline then")
+    table.insert(lines, "        coroutine.yield()")
+    table.insert(lines, "    end")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    
+    -- 生成每个图页的代码（settings.page_blob = false 时所有控件都通过控件模块创建）
+    local settings = project_data.settings or {}
+    local optimize = settings.optimize ~= false
+    if compile_options and compile_options.optimize ~= nil then
+        optimize = compile_options.optimize
+    end
+    local ctx = {
+        use_blob = settings.page_blob ~= false,
+        optimize = optimize,
+        stats = { defaults = 0, fields = 0, colors = 0, shared = 0, shared_uses = 0, requires = 0 },
+        props_by_key = {},
+        props_list = {},
+    }
+    table.insert(lines, "\0SHARED_PROPS\0")
+    local split = compile_options and compile_options.split
     local page_functions = {}
+    local page_modules = {}
+    if split then
+        table.insert(lines, "-- ========== 图页模块（每个图页一个文件，首次创建时加载） ==========")
+        table.insert(lines, "-- 根脚本的路径：仿真器作为脚本参数传入，否则取源码位置（图页目录与根脚本在同一目录）")
+        table.insert(lines, 'local script_path = ... or debug.getinfo(1, "S").source:match("^@(.*)") or ""')
+        table.insert(lines, 'local PAGE_DIR = (script_path:match("^(.*[/\\\\])") or "") .. "' .. escape_string(split.dir) .. '"')
+        table.insert(lines, "local page_rt = {")
+        table.insert(lines, "    build_begin = build_begin,")
+        table.insert(lines, "    build_step = build_step,")
+        table.insert(lines, "    scr = scr,")
+        table.insert(lines, "    scr_width = scr_width,")
+        table.insert(lines, "    scr_height = scr_height,")
+        table.insert(lines, "}")
+        table.insert(lines, "")
+        table.insert(lines, "local page_chunks = {}   -- 已加载的图页模块：文件名 -> 图页创建函数（热重载时清除）")
+        table.insert(lines, "local function load_page(file)")
+        table.insert(lines, "    return function(parent)")
+        table.insert(lines, "        local create = page_chunks[file]")
+        table.insert(lines, "        if not create then")
+        table.insert(lines, "            local chunk, err = loadfile(PAGE_DIR .. file)")
+        table.insert(lines, "            if not chunk then")
+        table.insert(lines, "                error(err, 0)")
+        table.insert(lines, "            end")
+        table.insert(lines, "            create = chunk(page_rt)")
+        table.insert(lines, "            page_chunks[file] = create")
+        table.insert(lines, "        end")
+        table.insert(lines, "        return create(parent)")
+        table.insert(lines, "    end")
+        table.insert(lines, "end")
+        table.insert(lines, "")
+    end
     if project_data.pages and #project_data.pages > 0 then
         for i, page in ipairs(project_data.pages) do
-            local page_code, modules, widget_vars = generate_page_code(page, i)
-            table.insert(lines, page_code)
-            table.insert(page_functions, "create_page_" .. i)
+            if split then
+                local file = page_file_name(i)
+                local hash = page_hash(split.page_json[i], i, ctx, uses_reactive, split.format)
+                local module = { file = file, hash = hash }
+                if split.previous[i] ~= hash then
+                    local module_code, module_err = generate_page_module(page, i, ctx, uses_reactive)
+                    if not module_code then
+                        return nil, module_err
+                    end
+                    module.code = module_code
+                end
+                page_modules[i] = module
+                table.insert(page_functions, 'load_page("' .. file .. '"), file = "' .. file .. '"')
+            else
+                local page_code, modules, widget_vars = generate_page_code(page, i, ctx)
+                if not page_code then
+                    return nil, modules
+                end
+                table.insert(lines, page_code)
+                table.insert(page_functions, "create_page_" .. i)
+            end
         end
     end
     
-    -- 生成图页管理器（预创建所有图页模式）
-    table.insert(lines, "-- ========== 图页管理（预创建模式） ==========")
+    -- 生成图页管理器（按需分帧创建图页，隐藏图页按 LRU 缓存，切换后预创建可跳转到的图页）
+    local cache_size = tonumber(settings.page_cache) or DEFAULT_PAGE_CACHE
+    local build_budget = tonumber(settings.page_build_budget_ms) or DEFAULT_BUILD_BUDGET_MS
+    local prefetch = settings.page_prefetch ~= false
+    table.insert(lines, "-- ========== 图页管理（按需分帧创建，LRU 缓存） ==========")
     table.insert(lines, "local PageManager = {}")
-    table.insert(lines, "PageManager.pages = {}        -- 图页信息")
-    table.insert(lines, "PageManager.containers = {}   -- 预创建的图页容器")
+    table.insert(lines, "PageManager.pages = {}        -- 图页信息（links 为图页跳转动作可到达的图页）")
+    table.insert(lines, "PageManager.containers = {}   -- 已创建的图页容器（未创建或已回收的为 nil）")
     table.insert(lines, "PageManager.current_index = 0")
+    table.insert(lines, "PageManager.recent = {}       -- 已创建图页的使用顺序，最近使用的在末尾")
+    table.insert(lines, "PageManager.cache_size = " .. math.max(0, math.floor(cache_size)) .. "   -- 除当前图页外保留的隐藏图页数量")
+    table.insert(lines, "PageManager.build_budget_ms = " .. math.max(0, build_budget) .. "   -- 每帧用于创建图页的时间，0 表示一次创建完成")
+    table.insert(lines, "PageManager.prefetch = " .. tostring(prefetch) .. "   -- 切换后在后台预创建可跳转到的图页")
+    table.insert(lines, "local BUILD_PERIOD_MS = " .. BUILD_PERIOD_MS)
     table.insert(lines, "")
     
     -- 注册所有图页
     table.insert(lines, "-- 注册图页创建函数")
+    local page_count = #page_functions
     for i, func_name in ipairs(page_functions) do
         local page_name = project_data.pages[i] and project_data.pages[i].name or ("图页 " .. i)
-        table.insert(lines, 'PageManager.pages[' .. i .. '] = { name = "' .. escape_string(page_name) .. '", create = ' .. func_name .. ' }')
+        local links = collect_page_links(project_data, i, page_count)
+        table.insert(lines, 'PageManager.pages[' .. i .. '] = { name = "' .. escape_string(page_name) .. '", create = ' .. func_name .. ', links = { ' .. table.concat(links, ", ") .. ' } }')
     end
     table.insert(lines, "")
     
-    -- 预创建所有图页
-    table.insert(lines, "-- 预创建所有图页（启动时调用）")
-    table.insert(lines, "function PageManager.init()")
-    table.insert(lines, '    print("[PageManager] 预创建所有图页...")')
-    table.insert(lines, "    for i, page_info in ipairs(PageManager.pages) do")
-    table.insert(lines, "        if page_info.create then")
-    table.insert(lines, "            local container = page_info.create(scr)")
-    table.insert(lines, "            -- 默认隐藏所有图页")
-    table.insert(lines, "            container:add_flag(lv.OBJ_FLAG_HIDDEN)")
-    table.insert(lines, "            PageManager.containers[i] = container")
-    table.insert(lines, '            print("[PageManager] 图页 " .. i .. " 已创建: " .. page_info.name)')
+    table.insert(lines, "local builds = {}          -- 正在分帧创建的图页：index -> 协程")
+    table.insert(lines, "local build_order = {}     -- 开始创建的顺序")
+    table.insert(lines, "local pending_index = nil  -- 创建完成后要显示的图页")
+    table.insert(lines, "local build_timer = nil")
+    table.insert(lines, "local prefetch_queue = {}")
+    table.insert(lines, "local placeholder = nil")
+    table.insert(lines, "")
+    table.insert(lines, "-- 除当前图页外已创建（隐藏）的图页数量")
+    table.insert(lines, "local function hidden_count()")
+    table.insert(lines, "    local count = #PageManager.recent")
+    table.insert(lines, "    if PageManager.containers[PageManager.current_index] then")
+    table.insert(lines, "        count = count - 1")
+    table.insert(lines, "    end")
+    table.insert(lines, "    return count")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "local function remove_value(list, value)")
+    table.insert(lines, "    for i = #list, 1, -1 do")
+    table.insert(lines, "        if list[i] == value then")
+    table.insert(lines, "            table.remove(list, i)")
+    table.insert(lines, "            return")
     table.insert(lines, "        end")
     table.insert(lines, "    end")
-    table.insert(lines, '    print("[PageManager] 所有图页创建完成，共 " .. #PageManager.containers .. " 个")')
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 销毁图页（控件的定时器、事件回调和表达式绑定随容器删除释放）")
+    table.insert(lines, "local function destroy_page(index)")
+    table.insert(lines, "    local container = PageManager.containers[index]")
+    table.insert(lines, "    if not container then return end")
+    table.insert(lines, "    PageManager.containers[index] = nil")
+    table.insert(lines, "    remove_value(PageManager.recent, index)")
+    table.insert(lines, "    container:delete()")
+    table.insert(lines, '    print("[PageManager] 图页 " .. index .. " 已回收")')
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 隐藏图页超过缓存数量时回收最久未使用的图页")
+    table.insert(lines, "local function evict_pages()")
+    table.insert(lines, "    local recent = PageManager.recent")
+    table.insert(lines, "    local hidden = hidden_count()")
+    table.insert(lines, "    local i = 1")
+    table.insert(lines, "    while hidden > PageManager.cache_size and i <= #recent do")
+    table.insert(lines, "        if recent[i] == PageManager.current_index then")
+    table.insert(lines, "            i = i + 1")
+    table.insert(lines, "        else")
+    table.insert(lines, "            destroy_page(recent[i])")
+    table.insert(lines, "            hidden = hidden - 1")
+    table.insert(lines, "        end")
+    table.insert(lines, "    end")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 创建图页（隐藏状态），已创建时直接返回")
+    table.insert(lines, "-- 预创建的图页排在使用顺序最前面，缓存满时最先回收")
+    table.insert(lines, "local function create_page(index, prefetched)")
+    table.insert(lines, "    local container = PageManager.containers[index]")
+    table.insert(lines, "    if container then return container end")
+    table.insert(lines, "    local page_info = PageManager.pages[index]")
+    table.insert(lines, "    local t0 = lv.time_us()")
+    table.insert(lines, "    local co = coroutine.running()")
+    if uses_reactive then
+        table.insert(lines, "    local ok, result, scope = pcall(reactive.collect, page_info.create, scr)")
+    else
+        table.insert(lines, "    local ok, result = pcall(page_info.create, scr)")
+    end
+    table.insert(lines, "    if not ok then")
+    table.insert(lines, "        discard_build(co)")
+    table.insert(lines, "        error(result, 0)")
+    table.insert(lines, "    end")
+    table.insert(lines, "    build_handles[co] = nil")
+    table.insert(lines, "    container = result")
+    if uses_reactive then
+        table.insert(lines, "    container:add_event_cb(function()")
+        table.insert(lines, "        reactive.dispose(scope)")
+        table.insert(lines, "    end, lv.EVENT_DELETE)")
+    end
+    table.insert(lines, "    container:add_flag(lv.OBJ_FLAG_HIDDEN)")
+    table.insert(lines, "    PageManager.containers[index] = container")
+    table.insert(lines, "    if prefetched then")
+    table.insert(lines, "        table.insert(PageManager.recent, 1, index)")
+    table.insert(lines, "    else")
+    table.insert(lines, "        PageManager.recent[#PageManager.recent + 1] = index")
+    table.insert(lines, "    end")
+    if uses_reactive then
+        table.insert(lines, "    -- 立即计算新图页的表达式，显示时不出现默认值")
+        table.insert(lines, "    reactive.flush()")
+    end
+    table.insert(lines, '    print(string.format("[PageManager] 图页 %d 已创建: %s (%.1f ms)", index, page_info.name, (lv.time_us() - t0) / 1000))')
+    table.insert(lines, "    return container")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 首个图页创建期间显示的占位提示")
+    table.insert(lines, "local function show_placeholder()")
+    table.insert(lines, "    if placeholder then return end")
+    table.insert(lines, "    placeholder = lv.label_create(scr)")
+    table.insert(lines, '    placeholder:set_text("加载中...")')
+    table.insert(lines, "    placeholder:set_style_text_color(0xCCCCCC, 0)")
+    table.insert(lines, "    placeholder:center()")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "local function hide_placeholder()")
+    table.insert(lines, "    if placeholder then")
+    table.insert(lines, "        placeholder:delete()")
+    table.insert(lines, "        placeholder = nil")
+    table.insert(lines, "    end")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 预创建当前图页可以跳转到的图页（在没有进行中的创建时逐个开始）")
+    table.insert(lines, "local function schedule_prefetch(index)")
+    table.insert(lines, "    prefetch_queue = {}")
+    table.insert(lines, "    if not PageManager.prefetch or PageManager.cache_size <= 0 then return end")
+    table.insert(lines, "    for _, target in ipairs(PageManager.pages[index].links or {}) do")
+    table.insert(lines, "        if target ~= index and not PageManager.containers[target] then")
+    table.insert(lines, "            prefetch_queue[#prefetch_queue + 1] = target")
+    table.insert(lines, "        end")
+    table.insert(lines, "    end")
+    table.insert(lines, "    if #prefetch_queue > 0 and build_timer then")
+    table.insert(lines, "        build_timer:resume()")
+    table.insert(lines, "    end")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 显示已创建的图页并隐藏当前图页（同一次调用内完成，不会出现半个图页）")
+    table.insert(lines, "local function show_page(index)")
+    table.insert(lines, "    local current = PageManager.containers[PageManager.current_index]")
+    table.insert(lines, "    if current and PageManager.current_index ~= index then")
+    table.insert(lines, "        current:add_flag(lv.OBJ_FLAG_HIDDEN)")
+    table.insert(lines, "    end")
+    table.insert(lines, "    hide_placeholder()")
+    table.insert(lines, "    PageManager.containers[index]:remove_flag(lv.OBJ_FLAG_HIDDEN)")
+    table.insert(lines, "    PageManager.current_index = index")
+    table.insert(lines, "    remove_value(PageManager.recent, index)")
+    table.insert(lines, "    PageManager.recent[#PageManager.recent + 1] = index")
+    table.insert(lines, "    evict_pages()")
+    table.insert(lines, '    print("[PageManager] 切换到图页 " .. index .. ": " .. PageManager.pages[index].name)')
+    table.insert(lines, "    schedule_prefetch(index)")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 在本帧预算内继续创建图页，创建结束（完成或失败）时返回 true")
+    table.insert(lines, "local function resume_build(index)")
+    table.insert(lines, "    local co = builds[index]")
+    table.insert(lines, "    build_deadline = lv.time_us() + PageManager.build_budget_ms * 1000")
+    table.insert(lines, "    local ok, err = coroutine.resume(co)")
+    table.insert(lines, "    build_deadline = nil")
+    table.insert(lines, '    if ok and coroutine.status(co) ~= "dead" then')
+    table.insert(lines, "        return false")
+    table.insert(lines, "    end")
+    table.insert(lines, "    builds[index] = nil")
+    table.insert(lines, "    remove_value(build_order, index)")
+    table.insert(lines, "    if not ok then")
+    table.insert(lines, '        print("[PageManager] 图页 " .. index .. " 创建失败: " .. tostring(err))')
+    table.insert(lines, "    end")
+    table.insert(lines, "    return true")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 每帧推进一个图页的创建：优先等待显示的图页，其次按开始顺序，最后是预创建")
+    table.insert(lines, "local function build_tick()")
+    table.insert(lines, "    local index = pending_index")
+    table.insert(lines, "    if not (index and builds[index]) then")
+    table.insert(lines, "        index = build_order[1]")
+    table.insert(lines, "    end")
+    table.insert(lines, "    if not index then")
+    table.insert(lines, "        while #prefetch_queue > 0 do")
+    table.insert(lines, "            local target = table.remove(prefetch_queue, 1)")
+    table.insert(lines, "            if not PageManager.containers[target] and hidden_count() < PageManager.cache_size then")
+    table.insert(lines, "                index = target")
+    table.insert(lines, "                break")
+    table.insert(lines, "            end")
+    table.insert(lines, "        end")
+    table.insert(lines, "        if not index then")
+    table.insert(lines, "            build_timer:pause()")
+    table.insert(lines, "            return")
+    table.insert(lines, "        end")
+    table.insert(lines, "        builds[index] = coroutine.create(function() create_page(index, true) end)")
+    table.insert(lines, "        build_order[#build_order + 1] = index")
+    table.insert(lines, "    end")
+    table.insert(lines, "    if resume_build(index) and index == pending_index then")
+    table.insert(lines, "        pending_index = nil")
+    table.insert(lines, "        if PageManager.containers[index] then")
+    table.insert(lines, "            show_page(index)")
+    table.insert(lines, "        end")
+    table.insert(lines, "    end")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "local function start_build(index)")
+    table.insert(lines, "    builds[index] = coroutine.create(function() create_page(index, false) end)")
+    table.insert(lines, "    build_order[#build_order + 1] = index")
+    table.insert(lines, "    if build_timer then")
+    table.insert(lines, "        build_timer:resume()")
+    table.insert(lines, "    else")
+    table.insert(lines, "        build_timer = lv.timer_create(build_tick, BUILD_PERIOD_MS)")
+    table.insert(lines, "    end")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 初始化（图页在首次切换到时创建）")
+    table.insert(lines, "function PageManager.init()")
+    table.insert(lines, '    print("[PageManager] 按需创建图页，缓存 " .. PageManager.cache_size .. " 个隐藏图页，每帧创建预算 " .. PageManager.build_budget_ms .. " ms")')
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 设置隐藏图页的缓存数量，超出的图页立即回收")
+    table.insert(lines, "function PageManager.set_cache_size(size)")
+    table.insert(lines, "    PageManager.cache_size = math.max(0, size)")
+    table.insert(lines, "    evict_pages()")
+    table.insert(lines, "end")
+    table.insert(lines, "")
+    table.insert(lines, "-- 目标图页是否正在创建（切换尚未生效）")
+    table.insert(lines, "function PageManager.is_loading()")
+    table.insert(lines, "    return pending_index ~= nil")
     table.insert(lines, "end")
     table.insert(lines, "")
     
@@ -504,33 +1394,49 @@ function ProjectCompiler:compile(project_data)
     table.insert(lines, "end")
     table.insert(lines, "")
     
-    -- 图页切换函数（显示/隐藏模式，不销毁图页）
-    table.insert(lines, "-- 切换图页（显示/隐藏模式，不销毁图页）")
+    -- 图页切换函数
+    table.insert(lines, "-- 切换图页：已创建的图页立即显示；未创建的图页按帧预算分段创建，")
+    table.insert(lines, "-- 创建期间当前图页继续显示和刷新，完成后再切换")
     table.insert(lines, "function PageManager.goto_page(index)")
     table.insert(lines, "    if index < 1 or index > #PageManager.pages then")
     table.insert(lines, '        print("[PageManager] 无效的图页索引: " .. tostring(index))')
     table.insert(lines, "        return false")
     table.insert(lines, "    end")
     table.insert(lines, "")
-    table.insert(lines, "    -- 隐藏当前图页")
-    table.insert(lines, "    if PageManager.current_index > 0 and PageManager.containers[PageManager.current_index] then")
-    table.insert(lines, "        PageManager.containers[PageManager.current_index]:add_flag(lv.OBJ_FLAG_HIDDEN)")
+    table.insert(lines, "    if PageManager.containers[index] then")
+    table.insert(lines, "        pending_index = nil")
+    table.insert(lines, "        show_page(index)")
+    table.insert(lines, "        return true")
     table.insert(lines, "    end")
     table.insert(lines, "")
-    table.insert(lines, "    -- 显示目标图页")
-    table.insert(lines, "    if PageManager.containers[index] then")
-    table.insert(lines, "        PageManager.containers[index]:remove_flag(lv.OBJ_FLAG_HIDDEN)")
-    table.insert(lines, "        PageManager.current_index = index")
-    table.insert(lines, '        print("[PageManager] 切换到图页 " .. index .. ": " .. PageManager.pages[index].name)')
+    table.insert(lines, "    -- 不分帧时一次创建完成")
+    table.insert(lines, "    if PageManager.build_budget_ms <= 0 and not builds[index] then")
+    table.insert(lines, "        create_page(index, false)")
+    table.insert(lines, "        show_page(index)")
     table.insert(lines, "        return true")
     table.insert(lines, "    end")
     table.insert(lines, "")
-    table.insert(lines, "    return false")
+    table.insert(lines, "    pending_index = index")
+    table.insert(lines, "    if not builds[index] then")
+    table.insert(lines, "        start_build(index)")
+    table.insert(lines, "    end")
+    table.insert(lines, "")
+    table.insert(lines, "    -- 先运行一段，较小的图页可以在本次调用内完成")
+    table.insert(lines, "    if resume_build(index) then")
+    table.insert(lines, "        pending_index = nil")
+    table.insert(lines, "        if not PageManager.containers[index] then")
+    table.insert(lines, "            return false")
+    table.insert(lines, "        end")
+    table.insert(lines, "        show_page(index)")
+    table.insert(lines, "    elseif not PageManager.containers[PageManager.current_index] then")
+    table.insert(lines, "        show_placeholder()")
+    table.insert(lines, "    end")
+    table.insert(lines, "    return true")
     table.insert(lines, "end")
     table.insert(lines, "")
     
     -- 获取图页容器
-    table.insert(lines, "-- 获取指定图页的容器")
+    table.insert(lines, "-- 获取指定图页的容器（未创建或已回收时为 nil）")
     table.insert(lines, "function PageManager.get_page_container(index)")
     table.insert(lines, "    return PageManager.containers[index]")
     table.insert(lines, "end")
@@ -543,6 +1449,83 @@ function ProjectCompiler:compile(project_data)
     table.insert(lines, "end")
     table.insert(lines, "")
     
+    -- 热重载（分页编译）：图页目录的 manifest 变化后重新加载哈希变化的图页模块
+    if split then
+        table.insert(lines, "-- ========== 热重载（重新编译后只重新创建变化的图页） ==========")
+        table.insert(lines, "local function read_manifest()")
+        table.insert(lines, "    local hashes = {}")
+        table.insert(lines, '    local f = io.open(PAGE_DIR .. "manifest", "r")')
+        table.insert(lines, "    if f then")
+        table.insert(lines, "        for line in f:lines() do")
+        table.insert(lines, '            local file, hash = line:match("^(%S+) (%x+)$")')
+        table.insert(lines, "            if file then")
+        table.insert(lines, "                hashes[file] = hash")
+        table.insert(lines, "            end")
+        table.insert(lines, "        end")
+        table.insert(lines, "        f:close()")
+        table.insert(lines, "    end")
+        table.insert(lines, "    return hashes")
+        table.insert(lines, "end")
+        table.insert(lines, "local page_hashes = read_manifest()")
+        table.insert(lines, "")
+        table.insert(lines, "-- 重新加载哈希变化的图页：已创建的图页销毁后按需重新创建，当前图页立即重建并保持显示，")
+        table.insert(lines, "-- 变量值保存在响应式运行时中不受影响。返回重新加载的图页数量")
+        table.insert(lines, "function PageManager.reload_changed()")
+        table.insert(lines, "    local hashes = read_manifest()")
+        table.insert(lines, "    -- 清单缺失或为空时编辑器正在替换它（Windows 上先删除再改名），等下一次通知")
+        table.insert(lines, "    if next(hashes) == nil then")
+        table.insert(lines, "        return 0")
+        table.insert(lines, "    end")
+        table.insert(lines, "    local count, total = 0, 0")
+        table.insert(lines, "    local rebuild_current = false")
+        table.insert(lines, "    for _ in pairs(hashes) do")
+        table.insert(lines, "        total = total + 1")
+        table.insert(lines, "    end")
+        table.insert(lines, "    for index, info in ipairs(PageManager.pages) do")
+        table.insert(lines, "        local hash = hashes[info.file]")
+        table.insert(lines, "        if hash and hash ~= page_hashes[info.file] then")
+        table.insert(lines, "            page_chunks[info.file] = nil")
+        table.insert(lines, "            if builds[index] then")
+        table.insert(lines, "                discard_build(builds[index])")
+        table.insert(lines, "                builds[index] = nil")
+        table.insert(lines, "                remove_value(build_order, index)")
+        table.insert(lines, "            end")
+        table.insert(lines, "            if index == PageManager.current_index and PageManager.containers[index] then")
+        table.insert(lines, "                rebuild_current = true")
+        table.insert(lines, "            end")
+        table.insert(lines, "            destroy_page(index)")
+        table.insert(lines, "            count = count + 1")
+        table.insert(lines, "        end")
+        table.insert(lines, "    end")
+        table.insert(lines, "    page_hashes = hashes")
+        table.insert(lines, "    if total ~= #PageManager.pages then")
+        table.insert(lines, '        print("[PageManager] 图页数量已变化（" .. total .. "），重新启动仿真后生效")')
+        table.insert(lines, "    end")
+        table.insert(lines, "    if count == 0 then")
+        table.insert(lines, "        return 0")
+        table.insert(lines, "    end")
+        table.insert(lines, "    local t0 = lv.time_us()")
+        table.insert(lines, "    if rebuild_current then")
+        table.insert(lines, "        local index = PageManager.current_index")
+        table.insert(lines, "        local ok, err = pcall(create_page, index, false)")
+        table.insert(lines, "        if ok then")
+        table.insert(lines, "            show_page(index)")
+        table.insert(lines, "        else")
+        table.insert(lines, '            print("[PageManager] 图页 " .. index .. " 重新创建失败: " .. tostring(err))')
+        table.insert(lines, "        end")
+        table.insert(lines, "    end")
+        table.insert(lines, "    -- 正在等待显示的图页被取消创建时重新开始")
+        table.insert(lines, "    if pending_index and not builds[pending_index] then")
+        table.insert(lines, "        local index = pending_index")
+        table.insert(lines, "        pending_index = nil")
+        table.insert(lines, "        PageManager.goto_page(index)")
+        table.insert(lines, "    end")
+        table.insert(lines, '    print(string.format("[PageManager] 热重载 %d 个图页 (%.1f ms)", count, (lv.time_us() - t0) / 1000))')
+        table.insert(lines, "    return count")
+        table.insert(lines, "end")
+        table.insert(lines, "")
+    end
+    
     -- 导出 PageManager 到全局
     table.insert(lines, "-- 导出图页管理器到全局")
     table.insert(lines, "_G.PageManager = PageManager")
@@ -562,8 +1545,12 @@ function ProjectCompiler:compile(project_data)
     table.insert(lines, "}")
     table.insert(lines, "")
     
-    -- 启动代码
+    -- 启动代码（宿主设置 VDU_NO_AUTOSTART 时只定义图页，不创建界面，供批量渲染等工具使用）
     local start_page = project_data.current_page_index or 1
+    table.insert(lines, "if VDU_NO_AUTOSTART then")
+    table.insert(lines, "    return PageManager")
+    table.insert(lines, "end")
+    table.insert(lines, "")
     table.insert(lines, "-- ========== 启动 ==========")
     table.insert(lines, 'print("=== 组态程序启动 ===")')
     table.insert(lines, 'print("图页数量: " .. #PageManager.pages)')
@@ -576,22 +1563,144 @@ function ProjectCompiler:compile(project_data)
         table.insert(lines, "")
     end
     
-    -- 预创建所有图页
-    table.insert(lines, "-- 预创建所有图页")
+    -- 初始化图页管理器（图页在切换到时创建）
+    table.insert(lines, "-- 初始化图页管理器")
     table.insert(lines, "PageManager.init()")
     table.insert(lines, "")
     
+    if uses_reactive then
+        table.insert(lines, "-- 计算表达式初始值并启动按帧刷新")
+        table.insert(lines, "reactive.flush()")
+        table.insert(lines, "reactive.start()")
+        table.insert(lines, "")
+    end
+    
     table.insert(lines, "-- 显示初始图页")
     table.insert(lines, "PageManager.goto_page(" .. start_page .. ")")
     table.insert(lines, "")
+    if split then
+        table.insert(lines, "-- 监视图页目录，编辑器重新编译后热重载变化的图页（manifest 在图页模块和根脚本之后写入）")
+        table.insert(lines, "if lv.watch_dir then")
+        table.insert(lines, "    PageManager.watcher = lv.watch_dir(PAGE_DIR, function(names)")
+        table.insert(lines, "        -- Windows 的通知不带文件名，任何变化都检查 manifest")
+        table.insert(lines, "        local changed = #names == 0")
+        table.insert(lines, "        for _, name in ipairs(names) do")
+        table.insert(lines, '            changed = changed or name == "manifest"')
+        table.insert(lines, "        end")
+        table.insert(lines, "        if changed then")
+        table.insert(lines, "            PageManager.reload_changed()")
+        table.insert(lines, "        end")
+        table.insert(lines, "    end)")
+        table.insert(lines, "end")
+        table.insert(lines, "")
+    end
     table.insert(lines, 'print("=== 组态程序已就绪 ===")')
     table.insert(lines, "")
     
-    return table.concat(lines, "\n"), nil
+    local code = insert_shared_props(table.concat(lines, "\n"), ctx)
+    if optimize then
+        code = remove_unused_requires(code, ctx.stats)
+    end
+    self.stats = ctx.stats
+    self.page_modules = split and page_modules or nil
+    return code, nil
+end
+
+-- 输出格式：源码/字节码，是否去掉调试信息
+local function output_format(options)
+    return options.bytecode and (options.strip and "bytecode-strip" or "bytecode") or "source"
+end
+
+-- 编译缓存的键：编译器版本、输出格式、控件元数据和工程内容的哈希
+-- widgets_json 是查找控件 module_path 的 JSON，缺省为 content
+local function cache_key(content, options, widgets_json)
+    local format = output_format(options) .. (options.split and "-split" or "")
+    local meta = widget_meta_hash(widgets_json or content)
+    return lv.hash(COMPILER_VERSION .. "\0" .. format .. "\0" .. meta .. "\0" .. content)
+end
+
+-- 确保目录存在
+local function ensure_dir(dir)
+    if package.config:sub(1, 1) == "\\" then
+        os.execute('if not exist "' .. dir .. '" mkdir "' .. dir .. '"')
+    else
+        os.execute('mkdir -p "' .. dir .. '"')
+    end
+end
+
+local function file_exists(path)
+    local f = io.open(path, "rb")
+    if not f then
+        return false
+    end
+    f:close()
+    return true
+end
+
+-- 输出文件存在且旁边的 .hash 记录的键相同时可以跳过编译
+local function cache_valid(output_filepath, key)
+    local f = io.open(output_filepath .. ".hash", "r")
+    if not f then
+        return false
+    end
+    local stored = f:read("l")
+    f:close()
+    return stored == key and file_exists(output_filepath)
+end
+
+-- 输出优化前后的代码大小和各项优化的数量
+local function print_optimize_report(compiler, project_data, optimized_size)
+    local stats = compiler.stats
+    local plain = compiler:compile(project_data, { optimize = false })
+    compiler.stats = stats
+    if not plain or not stats then
+        return
+    end
+    print(string.format("[ProjectCompiler] 优化: %d -> %d 字节 (%.1f%%)", #plain, optimized_size,
+        #plain > 0 and (optimized_size - #plain) * 100 / #plain or 0))
+    print(string.format("[ProjectCompiler]   默认值 %d, 设计期字段 %d, 颜色转整数 %d, 共享属性表 %d（%d 个控件）, 未使用的模块引用 %d",
+        stats.defaults, stats.fields, stats.colors, stats.shared, stats.shared_uses, stats.requires))
+end
+
+-- 写入编译结果，options.bytecode 时写入字节码（options.strip 去掉调试信息）
+local function write_output(lua_code, output_filepath, options, key)
+    local data = lua_code
+    if options.bytecode then
+        local chunkname = "=" .. (output_filepath:match("([^/\\]+)$") or output_filepath)
+        local bytecode, syntax_err = lv.compile_chunk(lua_code, chunkname, options.strip)
+        if not bytecode then
+            return false, "生成的脚本有语法错误: " .. tostring(syntax_err)
+        end
+        data = bytecode
+    end
+
+    local out_file, out_err = io.open(output_filepath, "wb")
+    if not out_file then
+        return false, "无法创建输出文件: " .. (out_err or "未知错误")
+    end
+    out_file:write(data)
+    out_file:close()
+
+    if key then
+        local hash_file = io.open(output_filepath .. ".hash", "w")
+        if hash_file then
+            hash_file:write(key, "\n")
+            hash_file:close()
+        end
+    end
+
+    print("[ProjectCompiler] 编译完成: " .. output_filepath .. " (" .. #data .. " 字节" ..
+        (options.bytecode and ", 字节码" or "") .. ")")
+    return true, nil
 end
 
 -- 从文件编译
-function ProjectCompiler:compile_from_file(json_filepath, output_filepath)
+-- options.bytecode: 输出字节码；options.strip: 字节码去掉调试信息；
+-- options.cache: 工程内容未变化时跳过编译（在输出文件旁记录 .hash）；
+-- options.report: 输出优化前后的源码大小
+function ProjectCompiler:compile_from_file(json_filepath, output_filepath, options)
+    options = options or {}
+
     -- 读取JSON文件
     local file, err = io.open(json_filepath, "r")
     if not file then
@@ -604,6 +1713,12 @@ function ProjectCompiler:compile_from_file(json_filepath, output_filepath)
     if not content or #content == 0 then
         return false, "文件为空"
     end
+
+    local key = options.cache and cache_key(content, options) or nil
+    if key and cache_valid(output_filepath, key) then
+        print("[ProjectCompiler] 工程未变化，使用缓存: " .. output_filepath)
+        return true, nil
+    end
     
     -- 解析JSON
     local ok, project_data = pcall(json.decode, content)
@@ -617,46 +1732,179 @@ function ProjectCompiler:compile_from_file(json_filepath, output_filepath)
         return false, "编译失败: " .. (compile_err or "未知错误")
     end
     
-    -- 写入输出文件
-    local out_file, out_err = io.open(output_filepath, "w")
-    if not out_file then
-        return false, "无法创建输出文件: " .. (out_err or "未知错误")
+    if options.report then
+        print_optimize_report(self, project_data, #lua_code)
     end
     
-    out_file:write(lua_code)
-    out_file:close()
-    
-    print("[ProjectCompiler] 编译完成: " .. output_filepath)
-    
-    return true, nil
+    -- 写入输出文件
+    return write_output(lua_code, output_filepath, options, key)
 end
 
--- 从工程数据编译并保存
-function ProjectCompiler:compile_and_save(project_data, output_filepath)
+-- 从工程数据编译并保存，options 同 compile_from_file
+function ProjectCompiler:compile_and_save(project_data, output_filepath, options)
+    options = options or {}
+
+    local key = nil
+    if options.cache then
+        local ok, content = pcall(json.encode, project_data)
+        if ok then
+            key = cache_key(content, options)
+            if cache_valid(output_filepath, key) then
+                print("[ProjectCompiler] 工程未变化，使用缓存: " .. output_filepath)
+                return true, nil
+            end
+        end
+    end
+
     local lua_code, compile_err = self:compile(project_data)
     if not lua_code then
         return false, "编译失败: " .. (compile_err or "未知错误")
     end
+    if options.report then
+        print_optimize_report(self, project_data, #lua_code)
+    end
     
     -- 确保输出目录存在
     local dir = output_filepath:match("(.+)[/\\]")
     if dir then
-        local cmd = 'if not exist "' .. dir .. '" mkdir "' .. dir .. '"'
-        os.execute(cmd)
+        ensure_dir(dir)
     end
     
     -- 写入输出文件
-    local out_file, out_err = io.open(output_filepath, "w")
-    if not out_file then
-        return false, "无法创建输出文件: " .. (out_err or "未知错误")
+    return write_output(lua_code, output_filepath, options, key)
+end
+
+-- 读取分页编译的清单：文件名 -> 图页哈希
+local function read_manifest(path)
+    local manifest = {}
+    local f = io.open(path, "r")
+    if not f then
+        return manifest
     end
-    
-    out_file:write(lua_code)
-    out_file:close()
-    
-    print("[ProjectCompiler] 编译完成: " .. output_filepath)
-    
-    return true, nil
+    for line in f:lines() do
+        local file, hash = line:match("^(%S+) (%x+)$")
+        if file then
+            manifest[file] = hash
+        end
+    end
+    f:close()
+    return manifest
+end
+
+-- 分页编译并保存：根脚本写入 output_filepath，每个图页的模块写入旁边的 <名称>_pages 目录，
+-- 目录中的 manifest 记录每个图页的哈希，只重新生成哈希变化的图页，删除多余的图页模块。
+-- 根脚本按仿真器传入的脚本路径查找图页目录；options 同 compile_from_file（不输出优化报告）。
+-- 成功时第三个返回值为 { pages, changed, root_hash }，root_hash 是根脚本内容（不含生成时间）的哈希：
+-- 与正在运行的仿真器启动时的根脚本相同时，仿真器热重载变化的图页即可，无需重新启动
+function ProjectCompiler:compile_split(project_data, output_filepath, options)
+    options = options or {}
+    local dir = output_filepath:match("^(.*[/\\])") or ""
+    local name = (output_filepath:match("([^/\\]+)$") or output_filepath):gsub("%.[^.]*$", "")
+    local pages_dir_name = name .. "_pages/"
+    local pages_dir = dir .. pages_dir_name
+    local manifest_path = pages_dir .. "manifest"
+
+    -- 每个图页只序列化一次，同时用于图页哈希和整个工程的缓存键
+    local page_json = {}
+    local ok, content = pcall(function()
+        local parts = {}
+        for i, page in ipairs(project_data.pages or {}) do
+            page_json[i] = json.encode(page)
+            parts[i] = lv.hash(page_json[i])
+        end
+        local rest = {}
+        for k, v in pairs(project_data) do
+            if k ~= "pages" then
+                rest[k] = v
+            end
+        end
+        return json.encode(rest) .. "\0" .. table.concat(parts, "\0")
+    end)
+    if not ok then
+        return false, "工程数据无法序列化: " .. tostring(content)
+    end
+
+    local key = nil
+    if options.cache then
+        key = cache_key(content, { bytecode = options.bytecode, strip = options.strip, split = true },
+            table.concat(page_json, "\0"))
+        if cache_valid(output_filepath, key) and file_exists(manifest_path) then
+            print("[ProjectCompiler] 工程未变化，使用缓存: " .. output_filepath)
+            return true, nil, { pages = #page_json, changed = 0, root_hash = self.root_hashes and self.root_hashes[output_filepath] }
+        end
+    end
+
+    ensure_dir(pages_dir)
+    local manifest = read_manifest(manifest_path)
+    local previous = {}
+    for i = 1, #(project_data.pages or {}) do
+        local file = page_file_name(i)
+        if manifest[file] and file_exists(pages_dir .. file) then
+            previous[i] = manifest[file]
+        end
+    end
+
+    local lua_code, compile_err = self:compile(project_data, {
+        split = { dir = pages_dir_name, page_json = page_json, previous = previous, format = output_format(options) },
+    })
+    if not lua_code then
+        return false, "编译失败: " .. (compile_err or "未知错误")
+    end
+
+    -- 写入变化的图页模块
+    local modules = self.page_modules
+    local changed = 0
+    local current = {}
+    local manifest_lines = {}
+    for _, module in ipairs(modules) do
+        if module.code then
+            local ok, err = write_output(module.code, pages_dir .. module.file, options)
+            if not ok then
+                return false, err
+            end
+            changed = changed + 1
+        end
+        current[module.file] = true
+        manifest_lines[#manifest_lines + 1] = module.file .. " " .. module.hash
+    end
+
+    -- 删除已不存在的图页的模块
+    for file in pairs(manifest) do
+        if not current[file] then
+            os.remove(pages_dir .. file)
+        end
+    end
+
+    print(string.format("[ProjectCompiler] 分页编译: %d 个图页, 重新生成 %d 个", #modules, changed))
+    local write_ok, write_err = write_output(lua_code, output_filepath, options, key)
+    if not write_ok then
+        return false, write_err
+    end
+
+    -- 清单最后写入：运行中的模拟器看到新清单时图页模块和根脚本都已写完。
+    -- 先写临时文件再改名，监视方不会读到写了一半的清单
+    local temp_path = manifest_path .. ".tmp"
+    local manifest_file, manifest_err = io.open(temp_path, "w")
+    if not manifest_file then
+        os.remove(manifest_path)
+        return false, "无法写入图页清单: " .. (manifest_err or "未知错误")
+    end
+    manifest_file:write(table.concat(manifest_lines, "\n"), "\n")
+    manifest_file:close()
+    -- POSIX 的 rename 原子地替换旧文件；Windows 上 os.rename 不覆盖已有文件，只能先删除
+    if package.config:sub(1, 1) == "\\" then
+        os.remove(manifest_path)
+    end
+    local renamed, rename_err = os.rename(temp_path, manifest_path)
+    if not renamed then
+        os.remove(temp_path)
+        return false, "无法写入图页清单: " .. (rename_err or "未知错误")
+    end
+
+    local root_hash = lv.hash((lua_code:gsub("%-%- 生成时间: [^\n]*\n", "", 1)))
+    self.root_hashes = self.root_hashes or {}
+    self.root_hashes[output_filepath] = root_hash
+    return true, nil, { pages = #modules, changed = changed, root_hash = root_hash }
 end
 
 return ProjectCompiler
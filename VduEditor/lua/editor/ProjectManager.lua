@@ -107,6 +107,8 @@ function ProjectManager:export_project_data(editor)
             end
             
             canvas_list:update_page_data(current_index, widgets_data)
+            -- 画布缓存的控件与新的图页数据一致
+            canvas:set_page_source(current_page, widgets_data)
         end
     end
     
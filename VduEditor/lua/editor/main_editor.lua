@@ -123,6 +123,13 @@ local project_compiler = ProjectCompiler.new()
 
 -- 仿真进程管理
 local simulator_process = nil  -- 存储仿真进程句柄/PID
+local simulator_script_path = nil  -- 仿真器运行的根脚本
+local simulator_root_hash = nil    -- 仿真器启动时根脚本的哈希（相同时只需热重载图页）
+local simulator_preview = nil      -- 进程内仿真预览（lv.preview_start 返回的对象）
+
+-- 在编辑器进程内运行仿真（独立的 Lua 状态和显示器，共享已加载的字体和图片缓存），
+-- 不支持时回退为启动 vdu_sim.exe
+local USE_IN_PROCESS_PREVIEW = true
 
 -- 当前活动的图页索引
 local current_page_index = 0
@@ -327,13 +334,17 @@ end
 
 -- ========== 保存/加载画布状态 ==========
 
-local function save_canvas_to_page(page_index)
-    if page_index < 1 then return end
+-- 画布为每个最近使用的图页保留控件，切换图页时不保存也不重新创建；
+-- 保存工程时才把缓存图页的控件写回图页数据
+
+-- 把图页 page_data 缓存的控件写回图页数据
+local function save_cached_page(page_index, page_data)
+    if not canvas:is_page_cached(page_data, page_data.widgets) then return end
     
-    local state = canvas:export_state()
+    local state = canvas:export_state(page_data)
     if state and state.widgets then
         local widgets_data = {}
-        local current_widgets = canvas:get_widgets()
+        local current_widgets = canvas:get_widgets(page_data)
         
         for i, widget_state in ipairs(state.widgets) do
             local widget_entry = current_widgets[i]
@@ -354,8 +365,16 @@ local function save_canvas_to_page(page_index)
         end
         
         left_panel:update_page_data(page_index, widgets_data)
-        print("[编辑器] 保存画布到图页 " .. page_index)
+        canvas:set_page_source(page_data, widgets_data)
+    end
+end
+
+-- 把所有缓存图页的控件写回图页数据（保存工程前调用）
+local function save_cached_pages()
+    for i, page_data in ipairs(left_panel:get_pages()) do
+        save_cached_page(i, page_data)
     end
+    print("[编辑器] 保存画布到图页")
 end
 
 local function load_canvas_from_page(page_index)
@@ -364,7 +383,10 @@ local function load_canvas_from_page(page_index)
     local page_data = left_panel:get_page_data(page_index)
     if not page_data then return end
     
-    canvas:clear()
+    -- 缓存的图页直接显示
+    if canvas:show_page(page_data, page_data.widgets) then
+        return
+    end
     
     if page_data.widgets and #page_data.widgets > 0 then
         for _, widget_data in ipairs(page_data.widgets) do
@@ -387,6 +409,17 @@ end
 -- 创建默认图页
 left_panel:add_page("图页 1")
 current_page_index = 1
+load_canvas_from_page(current_page_index)
+
+-- 缓存的图页被释放前写回图页数据
+canvas:on("page_evicting", function(self, page_data)
+    for i, page in ipairs(left_panel:get_pages()) do
+        if page == page_data then
+            save_cached_page(i, page_data)
+            break
+        end
+    end
+end)
 
 -- 初始化画布的图页边界线（使用默认图页的宽高）
 local default_page_data = left_panel:get_page_data(1)
@@ -414,7 +447,7 @@ _G.Editor = {
 -- ========== 工程保存/加载功能 ==========
 
 local function save_project_dialog()
-    save_canvas_to_page(current_page_index)
+    save_cached_pages()
     
     local current_path = project_manager:get_current_path()
     local default_filename = "project.json"
@@ -466,7 +499,7 @@ end
 local function quick_save()
     local current_path = project_manager:get_current_path()
     if current_path then
-        save_canvas_to_page(current_page_index)
+        save_cached_pages()
         local project_data = project_manager:export_project_data(_G.Editor)
         local success, err = project_manager:save_project(current_path, project_data)
         if success then
@@ -479,7 +512,7 @@ local function quick_save()
     else
         -- 如果没有当前路径，使用默认路径保存
         local default_path = "projects/project.json"
-        save_canvas_to_page(current_page_index)
+        save_cached_pages()
         local project_data = project_manager:export_project_data(_G.Editor)
         local success, err = project_manager:save_project(default_path, project_data)
         if success then
@@ -511,20 +544,27 @@ local function compile_project()
         return false, nil
     end
     
-    -- 3. 确定输出文件路径（与JSON文件同目录，扩展名改为.lua）
-    local output_path = save_path:gsub("%.json$", ".lua")
+    -- 3. 确定输出文件路径（与JSON文件同目录，扩展名改为.luac，
+    --    工程 settings.bytecode = false 时输出 .lua 源码；图页模块在旁边的 <名称>_pages 目录）
+    local bytecode = not (project_data.settings and project_data.settings.bytecode == false)
+    local ext = bytecode and ".luac" or ".lua"
+    local output_path = save_path:gsub("%.json$", ext)
     if output_path == save_path then
-        -- 如果没有.json扩展名，直接添加.lua
-        output_path = save_path .. ".lua"
+        -- 如果没有.json扩展名，直接添加扩展名
+        output_path = save_path .. ext
     end
     
-    -- 4. 编译并保存
-    local success, err = project_compiler:compile_and_save(project_data, output_path)
+    -- 4. 分页编译并保存（工程未变化时直接使用上次的输出，否则只重新生成内容变化的图页）
+    local success, err, info = project_compiler:compile_split(project_data, output_path, {
+        bytecode = bytecode,
+        strip = true,
+        cache = true,
+    })
     if success then
         print("[编辑器] ========== 编译成功 ==========")
         print("[编辑器] 输出文件: " .. output_path)
         print("[编辑器] 图页数量: " .. #(project_data.pages or {}))
-        return true, output_path
+        return true, output_path, info
     else
         print("[编辑器] ========== 编译失败 ==========")
         print("[编辑器] 错误: " .. (err or "未知错误"))
@@ -569,6 +609,12 @@ end
 
 -- 停止仿真
 local function stop_simulator()
+    if simulator_preview then
+        simulator_preview:stop()
+        simulator_preview = nil
+        print("[仿真] 仿真预览已停止")
+        return true
+    end
     if not simulator_process then
         print("[仿真] 没有正在运行的仿真进程")
         return true
@@ -599,23 +645,59 @@ local function stop_simulator()
     return true
 end
 
+-- 在编辑器进程内启动仿真预览
+local function start_preview(compiled_script_path, compile_info)
+    if simulator_preview and simulator_preview:is_running() then
+        -- 预览中的根脚本同样监视图页目录，根脚本未变化时只需热重载图页
+        if compile_info and compile_info.root_hash and compile_info.root_hash == simulator_root_hash
+            and compiled_script_path == simulator_script_path then
+            print("[仿真] 仿真预览正在运行，热重载 " .. compile_info.changed .. " 个变化的图页")
+            return true
+        end
+        print("[仿真] 工程结构已变化，重新启动仿真预览...")
+    end
+    stop_simulator()
+
+    local start = lv.time_us()
+    local preview, err = lv.preview_start(compiled_script_path, 1024, 768)
+    if not preview then
+        print("[仿真] 启动失败: " .. tostring(err))
+        return false
+    end
+    simulator_preview = preview
+    simulator_script_path = compiled_script_path
+    simulator_root_hash = compile_info and compile_info.root_hash
+    print(string.format("[仿真] ========== 仿真预览已启动 (%.1f ms) ==========",
+        (lv.time_us() - start) / 1000))
+    return true
+end
+
 -- 启动仿真
 local function start_simulator()
-    -- 如果仿真器已在运行，先停止
-    if is_simulator_running() then
-        print("[仿真] 检测到仿真器正在运行，先停止...")
-        stop_simulator()
-    end
-    
     print("[仿真] ========== 启动仿真 ==========")
     
     -- 1. 先编译工程
-    local compile_success, compiled_script_path = compile_project()
+    local compile_success, compiled_script_path, compile_info = compile_project()
     if not compile_success or not compiled_script_path then
         print("[仿真] 启动失败: 编译工程失败")
         return false
     end
     
+    if USE_IN_PROCESS_PREVIEW and lv.preview_start then
+        return start_preview(compiled_script_path, compile_info)
+    end
+    
+    -- 仿真器已在运行且根脚本未变化时，仿真器监视图页目录并热重载变化的图页，无需重新启动
+    if is_simulator_running() then
+        if compile_info and compile_info.root_hash and compile_info.root_hash == simulator_root_hash
+            and compiled_script_path == simulator_script_path then
+            print("[仿真] 仿真器正在运行，热重载 " .. compile_info.changed .. " 个变化的图页")
+            return true
+        end
+        print("[仿真] 工程结构已变化，重新启动仿真器...")
+        stop_simulator()
+    end
+    
     -- 2. 获取仿真器路径
     local sim_path = get_simulator_path()
     
@@ -627,41 +709,13 @@ local function start_simulator()
     end
     f:close()
     
-    -- 3. 将编译好的脚本复制到仿真器可访问的位置
-    -- 仿真器的 Lua 搜索路径是相对于其可执行文件的
-    -- 从编译输出路径中提取文件名
-    local script_filename = compiled_script_path:match("([^/\\]+)$") or "project.lua"
-    local sim_script_dir = APP_DIR .. "lua\\"
-    local sim_script_path = sim_script_dir .. script_filename
-    
-    -- 确保目录存在
-    os.execute('if not exist "' .. sim_script_dir .. '" mkdir "' .. sim_script_dir .. '"')
-    
-    -- 复制编译好的脚本
-    local src_file = io.open(compiled_script_path, "rb")
-    if not src_file then
-        print("[仿真] 启动失败: 无法读取编译后的脚本 - " .. compiled_script_path)
-        return false
-    end
-    
-    local content = src_file:read("*a")
-    src_file:close()
-    
-    local dst_file = io.open(sim_script_path, "wb")
-    if not dst_file then
-        print("[仿真] 启动失败: 无法写入仿真脚本 - " .. sim_script_path)
-        return false
-    end
-    
-    dst_file:write(content)
-    dst_file:close()
-    
-    print("[仿真] 脚本已复制到: " .. sim_script_path)
-    
-    -- 4. 构建命令行并启动仿真器
+    -- 3. 构建命令行并启动仿真器
+    -- 直接运行编译输出的根脚本，图页模块从根脚本旁边的目录按需加载，无需复制
+    -- （相对路径由仿真器按其可执行文件目录解析，与编辑器的工作目录相同）
     -- 使用 start 命令在新窗口中启动，并使用 wmic 获取进程ID
-    local script_arg = "lua\\" .. script_filename
-    local cmd = 'start "" "' .. sim_path .. '" "' .. script_arg .. '"'
+    local cmd = 'start "" "' .. sim_path .. '" "' .. compiled_script_path .. '"'
+    simulator_script_path = compiled_script_path
+    simulator_root_hash = compile_info and compile_info.root_hash
     
     print("[仿真] 执行命令: " .. cmd)
     os.execute(cmd)
@@ -670,7 +724,7 @@ local function start_simulator()
     local start_time = os.clock()
     while os.clock() - start_time < 0.5 do end
     
-    -- 5. 获取仿真器进程ID
+    -- 4. 获取仿真器进程ID
     local pid_cmd = 'wmic process where "name=\'vdu_sim.exe\'" get processid /format:value 2>nul'
     local pid_handle = io.popen(pid_cmd)
     if pid_handle then
@@ -698,6 +752,7 @@ menu_bar:on("menu_action", function(self, menu_key, item_id)
     if item_id == "new" then
         project_manager:new_project(_G.Editor)
         current_page_index = 1
+        load_canvas_from_page(current_page_index)
         print("新建工程")
     elseif item_id == "open" then
         open_project_dialog()
@@ -873,10 +928,6 @@ left_panel:on("page_selected", function(self, page_data, index)
         return
     end
     
-    if current_page_index > 0 and current_page_index <= left_panel:get_page_count() then
-        save_canvas_to_page(current_page_index)
-    end
-    
     current_page_index = index
     load_canvas_from_page(index)
     
@@ -903,6 +954,7 @@ end)
 
 left_panel:on("page_deleted", function(self, page_data, deleted_index)
     print("[左侧面板] 删除图页: " .. page_data.name)
+    canvas:drop_page(page_data)
     
     if deleted_index == current_page_index then
         current_page_index = 0
@@ -0,0 +1,267 @@
+﻿-- bench.lua
+-- 绑定层微基准测试：方法调用、对象包装、对象有效性检查、事件分发、定时器分发和图页创建，
+-- 每项自动确定迭代次数，重复多次取中位数，结果写入 JSON，并可与基线 JSON 比较。
+
+local lv = require("lvgl")
+local json = require("json")
+local PageRenderer = require("page_renderer")
+
+local Bench = {}
+
+Bench.DEFAULT_TARGET_MS = 100     -- 每次测量的目标时长
+Bench.DEFAULT_REPEATS = 5         -- 每项重复测量次数
+Bench.DEFAULT_THRESHOLD_PCT = 15  -- 比基线慢超过该比例视为退化
+
+-- check_lv_obj 测试的对象数量
+local CHECK_OBJ_COUNTS = { 10, 100, 1000, 10000 }
+
+-- 定时器分发测试的定时器数量
+local TIMER_COUNT = 100
+
+local function noop() end
+
+-- 计时 fn(n)，fn 返回 nil 时按墙钟计算每次耗时，返回数字时直接作为每次耗时（纳秒）
+local function measure_once(fn, n)
+    collectgarbage()
+    local t0 = lv.time_us()
+    local ns = fn(n)
+    local elapsed_us = lv.time_us() - t0
+    return ns or elapsed_us * 1000 / n, elapsed_us
+end
+
+-- 迭代次数翻倍直到单次测量达到目标时长，然后重复测量取中位数
+local function run_case(case, options)
+    local n = case.min_iterations or 1
+    local target_us = options.target_ms * 1000
+    while true do
+        local _, elapsed_us = measure_once(case.fn, n)
+        if elapsed_us >= target_us or n >= (case.max_iterations or 1e8) then break end
+        local scale = elapsed_us > 0 and math.ceil(target_us / elapsed_us * 1.2) or 10
+        n = math.min(n * math.max(2, math.min(scale, 100)), case.max_iterations or 1e8)
+    end
+
+    local samples = {}
+    for i = 1, options.repeats do
+        samples[i] = measure_once(case.fn, n)
+    end
+    table.sort(samples)
+    return {
+        name = case.name,
+        ns_per_op = samples[(#samples + 1) // 2],
+        min_ns = samples[1],
+        max_ns = samples[#samples],
+        iterations = n,
+    }
+end
+
+-- 在容器中创建 count 个对象，返回最后创建的对象（有效性检查时最后被找到）
+local function create_objects(parent, count)
+    local last
+    for _ = 1, count do
+        last = lv.obj_create(parent)
+    end
+    return last
+end
+
+-- 基准测试项
+local function build_cases(scr, options)
+    local cases = {}
+    local cleanup = {}
+    local function add(name, fn, extra)
+        local case = extra or {}
+        case.name = name
+        case.fn = fn
+        cases[#cases + 1] = case
+    end
+
+    local host = lv.obj_create(scr)
+    cleanup[#cleanup + 1] = host
+    local obj = lv.obj_create(host)
+
+    -- 方法调用（Lua -> C 绑定 -> LVGL）
+    add("method/set_pos", function(n)
+        for i = 1, n do
+            obj:set_pos(i & 63, 0)
+        end
+    end)
+    add("method/set_style_bg_color", function(n)
+        for i = 1, n do
+            obj:set_style_bg_color((i & 1) == 0 and 0x2196F3 or 0xFF5722, 0)
+        end
+    end)
+    add("method/get_parent", function(n)
+        for _ = 1, n do
+            obj:get_parent()
+        end
+    end)
+
+    -- push_lv_obj：每次分配一个 userdata
+    add("native/push_lv_obj", function(n)
+        return lv.bench_push_obj(obj, n)
+    end)
+
+    -- check_lv_obj：lv_obj_is_valid 遍历对象树，耗时随对象数量增长
+    for _, count in ipairs(CHECK_OBJ_COUNTS) do
+        add("native/check_lv_obj/" .. count, function(n)
+            return lv.bench_check_obj(options.check_targets[count], n)
+        end)
+    end
+
+    -- 事件分发：obj:send_event -> lv_obj_send_event -> Lua 回调
+    local event_obj = lv.obj_create(host)
+    event_obj:add_event_cb(noop, lv.EVENT_VALUE_CHANGED)
+    add("event/dispatch", function(n)
+        for _ = 1, n do
+            event_obj:send_event(lv.EVENT_VALUE_CHANGED)
+        end
+    end)
+
+    -- 定时器分发：周期为 0 的定时器每次 timer_handler 都会执行，扣除空载 timer_handler 的耗时
+    add("timer/dispatch", function(n)
+        local t0 = lv.time_us()
+        for _ = 1, n do
+            lv.timer_handler()
+        end
+        local idle_us = lv.time_us() - t0
+
+        local timers = {}
+        for i = 1, TIMER_COUNT do
+            timers[i] = lv.timer_create(noop, 0)
+        end
+        t0 = lv.time_us()
+        for _ = 1, n do
+            lv.timer_handler()
+        end
+        local busy_us = lv.time_us() - t0
+        for i = 1, TIMER_COUNT do
+            lv.timer_delete(timers[i])
+        end
+        return math.max(busy_us - idle_us, 0) * 1000 / (n * TIMER_COUNT)
+    end, { max_iterations = 100000 })
+
+    -- 图页创建：加载编译后的工程脚本，逐个创建并删除图页（与批量渲染相同，删除时解除绑定）
+    if options.pages then
+        for index, page in ipairs(options.pages) do
+            add(string.format("page/%03d %s", index, page.name or ""), function(n)
+                for _ = 1, n do
+                    local ok, container = PageRenderer.create_page(scr, page)
+                    if not ok or not container then
+                        error("图页创建失败: " .. tostring(container), 0)
+                    end
+                    container:delete()
+                end
+            end, { max_iterations = 10000 })
+        end
+    end
+
+    return cases, cleanup
+end
+
+local function read_json(path)
+    local file = io.open(path, "rb")
+    if not file then
+        return nil
+    end
+    local text = file:read("a")
+    file:close()
+    local ok, data = pcall(json.decode, text)
+    return ok and data or nil
+end
+
+-- 与基线比较，返回退化的测试项数量
+-- 比较各项的最小值，最小值受调度和缓存干扰最少
+function Bench.compare(results, baseline, threshold_pct)
+    local base = {}
+    for _, r in ipairs(baseline.results or {}) do
+        base[r.name] = r
+    end
+    local regressions = 0
+    print(string.format("%-36s %14s %14s %9s", "benchmark (min)", "baseline ns", "current ns", "delta"))
+    for _, r in ipairs(results) do
+        local b = base[r.name]
+        local b_ns = b and (b.min_ns or b.ns_per_op)
+        if b_ns and b_ns > 0 then
+            local delta = (r.min_ns - b_ns) * 100 / b_ns
+            local slower = delta > threshold_pct
+            if slower then regressions = regressions + 1 end
+            print(string.format("%-36s %14.1f %14.1f %+8.1f%%%s", r.name, b_ns, r.min_ns, delta,
+                slower and "  REGRESSION" or ""))
+        else
+            print(string.format("%-36s %14s %14.1f %9s", r.name, "-", r.min_ns, "new"))
+        end
+    end
+    return regressions
+end
+
+-- options: output, baseline, project, filter, threshold_pct, target_ms, repeats
+-- 返回退化数量（没有基线时为 0），失败返回 nil 和错误信息
+function Bench.run(options)
+    options.target_ms = options.target_ms or Bench.DEFAULT_TARGET_MS
+    options.repeats = options.repeats or Bench.DEFAULT_REPEATS
+    options.threshold_pct = options.threshold_pct or Bench.DEFAULT_THRESHOLD_PCT
+
+    local scr = lv.scr_act()
+    lv.sysmon_set_visible(false)
+
+    if options.project then
+        local page_manager, err = PageRenderer.load_project(options.project)
+        if not page_manager then
+            return nil, err
+        end
+        options.pages = page_manager.pages
+    end
+
+    -- check_lv_obj 的对象树只在对应测试项测量期间存在
+    options.check_targets = {}
+
+    local cases, cleanup = build_cases(scr, options)
+    local results = {}
+    for _, case in ipairs(cases) do
+        if not options.filter or case.name:find(options.filter) then
+            local count = tonumber(case.name:match("^native/check_lv_obj/(%d+)$"))
+            local tree
+            if count then
+                tree = lv.obj_create(scr)
+                options.check_targets[count] = create_objects(tree, count)
+            end
+            local result = run_case(case, options)
+            if tree then
+                tree:delete()
+            end
+            results[#results + 1] = result
+            print(string.format("[Bench] %-36s %12.1f ns/op (min %.1f, %d iterations)",
+                result.name, result.ns_per_op, result.min_ns, result.iterations))
+        end
+    end
+    for _, obj in ipairs(cleanup) do
+        obj:delete()
+    end
+
+    local report = {
+        version = 1,
+        date = os.date("!%Y-%m-%dT%H:%M:%SZ"),
+        lua = _VERSION,
+        project = options.project,
+        results = results,
+    }
+    if options.output then
+        local file, err = io.open(options.output, "wb")
+        if not file then
+            return nil, err
+        end
+        file:write(json.encode(report, true), "\n")
+        file:close()
+        print("[Bench] 结果已写入 " .. options.output)
+    end
+
+    if not options.baseline then
+        return 0
+    end
+    local baseline = read_json(options.baseline)
+    if not baseline then
+        return nil, "无法读取基线: " .. options.baseline
+    end
+    return Bench.compare(results, baseline, options.threshold_pct)
+end
+
+return Bench
@@ -0,0 +1,198 @@
+﻿-- golden.lua
+-- 图像回归测试：把工程 JSON 编译为脚本，由 VduSimulator 批量渲染后，
+-- 与参考目录中的截图按容差逐像素比较，并与参考计时（多次计时的最小值）比较。
+-- 像素差异超限算失败；耗时变慢默认只给出警告，指定 perf_pct（--perf-threshold）时才算失败。
+-- 噪声下限 perf_floor_ms（--perf-floor-ms）默认只用于只警告模式，严格模式下不设下限。
+
+local lv = require("lvgl")
+local ProjectCompiler = require("ProjectCompiler")
+
+local Golden = {}
+
+-- 默认阈值
+Golden.DEFAULT_TOLERANCE = 8        -- 单个通道允许的差值
+Golden.DEFAULT_MAX_DIFF_PCT = 0.1   -- 允许的差异像素比例（%）
+Golden.DEFAULT_PERF_PCT = 20        -- 允许的耗时增长（%）
+Golden.DEFAULT_PERF_FLOOR_MS = 2    -- 只警告模式下，小于该增量的耗时变化视为噪声
+
+-- 编译工程 JSON
+function Golden.compile(json_path, script_path)
+    return ProjectCompiler.new():compile_from_file(json_path, script_path)
+end
+
+-- 解析一行 CSV（支持双引号字段）
+local function parse_csv_line(line)
+    local fields = {}
+    local pos = 1
+    while pos <= #line + 1 do
+        if line:sub(pos, pos) == '"' then
+            local value = ""
+            pos = pos + 1
+            while true do
+                local quote = line:find('"', pos, true)
+                if not quote then
+                    value = value .. line:sub(pos)
+                    pos = #line + 2
+                    break
+                end
+                value = value .. line:sub(pos, quote - 1)
+                if line:sub(quote + 1, quote + 1) == '"' then
+                    value = value .. '"'
+                    pos = quote + 2
+                else
+                    pos = quote + 2
+                    break
+                end
+            end
+            fields[#fields + 1] = value
+        else
+            local comma = line:find(",", pos, true) or (#line + 1)
+            fields[#fields + 1] = line:sub(pos, comma - 1)
+            pos = comma + 1
+        end
+    end
+    return fields
+end
+
+-- 读取 timing.csv，返回 index -> 行
+local function read_timing(path)
+    local file = io.open(path, "r")
+    if not file then
+        return nil
+    end
+    local rows = {}
+    local header = true
+    for line in file:lines() do
+        if header then
+            header = false
+        elseif line ~= "" then
+            local f = parse_csv_line(line)
+            rows[tonumber(f[1])] = {
+                index = tonumber(f[1]),
+                name = f[2],
+                instantiate_ms = tonumber(f[3]) or 0,
+                render_ms = tonumber(f[4]) or 0,
+                objects = tonumber(f[5]) or 0,
+                image = f[6],
+            }
+        end
+    end
+    file:close()
+    return rows
+end
+
+local function copy_file(src, dst)
+    local input = io.open(src, "rb")
+    if not input then
+        return false
+    end
+    local data = input:read("a")
+    input:close()
+    local output = io.open(dst, "wb")
+    if not output then
+        return false
+    end
+    output:write(data)
+    output:close()
+    return true
+end
+
+-- 耗时是否退化
+local function perf_regressed(new_ms, ref_ms, options)
+    return new_ms - ref_ms > options.perf_floor_ms and new_ms > ref_ms * (1 + options.perf_pct / 100)
+end
+
+local function delta_text(new_ms, ref_ms)
+    if ref_ms <= 0 then
+        return string.format("%.2f ms", new_ms)
+    end
+    return string.format("%.2f ms (%+.0f%%)", new_ms, (new_ms - ref_ms) * 100 / ref_ms)
+end
+
+-- 比较一个工程的渲染结果
+-- options: name, out_dir, ref_dir, update, tolerance, max_diff_pct, perf_pct, perf_floor_ms
+-- 返回失败数量
+function Golden.compare(options)
+    local perf_strict = options.perf_pct ~= nil
+    options.tolerance = options.tolerance or Golden.DEFAULT_TOLERANCE
+    options.max_diff_pct = options.max_diff_pct or Golden.DEFAULT_MAX_DIFF_PCT
+    options.perf_pct = options.perf_pct or Golden.DEFAULT_PERF_PCT
+    options.perf_floor_ms = options.perf_floor_ms or (perf_strict and 0 or Golden.DEFAULT_PERF_FLOOR_MS)
+
+    local actual = read_timing(options.out_dir .. "/timing.csv")
+    if not actual then
+        print("[Golden] " .. options.name .. ": 没有渲染结果")
+        return 1
+    end
+
+    -- 更新参考数据
+    if options.update then
+        local count = 0
+        copy_file(options.out_dir .. "/timing.csv", options.ref_dir .. "/timing.csv")
+        for _, row in pairs(actual) do
+            if row.image ~= "" and copy_file(options.out_dir .. "/" .. row.image, options.ref_dir .. "/" .. row.image) then
+                count = count + 1
+            end
+        end
+        print("[Golden] " .. options.name .. ": 已更新 " .. count .. " 张参考图")
+        return 0
+    end
+
+    local ref = read_timing(options.ref_dir .. "/timing.csv")
+    if not ref then
+        print("[Golden] " .. options.name .. ": 没有参考数据，请先使用 --update 生成")
+        return 1
+    end
+
+    local failures = 0
+    local indices = {}
+    for index in pairs(ref) do indices[#indices + 1] = index end
+    for index in pairs(actual) do
+        if not ref[index] then indices[#indices + 1] = index end
+    end
+    table.sort(indices)
+
+    for _, index in ipairs(indices) do
+        local a, r = actual[index], ref[index]
+        local problems = {}
+        local warnings = {}
+        -- 耗时退化在非严格模式下只作为警告
+        local perf_problems = perf_strict and problems or warnings
+        if not a then
+            problems[#problems + 1] = "图页未渲染"
+        elseif not r then
+            problems[#problems + 1] = "参考中没有该图页"
+        else
+            local diff_path = options.out_dir .. string.format("/diff_%03d.png", index)
+            local result, err = lv.image_compare(options.out_dir .. "/" .. a.image, options.ref_dir .. "/" .. r.image,
+                options.tolerance, diff_path)
+            if not result then
+                problems[#problems + 1] = err
+            elseif result.diff_pct > options.max_diff_pct then
+                problems[#problems + 1] = string.format("像素差异 %.3f%% (%d 像素, 最大差值 %d), 见 %s",
+                    result.diff_pct, result.diff_pixels, result.max_delta, diff_path)
+            end
+            if perf_regressed(a.render_ms, r.render_ms, options) then
+                perf_problems[#perf_problems + 1] = "渲染变慢 " .. delta_text(a.render_ms, r.render_ms)
+            end
+            if perf_regressed(a.instantiate_ms, r.instantiate_ms, options) then
+                perf_problems[#perf_problems + 1] = "创建变慢 " .. delta_text(a.instantiate_ms, r.instantiate_ms)
+            end
+        end
+
+        local row = a or r
+        local timing = a and r and ("渲染 " .. delta_text(a.render_ms, r.render_ms) ..
+            ", 创建 " .. delta_text(a.instantiate_ms, r.instantiate_ms)) or ""
+        if #problems > 0 then
+            failures = failures + 1
+            print(string.format("[Golden] FAIL %s 图页 %d (%s): %s", options.name, index, row.name, table.concat(problems, "; ")))
+        elseif #warnings > 0 then
+            print(string.format("[Golden] warn %s 图页 %d (%s): %s", options.name, index, row.name, table.concat(warnings, "; ")))
+        else
+            print(string.format("[Golden] ok   %s 图页 %d (%s): %s", options.name, index, row.name, timing))
+        end
+    end
+    return failures
+end
+
+return Golden
@@ -0,0 +1,171 @@
+﻿-- page_renderer.lua
+-- 批量渲染：加载编译后的工程脚本（不自动启动），逐个创建图页并立即渲染，
+-- 保存截图并记录创建耗时、渲染耗时和对象数量。
+-- 多进程渲染时每个进程只处理 (序号 - 1) % shards == shard 的图页。
+-- 每个图页先创建并渲染一次预热（加载控件模块、字形缓存），再计时多次取最小值。
+
+local lv = require("lvgl")
+
+local PageRenderer = {}
+
+-- 每个图页的计时次数
+PageRenderer.SAMPLES = 5
+
+-- 统计对象及其所有子对象
+local function count_objects(obj)
+    local count = 1
+    for i = 0, obj:get_child_count() - 1 do
+        count = count + count_objects(obj:get_child(i))
+    end
+    return count
+end
+
+local function csv_field(text)
+    text = tostring(text)
+    if text:find('[,"\n]') then
+        return '"' .. text:gsub('"', '""') .. '"'
+    end
+    return text
+end
+
+-- 加载工程脚本，返回 PageManager（.json 工程先编译为临时脚本）
+function PageRenderer.load_project(project_path)
+    local script = project_path
+    if project_path:match("%.json$") then
+        local ProjectCompiler = require("ProjectCompiler")
+        script = os.tmpname()
+        local ok, err = ProjectCompiler.new():compile_from_file(project_path, script)
+        if not ok then
+            os.remove(script)
+            return nil, err
+        end
+    end
+    _G.VDU_NO_AUTOSTART = true
+    local chunk, err = loadfile(script)
+    if script ~= project_path then
+        os.remove(script)
+    end
+    if not chunk then
+        _G.VDU_NO_AUTOSTART = nil
+        return nil, err
+    end
+    -- 分页编译的根脚本用第一个参数定位 <名称>_pages/（去掉调试信息的字节码没有源文件路径）
+    local ok, result = pcall(chunk, script)
+    _G.VDU_NO_AUTOSTART = nil
+    if not ok then
+        return nil, result
+    end
+    local page_manager = type(result) == "table" and result or rawget(_G, "PageManager")
+    if not page_manager or not page_manager.pages then
+        return nil, "脚本没有定义 PageManager"
+    end
+    return page_manager
+end
+
+-- 创建图页，使用响应式绑定的工程在图页删除时解除本次创建的绑定
+-- 返回 pcall 的结果（成功标志, 容器或错误信息），基准测试也用它创建图页
+function PageRenderer.create_page(scr, page)
+    local reactive = package.loaded["sim.reactive"]
+    if not reactive then
+        return pcall(page.create, scr)
+    end
+    local ok, container, scope = pcall(reactive.collect, page.create, scr)
+    if ok and container then
+        container:add_event_cb(function()
+            reactive.dispose(scope)
+        end, lv.EVENT_DELETE)
+    end
+    return ok, container
+end
+
+-- 渲染一个图页，返回一行计时记录（创建失败返回 nil）和是否成功保存截图
+local function render_page(scr, index, page, out_dir, samples)
+    local instantiate_us, render_us = math.huge, math.huge
+    local container
+    -- 第 0 次为预热，不计时
+    for sample = 0, samples do
+        if container then
+            container:delete()
+        end
+        local t0 = lv.time_us()
+        local ok
+        ok, container = PageRenderer.create_page(scr, page)
+        local t1 = lv.time_us()
+        if not ok or not container then
+            print("[PageRenderer] 图页 " .. index .. " 创建失败: " .. tostring(container))
+            return nil
+        end
+
+        -- 整屏重绘，保证每个图页的渲染耗时可比
+        scr:invalidate()
+        lv.refr_now()
+        local t2 = lv.time_us()
+        if sample > 0 then
+            instantiate_us = math.min(instantiate_us, t1 - t0)
+            render_us = math.min(render_us, t2 - t1)
+        end
+    end
+
+    local image = string.format("page_%03d.png", index)
+    local saved, err = lv.display_save(out_dir .. "/" .. image)
+    if not saved then
+        saved = false
+        print("[PageRenderer] 图页 " .. index .. " 保存失败: " .. tostring(err))
+        image = ""
+    end
+
+    local objects = count_objects(container)
+    container:delete()
+
+    return table.concat({
+        tostring(index),
+        csv_field(page.name or ""),
+        string.format("%.3f", instantiate_us / 1000),
+        string.format("%.3f", render_us / 1000),
+        tostring(objects),
+        image,
+    }, ","), saved
+end
+
+-- options: project, out_dir, timing_path, shard (从 0 开始), shards, samples
+-- 返回成功渲染的图页数量、nil 和本分片应渲染的图页数量，失败返回 nil 和错误信息
+function PageRenderer.run(options)
+    local page_manager, err = PageRenderer.load_project(options.project)
+    if not page_manager then
+        return nil, err
+    end
+
+    local scr = lv.scr_act()
+    -- 截图中不需要性能/内存监视器
+    lv.sysmon_set_visible(false)
+    -- 旧版编译脚本会在加载时直接创建界面，先全部隐藏
+    for i = 0, scr:get_child_count() - 1 do
+        scr:get_child(i):add_flag(lv.OBJ_FLAG_HIDDEN)
+    end
+
+    local timing, open_err = io.open(options.timing_path, "w")
+    if not timing then
+        return nil, open_err
+    end
+
+    local shard = options.shard or 0
+    local shards = options.shards or 1
+    local samples = math.max(1, options.samples or PageRenderer.SAMPLES)
+    local rendered, assigned = 0, 0
+    for index, page in ipairs(page_manager.pages) do
+        if (index - 1) % shards == shard then
+            assigned = assigned + 1
+            local line, saved = render_page(scr, index, page, options.out_dir, samples)
+            if line then
+                timing:write(line, "\n")
+                if saved then
+                    rendered = rendered + 1
+                end
+            end
+        end
+    end
+    timing:close()
+    return rendered, nil, assigned
+end
+
+return PageRenderer
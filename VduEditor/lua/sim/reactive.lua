@@ -0,0 +1,303 @@
+﻿-- reactive.lua
+-- 响应式属性绑定运行时
+-- 编译器把 "=表达式" 形式的属性编译成函数并提取依赖的变量（tags.XXX），
+-- 运行时维护依赖图：变量变化时只标记依赖它的节点，在下一帧按拓扑层级顺序重新计算。
+
+local lv = require("lvgl")
+
+local Reactive = {}
+
+-- 每帧检查一次（与 LV_DEF_REFR_PERIOD 一致）
+local FLUSH_PERIOD_MS = 10
+
+-- 变量当前值
+local values = {}
+-- 变量名 -> { [node] = true }，读取该变量的节点
+local dependents = {}
+-- 变量名 -> 计算该变量的节点（计算变量）
+local producers = {}
+-- 按层级存放的脏节点：dirty[level] = { node, ... }
+local dirty = {}
+local dirty_count = 0
+local max_level = 0
+
+local flush_timer = nil
+local flushing = false
+
+-- 正在收集绑定的作用域（图页创建期间），图页销毁时统一解除
+-- 按协程区分：分段创建的图页在 yield 期间不会收集到其他代码创建的绑定
+local scopes = setmetatable({}, { __mode = "k" })
+
+-- 变量访问表：读取返回当前值，写入等同于 set_tag
+Reactive.tags = setmetatable({}, {
+    __index = function(_, name)
+        return values[name]
+    end,
+    __newindex = function(_, name, value)
+        Reactive.set_tag(name, value)
+    end,
+})
+
+-- 标记节点为脏，同一节点在一次刷新内只计算一次
+local function mark_dirty(node)
+    if node.dirty or node.disposed then return end
+    node.dirty = true
+    local bucket = dirty[node.level]
+    if not bucket then
+        bucket = {}
+        dirty[node.level] = bucket
+    end
+    bucket[#bucket + 1] = node
+    dirty_count = dirty_count + 1
+    if node.level > max_level then
+        max_level = node.level
+    end
+    if flush_timer and not flushing then
+        flush_timer:resume()
+    end
+end
+
+local function mark_dependents(name)
+    local deps = dependents[name]
+    if not deps then return end
+    for node in pairs(deps) do
+        mark_dirty(node)
+    end
+end
+
+-- 计算节点层级：源变量为 0，节点层级 = 依赖的计算变量层级最大值 + 1
+local function compute_level(node, visiting)
+    visiting = visiting or {}
+    if visiting[node] then
+        error("表达式存在循环依赖: " .. tostring(node.name))
+    end
+    visiting[node] = true
+    local level = 1
+    for _, dep in ipairs(node.deps) do
+        local producer = producers[dep]
+        if producer and producer ~= node then
+            local dep_level = compute_level(producer, visiting) + 1
+            if dep_level > level then
+                level = dep_level
+            end
+        elseif producer == node then
+            error("表达式存在循环依赖: " .. tostring(node.name))
+        end
+    end
+    visiting[node] = nil
+    return level
+end
+
+-- 图结构变化后重新计算所有节点的层级
+local function relevel_all()
+    local seen = {}
+    for _, deps in pairs(dependents) do
+        for node in pairs(deps) do
+            if not seen[node] then
+                seen[node] = true
+                node.level = compute_level(node)
+            end
+        end
+    end
+    -- 重新整理脏节点的层级桶
+    local pending = {}
+    for level = 1, max_level do
+        local bucket = dirty[level]
+        if bucket then
+            for _, node in ipairs(bucket) do
+                pending[#pending + 1] = node
+            end
+        end
+    end
+    dirty = {}
+    dirty_count = 0
+    max_level = 0
+    for _, node in ipairs(pending) do
+        node.dirty = false
+        mark_dirty(node)
+    end
+end
+
+local function register_node(node)
+    for _, dep in ipairs(node.deps) do
+        dependents[dep] = dependents[dep] or {}
+        dependents[dep][node] = true
+    end
+    if node.produces then
+        if producers[node.produces] then
+            error("变量重复定义: " .. node.produces)
+        end
+        producers[node.produces] = node
+    end
+    -- 计算变量会改变下游层级，需要整体重排
+    if node.produces then
+        relevel_all()
+    else
+        node.level = compute_level(node)
+    end
+    mark_dirty(node)
+end
+
+-- 计算单个节点
+local function evaluate(node)
+    node.dirty = false
+    if node.disposed then return end
+    local ok, result = pcall(node.fn, Reactive.tags)
+    if not ok then
+        if not node.error_reported then
+            print("[Reactive] 表达式计算失败 (" .. tostring(node.name) .. "): " .. tostring(result))
+            node.error_reported = true
+        end
+        return
+    end
+    node.error_reported = false
+    if node.initialized and result == node.value then
+        return
+    end
+    node.initialized = true
+    node.value = result
+    if node.produces then
+        Reactive.set_tag(node.produces, result)
+    elseif node.widget then
+        local set_ok, err = pcall(node.widget.set_property, node.widget, node.prop, result)
+        if not set_ok then
+            print("[Reactive] 属性设置失败 (" .. tostring(node.prop) .. "): " .. tostring(err))
+        end
+    end
+end
+
+-- 按层级顺序计算所有脏节点
+function Reactive.flush()
+    if flushing then return end
+    flushing = true
+    local level = 1
+    -- 计算过程中只会标记更高层级的节点，因此一次升序遍历即可
+    while dirty_count > 0 and level <= max_level do
+        local bucket = dirty[level]
+        if bucket then
+            dirty[level] = nil
+            dirty_count = dirty_count - #bucket
+            for _, node in ipairs(bucket) do
+                evaluate(node)
+            end
+        end
+        level = level + 1
+    end
+    flushing = false
+    -- 回调中又写入了已处理层级的变量时，剩余节点留到下一帧
+    if dirty_count == 0 then
+        dirty = {}
+        max_level = 0
+        if flush_timer then
+            flush_timer:pause()
+        end
+    elseif flush_timer then
+        flush_timer:resume()
+    end
+end
+
+-- 设置变量值，值变化时标记依赖节点
+function Reactive.set_tag(name, value)
+    if values[name] == value then return end
+    values[name] = value
+    mark_dependents(name)
+end
+
+-- 读取变量值
+function Reactive.get_tag(name)
+    return values[name]
+end
+
+-- 绑定控件属性：fn(tags) 的结果写入 widget:set_property(prop, value)
+-- deps 为表达式读取的变量名列表
+function Reactive.bind(widget, prop, fn, deps)
+    local node = {
+        name = prop,
+        widget = widget,
+        prop = prop,
+        fn = fn,
+        deps = deps or {},
+        level = 1,
+    }
+    register_node(node)
+    local scope = scopes[coroutine.running()]
+    if scope then
+        scope[#scope + 1] = node
+    end
+    return node
+end
+
+-- 定义计算变量：name = fn(tags)
+function Reactive.define_tag(name, fn, deps)
+    local node = {
+        name = name,
+        produces = name,
+        fn = fn,
+        deps = deps or {},
+        level = 1,
+    }
+    register_node(node)
+    return node
+end
+
+-- 解除绑定
+function Reactive.unbind(node)
+    if not node or node.disposed then return end
+    node.disposed = true
+    for _, dep in ipairs(node.deps) do
+        if dependents[dep] then
+            dependents[dep][node] = nil
+        end
+    end
+    if node.produces and producers[node.produces] == node then
+        producers[node.produces] = nil
+    end
+end
+
+-- 调用 fn(...) 并收集期间创建的控件绑定，返回 fn 的结果和绑定列表
+function Reactive.collect(fn, ...)
+    local co = coroutine.running()
+    local previous = scopes[co]
+    local scope = {}
+    scopes[co] = scope
+    local ok, result = pcall(fn, ...)
+    scopes[co] = previous
+    if not ok then
+        Reactive.dispose(scope)
+        error(result, 0)
+    end
+    return result, scope
+end
+
+-- 当前协程中正在收集绑定的作用域（不在 collect 内时为 nil）
+function Reactive.current_scope()
+    return scopes[coroutine.running()]
+end
+
+-- 解除 collect 收集的所有绑定
+function Reactive.dispose(scope)
+    for _, node in ipairs(scope) do
+        Reactive.unbind(node)
+    end
+end
+
+-- 启动每帧刷新定时器（没有脏节点时自动暂停）
+function Reactive.start(period)
+    if flush_timer then return end
+    flush_timer = lv.timer_create(function()
+        Reactive.flush()
+    end, period or FLUSH_PERIOD_MS)
+    if dirty_count == 0 then
+        flush_timer:pause()
+    end
+end
+
+-- 停止刷新定时器
+function Reactive.stop()
+    if flush_timer then
+        lv.timer_delete(flush_timer)
+        flush_timer = nil
+    end
+end
+
+return Reactive
@@ -0,0 +1,274 @@
+﻿-- scale_bench.lua
+-- 规模测试：按控件类型生成包含 N 个控件的工程 JSON，用 ProjectCompiler 编译，
+-- 测量编译耗时、加载耗时、每个控件的内存、K% 控件每秒更新时的帧耗时和图页切换耗时。
+-- 每个测量点由 VduSimulator 在独立进程中运行，结果追加到 CSV，用于绘制规模曲线。
+
+local lv = require("lvgl")
+local json = require("json")
+local ProjectCompiler = require("ProjectCompiler")
+
+local ScaleBench = {}
+
+-- 参与测试的控件模块（状态栏每个工程只有一个，不参与）
+ScaleBench.WIDGET_MODULES = {
+    "widgets.button",
+    "widgets.label",
+    "widgets.checkbox",
+    "widgets.dropdown",
+    "widgets.slider",
+    "widgets.valve",
+    "widgets.trend_chart",
+}
+
+ScaleBench.DEFAULT_UPDATE_PCT = 10  -- 每秒更新的控件比例（%）
+ScaleBench.FRAME_MS = 16            -- 每帧推进的时间
+ScaleBench.FRAMES = 120             -- 测量的帧数
+
+ScaleBench.CSV_HEADER = "type,widgets,json_kb,script_kb,compile_ms,parse_ms,create_ms,first_frame_ms," ..
+    "lua_bytes_per_widget,heap_bytes_per_widget,update_pct,frame_avg_ms,frame_p95_ms,frame_max_ms,switch_ms,error"
+
+-- 每种控件通过表达式绑定更新的属性，值由 value(i) 生成；没有的控件（趋势图）由自身定时器更新
+local UPDATE_PROPS = {
+    ["widgets.button"] = { name = "label", value = function(i) return "B" .. i end },
+    ["widgets.label"] = { name = "text", value = function(i) return "L" .. i end },
+    ["widgets.checkbox"] = { name = "checked", value = function(i) return i % 2 == 0 end },
+    ["widgets.dropdown"] = { name = "selected_index", value = function(i) return i % 3 end },
+    ["widgets.slider"] = { name = "value", value = function(i) return i % 101 end },
+    ["widgets.valve"] = { name = "angle", value = function(i) return (i * 7) % 91 end },
+}
+
+local PAGE_WIDTH = 1024
+local PAGE_HEIGHT = 768
+
+-- 控件类型名，例如 widgets.trend_chart -> trend_chart
+function ScaleBench.type_name(module_path)
+    return (module_path:gsub("^widgets%.", ""))
+end
+
+-- 属性默认值（取自控件元数据）
+local function default_props(meta)
+    local props = {}
+    for _, p in ipairs(meta.properties or {}) do
+        if p.default ~= nil then
+            props[p.name] = p.default
+        end
+    end
+    return props
+end
+
+-- 生成 count 个控件，按网格平铺，超出图页后从头重叠排列
+local function generate_widgets(module_path, meta, count, first_tag)
+    local base = default_props(meta)
+    local w = base.width or base.size or 100
+    local h = base.height or base.size or 40
+    local columns = math.max(1, PAGE_WIDTH // (w + 4))
+    local rows = math.max(1, PAGE_HEIGHT // (h + 4))
+    local update = UPDATE_PROPS[module_path]
+
+    local widgets = {}
+    for i = 1, count do
+        local props = {}
+        for k, v in pairs(base) do props[k] = v end
+        local cell = (i - 1) % (columns * rows)
+        props.x = (cell % columns) * (w + 4)
+        props.y = (cell // columns) * (h + 4)
+        props.instance_name = ""
+        props.design_mode = false
+        if update and first_tag then
+            props[update.name] = "=tags.s" .. (first_tag + i - 1)
+        end
+        widgets[i] = { type = meta.id, module_path = module_path, props = props }
+    end
+    return widgets
+end
+
+-- 生成工程：图页 1 的控件绑定变量 s1..sN，图页 2 为相同数量的静态控件，用于测量切换
+function ScaleBench.generate(module_path, count)
+    local meta = require(module_path).__widget_meta
+    local tags = {}
+    local update = UPDATE_PROPS[module_path]
+    if update then
+        for i = 1, count do
+            tags[i] = { name = "s" .. i, value = update.value(i) }
+        end
+    end
+    return {
+        version = "1.0",
+        settings = { window_width = PAGE_WIDTH, window_height = PAGE_HEIGHT },
+        tags = tags,
+        pages = {
+            { id = "page_1", name = "scale 1", width = PAGE_WIDTH, height = PAGE_HEIGHT, bg_color = "#1E1E1E",
+              widgets = generate_widgets(module_path, meta, count, 1) },
+            { id = "page_2", name = "scale 2", width = PAGE_WIDTH, height = PAGE_HEIGHT, bg_color = "#1E1E1E",
+              widgets = generate_widgets(module_path, meta, count, nil) },
+        },
+    }
+end
+
+local function file_size(path)
+    local file = io.open(path, "rb")
+    if not file then return 0 end
+    local size = file:seek("end")
+    file:close()
+    return size
+end
+
+local function heap_used()
+    return lv.perf_stats().heap_used or 0
+end
+
+local function lua_bytes()
+    return collectgarbage("count") * 1024
+end
+
+local function elapsed_ms(t0)
+    return (lv.time_us() - t0) / 1000
+end
+
+-- 推进一帧：虚拟时钟下推进时间，让控件定时器和刷新定时器到期
+local function frame()
+    if lv.clock_is_virtual() then
+        lv.clock_advance(ScaleBench.FRAME_MS)
+    end
+    lv.timer_handler()
+    lv.refr_now()
+end
+
+local function csv_row(r)
+    local function num(v, fmt)
+        return v and string.format(fmt or "%.3f", v) or ""
+    end
+    return table.concat({
+        r.type, tostring(r.widgets),
+        num(r.json_kb, "%.1f"), num(r.script_kb, "%.1f"),
+        num(r.compile_ms), num(r.parse_ms), num(r.create_ms), num(r.first_frame_ms),
+        num(r.lua_bytes_per_widget, "%.0f"), num(r.heap_bytes_per_widget, "%.0f"),
+        tostring(r.update_pct or ""),
+        num(r.frame_avg_ms), num(r.frame_p95_ms), num(r.frame_max_ms), num(r.switch_ms),
+        r.error and ('"' .. tostring(r.error):gsub('"', '""'):gsub("\n", " ") .. '"') or "",
+    }, ",")
+end
+
+-- 测量一个点，结果写入 r，出错时抛出错误
+local function measure(r, module_path, count, options)
+    local dir = options.work_dir
+    local json_path = dir .. "/scale_" .. r.type .. "_" .. count .. ".json"
+    local script_path = dir .. "/scale_" .. r.type .. "_" .. count .. ".lua"
+
+    local file = assert(io.open(json_path, "wb"))
+    file:write(json.encode(ScaleBench.generate(module_path, count)))
+    file:close()
+    r.json_kb = file_size(json_path) / 1024
+
+    -- 编译
+    collectgarbage()
+    local t0 = lv.time_us()
+    local ok, err = ProjectCompiler.new():compile_from_file(json_path, script_path)
+    r.compile_ms = elapsed_ms(t0)
+    os.remove(json_path)
+    if not ok then error(err, 0) end
+    r.script_kb = file_size(script_path) / 1024
+
+    -- 加载：解析脚本，再执行（定义图页函数和变量，不自动启动）
+    collectgarbage()
+    local lua_before = lua_bytes()
+    local heap_before = heap_used()
+    t0 = lv.time_us()
+    local chunk, load_err = loadfile(script_path)
+    r.parse_ms = elapsed_ms(t0)
+    os.remove(script_path)
+    if not chunk then error(load_err, 0) end
+    _G.VDU_NO_AUTOSTART = true
+    local page_manager = chunk()
+    _G.VDU_NO_AUTOSTART = nil
+    chunk = nil
+
+    -- 图页默认按需、分帧创建。这里一次创建完成并关闭预创建，
+    -- 保证计时和内存统计的都是完整的两个图页，且切换时两页都在缓存中
+    page_manager.build_budget_ms = 0
+    page_manager.prefetch = false
+    page_manager.set_cache_size(math.max(page_manager.cache_size, 1))
+
+    -- 创建两个图页，最后停在图页 1
+    local Reactive = require("sim.reactive")
+    t0 = lv.time_us()
+    page_manager.init()
+    page_manager.goto_page(2)
+    page_manager.goto_page(1)
+    Reactive.flush()
+    r.create_ms = elapsed_ms(t0)
+    t0 = lv.time_us()
+    lv.refr_now()
+    r.first_frame_ms = elapsed_ms(t0)
+
+    collectgarbage()
+    r.lua_bytes_per_widget = (lua_bytes() - lua_before) / (count * 2)
+    r.heap_bytes_per_widget = (heap_used() - heap_before) / (count * 2)
+
+    -- 帧耗时：每秒更新 update_pct% 的控件，更新分摊到每一帧
+    local update = UPDATE_PROPS[module_path]
+    local frames_per_s = 1000 / ScaleBench.FRAME_MS
+    local per_frame = update and math.ceil(count * options.update_pct / 100 / frames_per_s) or 0
+    r.update_pct = options.update_pct
+    local times = {}
+    local next_tag = 1
+    for f = 1, ScaleBench.FRAMES do
+        t0 = lv.time_us()
+        for _ = 1, per_frame do
+            Reactive.set_tag("s" .. next_tag, update.value(next_tag + f))
+            next_tag = next_tag % count + 1
+        end
+        Reactive.flush()
+        frame()
+        times[f] = elapsed_ms(t0)
+    end
+    table.sort(times)
+    local sum = 0
+    for _, t in ipairs(times) do sum = sum + t end
+    r.frame_avg_ms = sum / #times
+    r.frame_p95_ms = times[math.ceil(#times * 0.95)]
+    r.frame_max_ms = times[#times]
+
+    -- 图页切换：1 -> 2 -> 1，取平均
+    t0 = lv.time_us()
+    page_manager.goto_page(2)
+    lv.refr_now()
+    page_manager.goto_page(1)
+    lv.refr_now()
+    r.switch_ms = elapsed_ms(t0) / 2
+end
+
+-- 运行一个测量点并把结果追加到 options.csv
+-- options: module, count, csv, work_dir, update_pct
+function ScaleBench.run_point(options)
+    options.update_pct = options.update_pct or ScaleBench.DEFAULT_UPDATE_PCT
+    options.work_dir = options.work_dir or "."
+    lv.sysmon_set_visible(false)
+
+    local r = { type = ScaleBench.type_name(options.module), widgets = options.count }
+    local ok, err = pcall(measure, r, options.module, options.count, options)
+    if not ok then
+        r.error = err
+    end
+
+    local file, open_err = io.open(options.csv, "ab")
+    if not file then
+        return nil, open_err
+    end
+    file:write(csv_row(r), "\n")
+    file:close()
+    print(string.format("[Scale] %-12s %6d widgets: compile %.0f ms, create %.0f ms, frame %.2f ms, switch %.2f ms%s",
+        r.type, r.widgets, r.compile_ms or 0, r.create_ms or 0, r.frame_avg_ms or 0, r.switch_ms or 0,
+        r.error and (", error: " .. tostring(r.error)) or ""))
+    return ok
+end
+
+-- 写入失败行（进程崩溃或超时时由 VduSimulator 调用）
+function ScaleBench.write_failure(csv, module_path, count, reason)
+    local file = io.open(csv, "ab")
+    if not file then return end
+    file:write(csv_row({ type = ScaleBench.type_name(module_path), widgets = count, error = reason }), "\n")
+    file:close()
+end
+
+return ScaleBench
@@ -0,0 +1,223 @@
+﻿-- soak.lua
+-- 长时间运行测试：反复执行编辑器操作（添加控件、选中、修改属性、删除、清空画布）
+-- 并循环切换工程图页，每隔若干轮采样存活对象、定时器、Lua 注册表引用和内存，
+-- 预热之后对每项指标做最小二乘拟合，持续线性增长即判定为泄漏。
+
+local lv = require("lvgl")
+local CanvasArea = require("CanvasArea")
+local PageRenderer = require("page_renderer")
+
+local Soak = {}
+
+Soak.DEFAULT_CYCLES = 1000      -- 默认循环次数
+Soak.DEFAULT_SAMPLE_EVERY = 10  -- 每隔多少轮采样一次
+Soak.WARMUP_PCT = 20            -- 前百分之多少的样本作为预热，不参与拟合
+Soak.FRAMES_PER_CYCLE = 5       -- 每轮运行的帧数
+Soak.FRAME_MS = 16              -- 每帧推进的时间
+Soak.MIN_R2 = 0.5               -- 拟合优度低于该值视为波动而不是增长
+
+-- 参与判定的指标；per_1000 为拟合直线每千轮允许的最大增长
+Soak.METRICS = {
+    { name = "objects",   per_1000 = 1 },
+    { name = "timers",    per_1000 = 1 },
+    { name = "registry",  per_1000 = 1 },
+    { name = "lua_kb",    per_1000 = 8 },
+    { name = "heap_used", per_1000 = 16 * 1024 },
+}
+
+-- 每轮添加的控件
+Soak.WIDGET_MODULES = {
+    "widgets.button",
+    "widgets.label",
+    "widgets.checkbox",
+    "widgets.dropdown",
+    "widgets.slider",
+    "widgets.valve",
+    "widgets.trend_chart",
+}
+
+local function run_frames(count)
+    for _ = 1, count do
+        lv.clock_advance(Soak.FRAME_MS)
+        lv.timer_handler()
+    end
+end
+
+-- 样本按列存放在预先分配的数组中，避免采样本身造成 Lua 内存增长
+local function new_samples(capacity)
+    local samples = { count = 0, cycle = table.create(capacity) }
+    for _, metric in ipairs(Soak.METRICS) do
+        samples[metric.name] = table.create(capacity)
+    end
+    return samples
+end
+
+-- 完整回收后采样，finalizer 释放的资源在第二次回收时才真正释放
+local function sample(samples, cycle)
+    collectgarbage()
+    collectgarbage()
+    local stats = lv.resource_stats()
+    local i = samples.count + 1
+    samples.count = i
+    samples.cycle[i] = cycle
+    for _, metric in ipairs(Soak.METRICS) do
+        samples[metric.name][i] = stats[metric.name] or false
+    end
+end
+
+-- 最小二乘拟合 y = a + b * x，返回斜率和决定系数 r²
+local function linear_fit(xs, ys)
+    local n = #xs
+    local sx, sy = 0, 0
+    for i = 1, n do
+        sx = sx + xs[i]
+        sy = sy + ys[i]
+    end
+    local mx, my = sx / n, sy / n
+    local sxx, sxy, syy = 0, 0, 0
+    for i = 1, n do
+        local dx, dy = xs[i] - mx, ys[i] - my
+        sxx = sxx + dx * dx
+        sxy = sxy + dx * dy
+        syy = syy + dy * dy
+    end
+    if sxx == 0 then
+        return 0, 0
+    end
+    local slope = sxy / sxx
+    local r2 = syy > 0 and (sxy * sxy) / (sxx * syy) or 0
+    return slope, r2
+end
+
+-- 分析样本，返回每项指标的结果和判定为泄漏的数量
+function Soak.analyze(samples)
+    local first = math.floor(samples.count * Soak.WARMUP_PCT / 100) + 1
+    local results = {}
+    local leaks = 0
+    for _, metric in ipairs(Soak.METRICS) do
+        local xs, ys = {}, {}
+        for i = first, samples.count do
+            local value = samples[metric.name][i]
+            if value then
+                xs[#xs + 1] = samples.cycle[i]
+                ys[#ys + 1] = value
+            end
+        end
+        if #xs >= 3 then
+            local slope, r2 = linear_fit(xs, ys)
+            local leak = slope * 1000 > metric.per_1000 and r2 >= Soak.MIN_R2
+            if leak then
+                leaks = leaks + 1
+            end
+            results[#results + 1] = {
+                name = metric.name,
+                first = ys[1],
+                last = ys[#ys],
+                slope = slope,
+                r2 = r2,
+                leak = leak,
+            }
+        end
+    end
+    return results, leaks
+end
+
+-- 一轮编辑器操作：添加所有控件，选中并修改、删除其中一个，最后清空画布
+local function editor_cycle(canvas, modules, cycle)
+    for i, module in ipairs(modules) do
+        canvas:add_widget(module, { x = 20 + (i - 1) * 40, y = 20 + (i - 1) * 30 })
+    end
+    run_frames(1)
+
+    local widgets = canvas:get_widgets()
+    local entry = widgets[(cycle % #widgets) + 1]
+    canvas:select_widget(entry)
+    if entry.instance.set_property then
+        pcall(entry.instance.set_property, entry.instance, "x", 60)
+    end
+    run_frames(1)
+    canvas:delete_selected()
+    canvas:clear()
+end
+
+local function write_csv(path, samples)
+    local file, err = io.open(path, "wb")
+    if not file then
+        return nil, err
+    end
+    local names = {}
+    for _, metric in ipairs(Soak.METRICS) do
+        names[#names + 1] = metric.name
+    end
+    file:write("cycle,", table.concat(names, ","), "\n")
+    for i = 1, samples.count do
+        local row = { tostring(samples.cycle[i]) }
+        for _, name in ipairs(names) do
+            local value = samples[name][i]
+            row[#row + 1] = value and (math.type(value) == "float" and string.format("%.1f", value) or tostring(value)) or ""
+        end
+        file:write(table.concat(row, ","), "\n")
+    end
+    file:close()
+    return true
+end
+
+-- 运行测试，返回判定为泄漏的指标数量
+-- options: output（样本 CSV）、cycles、sample_every、project（.json 或编译后的 .lua）
+function Soak.run(options)
+    options = options or {}
+    local cycles = options.cycles or Soak.DEFAULT_CYCLES
+    local sample_every = options.sample_every or Soak.DEFAULT_SAMPLE_EVERY
+    local scr = lv.scr_act()
+
+    local modules = {}
+    for _, name in ipairs(Soak.WIDGET_MODULES) do
+        modules[#modules + 1] = require(name)
+    end
+
+    local page_manager
+    if options.project then
+        local err
+        page_manager, err = PageRenderer.load_project(options.project)
+        if not page_manager then
+            return nil, err
+        end
+        page_manager.init()
+    end
+
+    local canvas = CanvasArea.new(scr, { x = 0, y = 0, width = 800, height = 600 })
+
+    local samples = new_samples(cycles // sample_every + 1)
+    sample(samples, 0)
+    local t0 = lv.time_us()
+    for cycle = 1, cycles do
+        editor_cycle(canvas, modules, cycle)
+        if page_manager and #page_manager.pages > 0 then
+            page_manager.goto_page((cycle - 1) % #page_manager.pages + 1)
+        end
+        run_frames(Soak.FRAMES_PER_CYCLE)
+        if cycle % sample_every == 0 then
+            sample(samples, cycle)
+        end
+    end
+    local elapsed_s = (lv.time_us() - t0) / 1e6
+    canvas.container:delete()
+
+    if options.output then
+        local ok, err = write_csv(options.output, samples)
+        if not ok then
+            return nil, err
+        end
+        print("[Soak] 样本已写入 " .. options.output)
+    end
+
+    local results, leaks = Soak.analyze(samples)
+    print(string.format("[Soak] %d 轮，耗时 %.1f s，%d 个样本", cycles, elapsed_s, samples.count))
+    for _, r in ipairs(results) do
+        print(string.format("[Soak] %-10s %12.1f -> %12.1f  每千轮 %+10.1f  r2 %.2f  %s",
+            r.name, r.first, r.last, r.slope * 1000, r.r2, r.leak and "增长" or "稳定"))
+    end
+    return leaks
+end
+
+return Soak
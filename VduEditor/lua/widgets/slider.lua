@@ -138,6 +138,13 @@ function Slider.new(parent, state)
         local label_x = self.props.x + math.floor(self.props.width / 2)
         self.value_label:set_pos(label_x, self.props.y + self.props.height + 2)
         self.value_label:set_style_text_align(lv.TEXT_ALIGN_CENTER, 0)
+        -- 标签不是滑块的子对象，滑块删除时一并删除
+        self.slider:add_event_cb(function()
+            if self.value_label then
+                self.value_label:delete()
+                self.value_label = nil
+            end
+        end, lv.EVENT_DELETE)
     else
         self.value_label = nil
     end
@@ -124,6 +124,11 @@ function TrendChart.new(parent, props)
         table.insert(self._event_listeners[event_name], callback)
     end
 
+    -- stop the update timer when the chart is deleted (page or canvas cleared)
+    self.chart:add_event_cb(function()
+        self:stop()
+    end, lv.EVENT_DELETE)
+
     -- auto start if requested and not in design mode
     if self.props.auto_update and not self.props.design_mode then 
         print("self:start")
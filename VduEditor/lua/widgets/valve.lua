@@ -30,16 +30,17 @@ Valve.__widget_meta = {
     events = { "angle_changed", "toggled" },
 }
 
+-- 实例集合（实例 -> true），容器删除时移除
 Valve.instances = {}
 
 function Valve.open_all()
-    for _, v in pairs(Valve.instances) do
+    for v in pairs(Valve.instances) do
         v:open()
     end
 end
 
 function Valve.close_all()
-    for _, v in pairs(Valve.instances) do
+    for v in pairs(Valve.instances) do
         v:close()
     end
 end
@@ -60,7 +61,7 @@ function Valve.new(parent, props)
     local self = {}
     
     -- 注册实例
-    table.insert(Valve.instances, self)
+    Valve.instances[self] = true
 
     -- 初始化属性（使用元数据默认值）
     self.props = {}
@@ -87,6 +88,9 @@ function Valve.new(parent, props)
     self.container:set_style_border_width(2, 0)
     self.container:set_style_border_color(0x606060, 0)
     self.container:remove_flag(lv.OBJ_FLAG_SCROLLABLE)
+    self.container:add_event_cb(function()
+        Valve.instances[self] = nil
+    end, lv.EVENT_DELETE)
 
     -- handle
     self.handle = lv.obj_create(self.container)
@@ -1,34 +1,58 @@
 ﻿// VduSimulator.cpp : VDU模拟主程序
 //
 
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <limits.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 // Lua 绑定
 extern "C" {
 #include "lvgl_lua_bindings.h"
 }
 
+// 路径分隔符
+#ifdef _WIN32
+#define PATH_SEP "\\"
+#else
+#define PATH_SEP "/"
+#endif
+
 // 窗口尺寸
 static const int WINDOW_WIDTH = 1024;
 static const int WINDOW_HEIGHT = 768;
 
 // 默认脚本路径
-static const char* DEFAULT_SCRIPT_PATH = "lua\\editor\\main_editor.lua";
+static const char* DEFAULT_SCRIPT_PATH = "lua" PATH_SEP "editor" PATH_SEP "main_editor.lua";
 
 // 默认 Lua 搜索路径（模板，使用绝对路径）
 static const char* DEFAULT_LUA_PATH_TEMPLATE = 
-    "%slua\\editor\\?.lua;"
-    "%slua\\editor\\?\\init.lua;"
-    "%slua\\sim\\?.lua;"
-    "%slua\\sim\\?\\init.lua;"
-    "%slua\\?.lua;"
-    "%slua\\?\\init.lua;"
-    "%slua\\actions\\?.lua";
+    "%slua" PATH_SEP "editor" PATH_SEP "?.lua;"
+    "%slua" PATH_SEP "editor" PATH_SEP "?" PATH_SEP "init.lua;"
+    "%slua" PATH_SEP "sim" PATH_SEP "?.lua;"
+    "%slua" PATH_SEP "sim" PATH_SEP "?" PATH_SEP "init.lua;"
+    "%slua" PATH_SEP "?.lua;"
+    "%slua" PATH_SEP "?" PATH_SEP "init.lua;"
+    "%slua" PATH_SEP "actions" PATH_SEP "?.lua";
 
 // 默认字体路径（黑体）
-static const char* DEFAULT_FONT_PATH = "fonts\\simhei.ttf";
+static const char* DEFAULT_FONT_PATH = "fonts" PATH_SEP "simhei.ttf";
 static const int DEFAULT_FONT_SIZE = 14;
 
 // Lua 状态机
@@ -40,6 +64,275 @@ static lv_font_t* g_chinese_font = nullptr;
 // 全局可执行文件目录
 static std::string g_exe_directory;
 
+// 命令行选项
+struct SimulatorOptions {
+    const char* script_path = DEFAULT_SCRIPT_PATH;
+    bool headless = false;              // 不创建窗口，渲染到内存帧缓冲区
+    int width = WINDOW_WIDTH;
+    int height = WINDOW_HEIGHT;
+    const char* dump_dir = nullptr;     // 每帧保存到该目录
+    const char* dump_format = "ppm";    // ppm / png
+    const char* screenshot_path = nullptr;  // 退出时保存最后一帧
+    uint32_t run_ms = 0;                // 运行时长，0 表示一直运行
+    bool virtual_clock = false;         // 虚拟时钟：不等待，直接跳到下一个定时器
+    uint32_t timestep_ms = 0;           // 虚拟时钟固定步长，0 表示跳到下一个定时器
+    long long start_time = 0;           // 虚拟时钟起始时间（Unix 秒），0 表示当前时间
+    const char* record_path = nullptr;  // 录制输入到该文件
+    const char* replay_path = nullptr;  // 回放该输入录制文件
+    const char* render_project = nullptr;   // 批量渲染该工程脚本的所有图页
+    const char* render_out = "render";  // 批量渲染输出目录
+    unsigned jobs = 0;                  // 渲染进程数，0 表示 CPU 核数
+    unsigned shard = 0;                 // 子进程负责的分片（内部使用）
+    unsigned shards = 0;                // 分片总数，0 表示当前是父进程
+    bool render_merge = false;          // 单进程渲染时由本进程合并计时文件
+    const char* golden_dir = nullptr;   // 图像回归测试的工程 JSON 目录
+    const char* golden_ref = "golden";  // 参考截图和计时目录
+    bool golden_update = false;         // 用本次结果更新参考目录
+    int golden_tolerance = -1;          // 单个通道允许的差值，-1 表示默认值
+    double golden_max_diff_pct = -1;    // 允许的差异像素比例（%）
+    double golden_perf_pct = -1;        // 允许的耗时增长（%）
+    double golden_perf_floor_ms = -1;   // 忽略的耗时增量（毫秒），-1 表示默认值
+    const char* bench_out = nullptr;    // 运行微基准测试并把结果写入该 JSON 文件
+    const char* bench_baseline = nullptr;   // 与该基线 JSON 比较
+    const char* bench_project = nullptr;    // 测量该工程（.json 或编译后的 .lua）的图页创建耗时
+    const char* bench_filter = nullptr; // 只运行名称匹配该 Lua 模式的测试项
+    const char* scale_csv = nullptr;    // 规模测试结果 CSV
+    const char* scale_sizes = "100,500,1000,5000,10000,50000";  // 每种控件的数量
+    const char* scale_types = nullptr;  // 参与测试的控件类型（逗号分隔），默认全部
+    int update_pct = -1;                // 每秒更新的控件比例（%），-1 表示默认值
+    double scale_budget_s = 120;        // 单个测量点超过该时长后不再测试更大的数量
+    const char* scale_point = nullptr;  // 子进程负责的测量点 "模块:数量"（内部使用）
+    const char* soak_csv = nullptr;     // 长时间运行测试的样本 CSV
+    int soak_cycles = 0;                // 循环次数，0 表示默认值
+    int soak_sample_every = 0;          // 每隔多少轮采样一次，0 表示默认值
+    const char* soak_project = nullptr; // 同时循环切换该工程（.json 或编译后的 .lua）的图页
+};
+
+/**
+ * @brief 打印命令行用法
+ */
+static void print_usage()
+{
+    std::cout << "Usage: VduSimulator [options] [script]" << std::endl;
+    std::cout << "  --headless             render into a memory framebuffer, no window" << std::endl;
+    std::cout << "  --size WxH             display size (default " << WINDOW_WIDTH << "x" << WINDOW_HEIGHT << ")" << std::endl;
+    std::cout << "  --dump-frames DIR      save every rendered frame into DIR (headless only)" << std::endl;
+    std::cout << "  --frame-format FMT     ppm or png (default ppm)" << std::endl;
+    std::cout << "  --screenshot FILE      save the last frame on exit, .png or .ppm (headless only)" << std::endl;
+    std::cout << "  --run-ms N             exit after N milliseconds (virtual time with --virtual-clock)" << std::endl;
+    std::cout << "  --virtual-clock        run on a virtual clock as fast as possible" << std::endl;
+    std::cout << "  --timestep MS          advance the virtual clock by a fixed step per loop (implies --virtual-clock)" << std::endl;
+    std::cout << "  --start-time SECONDS   virtual clock start, Unix time (default: now)" << std::endl;
+    std::cout << "  --record-input FILE    record pointer/keypad/encoder input into FILE" << std::endl;
+    std::cout << "  --replay-input FILE    replay recorded input and report input-to-flush latency," << std::endl;
+    std::cout << "                         exits when the replay is done unless --run-ms is given" << std::endl;
+    std::cout << "  --render PROJECT.lua   render every page of a compiled project to PNG and exit" << std::endl;
+    std::cout << "  --out DIR              output directory for --render (default render)" << std::endl;
+    std::cout << "  --jobs N               render with N processes (default: one per CPU core)" << std::endl;
+    std::cout << "  --golden DIR           compile every project JSON in DIR, render it and compare with" << std::endl;
+    std::cout << "                         the reference images and timing, exits with 1 on failure" << std::endl;
+    std::cout << "  --ref DIR              reference directory for --golden (default golden)" << std::endl;
+    std::cout << "  --update               write the rendered pages as the new references" << std::endl;
+    std::cout << "  --tolerance N          per-channel difference ignored by --golden (default 8)" << std::endl;
+    std::cout << "  --max-diff-pct P       differing pixels allowed per page, in percent (default 0.1)" << std::endl;
+    std::cout << "  --perf-threshold PCT   fail --golden when render/instantiate time grows more than PCT" << std::endl;
+    std::cout << "                         (default: warn above 20)," << std::endl;
+    std::cout << "                         or benchmark slowdown against --baseline (default 15)" << std::endl;
+    std::cout << "  --perf-floor-ms MS     time growth below MS is treated as noise by --golden" << std::endl;
+    std::cout << "                         (default: 2 when only warning, 0 with --perf-threshold)" << std::endl;
+    std::cout << "  --bench OUT.json       run the binding micro-benchmarks, write the results and exit" << std::endl;
+    std::cout << "  --baseline FILE        compare --bench results with a previous OUT.json, exits with 1 on regression" << std::endl;
+    std::cout << "  --bench-project FILE   also measure page creation of a project (.json or compiled .lua)" << std::endl;
+    std::cout << "  --bench-filter PATTERN only run benchmarks whose name matches the Lua pattern" << std::endl;
+    std::cout << "  --scale OUT.csv        scalability test: generate, compile, load and run projects with N widgets" << std::endl;
+    std::cout << "                         of each type, one process per point, results appended to OUT.csv" << std::endl;
+    std::cout << "  --scale-sizes LIST     widget counts (default 100,500,1000,5000,10000,50000)" << std::endl;
+    std::cout << "  --scale-types LIST     widget types, e.g. button,valve (default: all)" << std::endl;
+    std::cout << "  --update-pct K         percentage of widgets updated per second (default 10)" << std::endl;
+    std::cout << "  --scale-budget SECONDS stop growing a type once a point takes longer (default 120)" << std::endl;
+    std::cout << "  --soak OUT.csv         soak test: repeat editor operations, sample objects, timers, Lua references" << std::endl;
+    std::cout << "                         and memory to OUT.csv, exits with 1 when any of them keeps growing" << std::endl;
+    std::cout << "  --soak-cycles N        number of cycles (default 1000)" << std::endl;
+    std::cout << "  --soak-sample N        sample every N cycles (default 10)" << std::endl;
+    std::cout << "  --soak-project FILE    also cycle through the pages of a project (.json or compiled .lua)" << std::endl;
+}
+
+/**
+ * @brief 解析命令行参数
+ * @return 参数有效返回 true
+ */
+static bool parse_options(int argc, char* argv[], SimulatorOptions& opts)
+{
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(arg, "--headless") == 0) {
+            opts.headless = true;
+        }
+        else if (strcmp(arg, "--size") == 0 && has_value) {
+            char* end = nullptr;
+            opts.width = (int)strtol(argv[++i], &end, 10);
+            opts.height = (*end == 'x') ? (int)strtol(end + 1, &end, 10) : 0;
+            if (*end != '\0' || opts.width <= 0 || opts.height <= 0) {
+                std::cerr << "Invalid size: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--dump-frames") == 0 && has_value) {
+            opts.dump_dir = argv[++i];
+        }
+        else if (strcmp(arg, "--frame-format") == 0 && has_value) {
+            opts.dump_format = argv[++i];
+        }
+        else if (strcmp(arg, "--screenshot") == 0 && has_value) {
+            opts.screenshot_path = argv[++i];
+        }
+        else if (strcmp(arg, "--run-ms") == 0 && has_value) {
+            opts.run_ms = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(arg, "--virtual-clock") == 0) {
+            opts.virtual_clock = true;
+        }
+        else if (strcmp(arg, "--timestep") == 0 && has_value) {
+            opts.timestep_ms = (uint32_t)strtoul(argv[++i], nullptr, 10);
+            opts.virtual_clock = true;
+            if (opts.timestep_ms == 0) {
+                std::cerr << "Invalid timestep: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--start-time") == 0 && has_value) {
+            opts.start_time = strtoll(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(arg, "--record-input") == 0 && has_value) {
+            opts.record_path = argv[++i];
+        }
+        else if (strcmp(arg, "--replay-input") == 0 && has_value) {
+            opts.replay_path = argv[++i];
+        }
+        else if (strcmp(arg, "--render") == 0 && has_value) {
+            opts.render_project = argv[++i];
+        }
+        else if (strcmp(arg, "--out") == 0 && has_value) {
+            opts.render_out = argv[++i];
+        }
+        else if (strcmp(arg, "--jobs") == 0 && has_value) {
+            opts.jobs = (unsigned)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(arg, "--golden") == 0 && has_value) {
+            opts.golden_dir = argv[++i];
+        }
+        else if (strcmp(arg, "--ref") == 0 && has_value) {
+            opts.golden_ref = argv[++i];
+        }
+        else if (strcmp(arg, "--update") == 0) {
+            opts.golden_update = true;
+        }
+        else if (strcmp(arg, "--tolerance") == 0 && has_value) {
+            opts.golden_tolerance = (int)strtol(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(arg, "--max-diff-pct") == 0 && has_value) {
+            opts.golden_max_diff_pct = strtod(argv[++i], nullptr);
+        }
+        else if (strcmp(arg, "--perf-threshold") == 0 && has_value) {
+            opts.golden_perf_pct = strtod(argv[++i], nullptr);
+        }
+        else if (strcmp(arg, "--perf-floor-ms") == 0 && has_value) {
+            opts.golden_perf_floor_ms = strtod(argv[++i], nullptr);
+        }
+        else if (strcmp(arg, "--bench") == 0 && has_value) {
+            opts.bench_out = argv[++i];
+        }
+        else if (strcmp(arg, "--baseline") == 0 && has_value) {
+            opts.bench_baseline = argv[++i];
+        }
+        else if (strcmp(arg, "--bench-project") == 0 && has_value) {
+            opts.bench_project = argv[++i];
+        }
+        else if (strcmp(arg, "--bench-filter") == 0 && has_value) {
+            opts.bench_filter = argv[++i];
+        }
+        else if (strcmp(arg, "--scale") == 0 && has_value) {
+            opts.scale_csv = argv[++i];
+        }
+        else if (strcmp(arg, "--scale-sizes") == 0 && has_value) {
+            opts.scale_sizes = argv[++i];
+        }
+        else if (strcmp(arg, "--scale-types") == 0 && has_value) {
+            opts.scale_types = argv[++i];
+        }
+        else if (strcmp(arg, "--update-pct") == 0 && has_value) {
+            opts.update_pct = (int)strtol(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(arg, "--scale-budget") == 0 && has_value) {
+            opts.scale_budget_s = strtod(argv[++i], nullptr);
+        }
+        else if (strcmp(arg, "--scale-point") == 0 && has_value) {
+            opts.scale_point = argv[++i];
+            // 控件定时器按帧推进，结果与机器负载无关
+            opts.virtual_clock = true;
+        }
+        else if (strcmp(arg, "--soak") == 0 && has_value) {
+            opts.soak_csv = argv[++i];
+            // 按帧推进时钟，几分钟内即可模拟数小时的定时器运行
+            opts.virtual_clock = true;
+        }
+        else if (strcmp(arg, "--soak-cycles") == 0 && has_value) {
+            opts.soak_cycles = (int)strtol(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(arg, "--soak-sample") == 0 && has_value) {
+            opts.soak_sample_every = (int)strtol(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(arg, "--soak-project") == 0 && has_value) {
+            opts.soak_project = argv[++i];
+        }
+        else if (strcmp(arg, "--shard") == 0 && has_value) {
+            char* end = nullptr;
+            opts.shard = (unsigned)strtoul(argv[++i], &end, 10);
+            opts.shards = (*end == '/') ? (unsigned)strtoul(end + 1, &end, 10) : 0;
+            if (*end != '\0' || opts.shards == 0 || opts.shard >= opts.shards) {
+                std::cerr << "Invalid shard: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage();
+            return false;
+        }
+        else if (arg[0] == '-' && arg[1] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            print_usage();
+            return false;
+        }
+        else {
+            opts.script_path = arg;
+        }
+    }
+#ifndef _WIN32
+    // 非 Windows 平台没有窗口驱动
+    opts.headless = true;
+#endif
+    if (opts.render_project || opts.golden_dir || opts.bench_out || opts.scale_csv || opts.soak_csv) {
+        opts.headless = true;
+    }
+    return true;
+}
+
+/**
+ * @brief 打开文件（MSVC 下使用 fopen_s）
+ */
+static FILE* open_file(const char* path, const char* mode)
+{
+#ifdef _MSC_VER
+    FILE* f = nullptr;
+    if (fopen_s(&f, path, mode) != 0) return nullptr;
+    return f;
+#else
+    return fopen(path, mode);
+#endif
+}
+
+#ifdef _WIN32
 /**
  * @brief 将窗口居中显示在屏幕上
  * @param hwnd 窗口句柄
@@ -67,21 +360,39 @@ static void center_window(HWND hwnd)
     // 设置窗口位置
     SetWindowPos(hwnd, NULL, x, y, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
 }
+#endif
 
 /**
- * @brief 获取当前可执行文件所在目录
- * @return 以反斜杠结尾的目录路径，失败时返回空字符串
+ * @brief 获取当前可执行文件路径
+ * @return 完整路径，失败时返回空字符串
  */
-static std::string get_exe_directory()
+static std::string get_exe_path()
 {
+#ifdef _WIN32
     char path[MAX_PATH];
     DWORD len = GetModuleFileNameA(NULL, path, MAX_PATH);
     if (len == 0 || len >= MAX_PATH) {
         return "";
     }
+#else
+    char path[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (len <= 0) {
+        return "";
+    }
+    path[len] = '\0';
+#endif
+    return path;
+}
 
+/**
+ * @brief 获取当前可执行文件所在目录
+ * @return 以反斜杠结尾的目录路径，失败时返回空字符串
+ */
+static std::string get_exe_directory()
+{
     // 查找最后一个反斜杠并截断
-    std::string dir(path);
+    std::string dir = get_exe_path();
     size_t pos = dir.find_last_of("\\/");
     if (pos != std::string::npos) {
         dir = dir.substr(0, pos + 1);  // 保留反斜杠
@@ -91,11 +402,19 @@ static std::string get_exe_directory()
 
 /**
  * @brief 构建完整路径（基于可执行文件目录）
- * @param relative_path 相对路径
+ * @param relative_path 相对路径，绝对路径原样返回
  * @return 完整绝对路径
  */
 static std::string build_full_path(const char* relative_path)
 {
+#ifdef _WIN32
+    bool absolute = (relative_path[0] && relative_path[1] == ':') || relative_path[0] == '\\' || relative_path[0] == '/';
+#else
+    bool absolute = relative_path[0] == '/';
+#endif
+    if (absolute) {
+        return relative_path;
+    }
     return g_exe_directory + relative_path;
 }
 
@@ -113,8 +432,8 @@ static bool init_chinese_font()
     std::cout << "Font path: " << full_font_path << std::endl;
 
     // 检查字体文件是否存在
-    FILE* f = nullptr;
-    if (fopen_s(&f, full_font_path.c_str(), "rb") != 0 || !f) {
+    FILE* f = open_file(full_font_path.c_str(), "rb");
+    if (!f) {
         std::cerr << "Font file not found: " << full_font_path << std::endl;
         std::cerr << "Please copy simhei.ttf to the fonts directory." << std::endl;
         return false;
@@ -255,18 +574,26 @@ static bool load_lua_script(const char* script_path)
     // 构建完整脚本路径
     std::string full_script_path = build_full_path(script_path);
 
-    // 检查文件是否存在
-    FILE* f = nullptr;
-    if (fopen_s(&f, full_script_path.c_str(), "r") != 0 || !f) {
+    // 检查文件是否存在，首字节为 LUA_SIGNATURE 时是 ProjectCompiler 输出的预编译字节码
+    FILE* f = open_file(full_script_path.c_str(), "rb");
+    if (!f) {
         std::cerr << "Script file not found: " << full_script_path << std::endl;
         return false;
     }
+    bool bytecode = fgetc(f) == LUA_SIGNATURE[0];
     fclose(f);
 
-    std::cout << "Loading script: " << full_script_path << std::endl;
+    std::cout << "Loading script: " << full_script_path << (bytecode ? " (bytecode)" : "") << std::endl;
 
-    // 加载并执行脚本
-    int result = luaL_dofile(g_L, full_script_path.c_str());
+    // 加载（字节码无需语法分析）并执行脚本，脚本路径作为参数传入（分页编译的根脚本据此查找图页模块）
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int result = luaL_loadfile(g_L, full_script_path.c_str());
+    if (result == LUA_OK) {
+        double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Script loaded in " << load_ms << " ms" << std::endl;
+        lua_pushstring(g_L, full_script_path.c_str());
+        result = lua_pcall(g_L, 1, LUA_MULTRET, 0);
+    }
     if (result != LUA_OK) {
         const char* error = lua_tostring(g_L, -1);
         std::cerr << "Lua error: " << (error ? error : "unknown error") << std::endl;
@@ -288,62 +615,35 @@ static void cleanup_lua()
     }
 }
 
+#ifdef _WIN32
 /**
- * @brief 主函数
+ * @brief 创建 Windows 窗口显示及输入设备
+ * @return 成功返回显示对象
  */
-int main(int argc, char* argv[])
+static lv_display_t* create_window_display(const SimulatorOptions& opts)
 {
-    // 将控制台设置为 UTF-8 以支持中文输出
-    SetConsoleCP(CP_UTF8);
-    SetConsoleOutputCP(CP_UTF8);
-
-    std::cout << "VduSimulator - LVGL Lua Configuration Editor" << std::endl;
-    std::cout << "Window size: " << WINDOW_WIDTH << "x" << WINDOW_HEIGHT << std::endl;
-
-    // 获取可执行文件目录（在程序启动时获取一次）
-    g_exe_directory = get_exe_directory();
-    if (g_exe_directory.empty()) {
-        std::cerr << "Failed to get executable directory" << std::endl;
-        return -1;
-    }
-    std::cout << "Application directory: " << g_exe_directory << std::endl;
-
-    // 确定脚本路径
-    const char* script_path = DEFAULT_SCRIPT_PATH;
-    if (argc > 1) {
-        script_path = argv[1];
-        std::cout << "Using command line script: " << script_path << std::endl;
-    }
-    else {
-        std::cout << "Using default script: " << script_path << std::endl;
-    }
-
-    // 初始化 LVGL
-    lv_init();
-
-    // 创建显示
     int32_t zoom_level = 100;
     bool allow_dpi_override = false;
     bool simulator_mode = false;
 
     lv_display_t* display = lv_windows_create_display(
         L"VduSimulator",
-        WINDOW_WIDTH,
-        WINDOW_HEIGHT,
+        opts.width,
+        opts.height,
         zoom_level,
         allow_dpi_override,
         simulator_mode);
 
     if (!display) {
         std::cerr << "Failed to create display" << std::endl;
-        return -1;
+        return nullptr;
     }
 
     // 获取窗口句柄并设置图标
     HWND window_handle = lv_windows_get_display_window_handle(display);
     if (!window_handle) {
         std::cerr << "Failed to get window handle" << std::endl;
-        return -1;
+        return nullptr;
     }
 
     // 将窗口居中显示
@@ -353,25 +653,744 @@ int main(int argc, char* argv[])
     lv_indev_t* pointer_indev = lv_windows_acquire_pointer_indev(display);
     if (!pointer_indev) {
         std::cerr << "Failed to create pointer input device" << std::endl;
-        return -1;
+        return nullptr;
     }
 
     lv_indev_t* keypad_indev = lv_windows_acquire_keypad_indev(display);
     if (!keypad_indev) {
         std::cerr << "Failed to create keypad input device" << std::endl;
-        return -1;
+        return nullptr;
     }
 
     lv_indev_t* encoder_indev = lv_windows_acquire_encoder_indev(display);
     if (!encoder_indev) {
         std::cerr << "Failed to create encoder input device" << std::endl;
+        return nullptr;
+    }
+
+    return display;
+}
+#endif
+
+/**
+ * @brief 创建无窗口显示（内存帧缓冲区）
+ * @return 成功返回显示对象
+ */
+static lv_display_t* create_headless_display(const SimulatorOptions& opts)
+{
+    lv_display_t* display = lvgl_headless_create_display(opts.width, opts.height);
+    if (!display) {
+        std::cerr << "Failed to create headless display" << std::endl;
+        return nullptr;
+    }
+
+    if (opts.dump_dir) {
+        lvgl_headless_set_frame_dump(display, opts.dump_dir, opts.dump_format);
+        std::cout << "Dumping frames to: " << opts.dump_dir << " (" << opts.dump_format << ")" << std::endl;
+    }
+    return display;
+}
+
+/**
+ * @brief 渲染子进程
+ */
+struct ChildProcess {
+#ifdef _WIN32
+    HANDLE handle = nullptr;
+#else
+    pid_t pid = -1;
+#endif
+};
+
+/**
+ * @brief 启动子进程
+ * @param args 参数列表，args[0] 为可执行文件路径
+ * @return 成功返回 true
+ */
+static bool spawn_process(const std::vector<std::string>& args, ChildProcess& child)
+{
+#ifdef _WIN32
+    std::string command_line;
+    for (const std::string& arg : args) {
+        if (!command_line.empty()) {
+            command_line += ' ';
+        }
+        command_line += '"' + arg + '"';
+    }
+    STARTUPINFOA si = {};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi = {};
+    if (!CreateProcessA(args[0].c_str(), &command_line[0], NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    child.handle = pi.hProcess;
+    return true;
+#else
+    std::vector<char*> argv;
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    return posix_spawn(&child.pid, args[0].c_str(), nullptr, nullptr, argv.data(), environ) == 0;
+#endif
+}
+
+/**
+ * @brief 等待子进程结束
+ * @return 子进程退出码，异常结束返回 -1
+ */
+static int wait_process(ChildProcess& child)
+{
+#ifdef _WIN32
+    DWORD code = (DWORD)-1;
+    WaitForSingleObject(child.handle, INFINITE);
+    GetExitCodeProcess(child.handle, &code);
+    CloseHandle(child.handle);
+    child.handle = nullptr;
+    return (int)code;
+#else
+    int status = 0;
+    if (waitpid(child.pid, &status, 0) < 0) {
+        return -1;
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
+
+/**
+ * @brief 分片计时文件路径
+ */
+static std::string render_timing_path(const SimulatorOptions& opts, unsigned shard)
+{
+    return std::string(opts.render_out) + PATH_SEP "timing_" + std::to_string(shard) + ".csv";
+}
+
+/**
+ * @brief 在当前进程中渲染本分片的图页（调用 lua/sim/page_renderer.lua）
+ * @return 成功返回 0
+ */
+static int render_pages(const SimulatorOptions& opts)
+{
+    std::string project_path = build_full_path(opts.render_project);
+    std::string timing_path = render_timing_path(opts, opts.shard);
+
+    lua_getglobal(g_L, "require");
+    lua_pushstring(g_L, "sim.page_renderer");
+    if (lua_pcall(g_L, 1, 1, 0) != LUA_OK) {
+        std::cerr << "Lua error: " << lua_tostring(g_L, -1) << std::endl;
+        lua_pop(g_L, 1);
+        return -1;
+    }
+    lua_getfield(g_L, -1, "run");
+    lua_createtable(g_L, 0, 5);
+    lua_pushstring(g_L, project_path.c_str());
+    lua_setfield(g_L, -2, "project");
+    lua_pushstring(g_L, opts.render_out);
+    lua_setfield(g_L, -2, "out_dir");
+    lua_pushstring(g_L, timing_path.c_str());
+    lua_setfield(g_L, -2, "timing_path");
+    lua_pushinteger(g_L, opts.shard);
+    lua_setfield(g_L, -2, "shard");
+    lua_pushinteger(g_L, opts.shards);
+    lua_setfield(g_L, -2, "shards");
+    if (lua_pcall(g_L, 1, 3, 0) != LUA_OK) {
+        std::cerr << "Lua error: " << lua_tostring(g_L, -1) << std::endl;
+        lua_pop(g_L, 2);
+        return -1;
+    }
+    int exit_code = 0;
+    if (lua_isnil(g_L, -3)) {
+        const char* error = lua_tostring(g_L, -2);
+        std::cerr << "Render failed: " << (error ? error : "unknown error") << std::endl;
+        exit_code = -1;
+    }
+    else {
+        lua_Integer rendered = lua_tointeger(g_L, -3);
+        lua_Integer assigned = lua_tointeger(g_L, -1);
+        std::cout << "Rendered " << rendered << " pages (shard " << opts.shard << "/" << opts.shards << ")" << std::endl;
+        // 有图页创建或保存失败时整个分片算失败
+        if (rendered < assigned) {
+            std::cerr << "Render failed: " << (assigned - rendered) << " of " << assigned << " pages failed" << std::endl;
+            exit_code = 1;
+        }
+    }
+    lua_pop(g_L, 4);
+    return exit_code;
+}
+
+/**
+ * @brief 合并各分片的计时文件为 timing.csv 并打印汇总
+ * @return 成功返回 0
+ */
+static int merge_render_timing(const SimulatorOptions& opts, unsigned shards)
+{
+    std::vector<std::pair<long, std::string>> rows;
+    for (unsigned shard = 0; shard < shards; shard++) {
+        std::string path = render_timing_path(opts, shard);
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty()) {
+                rows.emplace_back(strtol(line.c_str(), nullptr, 10), line);
+            }
+        }
+        in.close();
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+    std::sort(rows.begin(), rows.end());
+
+    std::string timing_path = std::string(opts.render_out) + PATH_SEP "timing.csv";
+    std::ofstream out(timing_path, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to write " << timing_path << std::endl;
+        return -1;
+    }
+    out << "index,name,instantiate_ms,render_ms,objects,image\n";
+    for (const auto& row : rows) {
+        out << row.second << "\n";
+    }
+    std::cout << "Render timing written to: " << timing_path << " (" << rows.size() << " pages)" << std::endl;
+    return 0;
+}
+
+/**
+ * @brief 启动多个子进程并行渲染，每个子进程负责一个分片
+ * @return 全部成功返回 0
+ */
+static int render_parallel(const SimulatorOptions& opts, unsigned jobs)
+{
+    std::string exe_path = get_exe_path();
+    std::string project_path = build_full_path(opts.render_project);
+    std::string size = std::to_string(opts.width) + "x" + std::to_string(opts.height);
+
+    std::cout << "Rendering " << project_path << " with " << jobs << " processes" << std::endl;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<ChildProcess> children(jobs);
+    int exit_code = 0;
+    unsigned started = 0;
+    for (unsigned shard = 0; shard < jobs; shard++) {
+        std::vector<std::string> args = {
+            exe_path, "--render", project_path, "--out", opts.render_out,
+            "--size", size, "--shard", std::to_string(shard) + "/" + std::to_string(jobs),
+        };
+        if (!spawn_process(args, children[shard])) {
+            std::cerr << "Failed to start render process " << shard << std::endl;
+            exit_code = -1;
+            break;
+        }
+        started++;
+    }
+    for (unsigned shard = 0; shard < started; shard++) {
+        int code = wait_process(children[shard]);
+        if (code != 0) {
+            std::cerr << "Render process " << shard << " failed with exit code " << code << std::endl;
+            exit_code = -1;
+        }
+    }
+
+    if (merge_render_timing(opts, jobs) != 0) {
+        exit_code = -1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Render finished in " << seconds << " s" << std::endl;
+    return exit_code;
+}
+
+/**
+ * @brief 把 lua/sim/golden.lua 中的函数压入栈顶
+ * @return 成功返回 true
+ */
+static bool push_golden_function(const char* name)
+{
+    lua_getglobal(g_L, "require");
+    lua_pushstring(g_L, "sim.golden");
+    if (lua_pcall(g_L, 1, 1, 0) != LUA_OK) {
+        std::cerr << "Lua error: " << lua_tostring(g_L, -1) << std::endl;
+        lua_pop(g_L, 1);
+        return false;
+    }
+    lua_getfield(g_L, -1, name);
+    lua_remove(g_L, -2);
+    return true;
+}
+
+/**
+ * @brief 图像回归测试：编译目录中的每个工程 JSON，并行渲染全部图页，与参考图和参考计时比较
+ * @return 全部通过返回 0
+ */
+static int run_golden(const SimulatorOptions& opts)
+{
+    namespace fs = std::filesystem;
+    std::vector<fs::path> projects;
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(opts.golden_dir, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".json") {
+            projects.push_back(entry.path());
+        }
+    }
+    if (ec || projects.empty()) {
+        std::cerr << "No project JSON files found in: " << opts.golden_dir << std::endl;
+        return -1;
+    }
+    std::sort(projects.begin(), projects.end());
+
+    unsigned jobs = opts.jobs ? opts.jobs : std::max(1u, std::thread::hardware_concurrency());
+    int failures = 0;
+    for (const fs::path& project : projects) {
+        std::string name = project.stem().string();
+        std::string out_dir = fs::absolute(fs::path(opts.render_out) / name).string();
+        std::string ref_dir = fs::absolute(fs::path(opts.golden_ref) / name).string();
+        std::string script_path = out_dir + PATH_SEP "project.lua";
+        fs::create_directories(out_dir, ec);
+        if (opts.golden_update) {
+            fs::create_directories(ref_dir, ec);
+        }
+
+        // 编译工程
+        if (!push_golden_function("compile")) {
+            return -1;
+        }
+        lua_pushstring(g_L, project.string().c_str());
+        lua_pushstring(g_L, script_path.c_str());
+        if (lua_pcall(g_L, 2, 2, 0) != LUA_OK || !lua_toboolean(g_L, -2)) {
+            const char* error = lua_tostring(g_L, -1);
+            std::cerr << "[Golden] FAIL " << name << ": compile failed: " << (error ? error : "unknown error") << std::endl;
+            lua_settop(g_L, 0);
+            failures++;
+            continue;
+        }
+        lua_pop(g_L, 2);
+
+        // 多进程渲染
+        SimulatorOptions render_opts = opts;
+        render_opts.render_project = script_path.c_str();
+        render_opts.render_out = out_dir.c_str();
+        if (render_parallel(render_opts, jobs) != 0) {
+            std::cerr << "[Golden] FAIL " << name << ": render failed" << std::endl;
+            failures++;
+            continue;
+        }
+
+        // 与参考结果比较
+        if (!push_golden_function("compare")) {
+            return -1;
+        }
+        lua_createtable(g_L, 0, 7);
+        lua_pushstring(g_L, name.c_str());
+        lua_setfield(g_L, -2, "name");
+        lua_pushstring(g_L, out_dir.c_str());
+        lua_setfield(g_L, -2, "out_dir");
+        lua_pushstring(g_L, ref_dir.c_str());
+        lua_setfield(g_L, -2, "ref_dir");
+        lua_pushboolean(g_L, opts.golden_update);
+        lua_setfield(g_L, -2, "update");
+        if (opts.golden_tolerance >= 0) {
+            lua_pushinteger(g_L, opts.golden_tolerance);
+            lua_setfield(g_L, -2, "tolerance");
+        }
+        if (opts.golden_max_diff_pct >= 0) {
+            lua_pushnumber(g_L, opts.golden_max_diff_pct);
+            lua_setfield(g_L, -2, "max_diff_pct");
+        }
+        if (opts.golden_perf_pct >= 0) {
+            lua_pushnumber(g_L, opts.golden_perf_pct);
+            lua_setfield(g_L, -2, "perf_pct");
+        }
+        if (opts.golden_perf_floor_ms >= 0) {
+            lua_pushnumber(g_L, opts.golden_perf_floor_ms);
+            lua_setfield(g_L, -2, "perf_floor_ms");
+        }
+        if (lua_pcall(g_L, 1, 1, 0) != LUA_OK) {
+            std::cerr << "Lua error: " << lua_tostring(g_L, -1) << std::endl;
+            lua_pop(g_L, 1);
+            failures++;
+            continue;
+        }
+        failures += (int)lua_tointeger(g_L, -1);
+        lua_pop(g_L, 1);
+    }
+
+    if (opts.golden_update) {
+        std::cout << "Golden references updated: " << projects.size() << " projects" << std::endl;
+        return failures ? 1 : 0;
+    }
+    if (failures) {
+        std::cerr << "Golden test failed: " << failures << " failures in " << projects.size() << " projects" << std::endl;
+        return 1;
+    }
+    std::cout << "Golden test passed: " << projects.size() << " projects" << std::endl;
+    return 0;
+}
+
+/**
+ * @brief 运行绑定层微基准测试（调用 lua/sim/bench.lua）
+ * @return 成功且没有性能退化返回 0
+ */
+static int run_bench(const SimulatorOptions& opts)
+{
+    lua_getglobal(g_L, "require");
+    lua_pushstring(g_L, "sim.bench");
+    if (lua_pcall(g_L, 1, 1, 0) != LUA_OK) {
+        std::cerr << "Lua error: " << lua_tostring(g_L, -1) << std::endl;
+        lua_pop(g_L, 1);
+        return -1;
+    }
+    lua_getfield(g_L, -1, "run");
+    lua_createtable(g_L, 0, 5);
+    lua_pushstring(g_L, opts.bench_out);
+    lua_setfield(g_L, -2, "output");
+    if (opts.bench_baseline) {
+        lua_pushstring(g_L, opts.bench_baseline);
+        lua_setfield(g_L, -2, "baseline");
+    }
+    if (opts.bench_project) {
+        lua_pushstring(g_L, opts.bench_project);
+        lua_setfield(g_L, -2, "project");
+    }
+    if (opts.bench_filter) {
+        lua_pushstring(g_L, opts.bench_filter);
+        lua_setfield(g_L, -2, "filter");
+    }
+    if (opts.golden_perf_pct >= 0) {
+        lua_pushnumber(g_L, opts.golden_perf_pct);
+        lua_setfield(g_L, -2, "threshold_pct");
+    }
+    if (lua_pcall(g_L, 1, 2, 0) != LUA_OK) {
+        std::cerr << "Lua error: " << lua_tostring(g_L, -1) << std::endl;
+        lua_pop(g_L, 2);
+        return -1;
+    }
+    int exit_code = 0;
+    if (lua_isnil(g_L, -2)) {
+        const char* error = lua_tostring(g_L, -1);
+        std::cerr << "Benchmark failed: " << (error ? error : "unknown error") << std::endl;
+        exit_code = -1;
+    }
+    else if (lua_tointeger(g_L, -2) > 0) {
+        std::cerr << "Benchmark regressions: " << lua_tointeger(g_L, -2) << std::endl;
+        exit_code = 1;
+    }
+    lua_pop(g_L, 3);
+    return exit_code;
+}
+
+/**
+ * @brief 把 lua/sim/scale_bench.lua 中的字段压入栈顶
+ * @return 成功返回 true
+ */
+static bool push_scale_field(const char* name)
+{
+    lua_getglobal(g_L, "require");
+    lua_pushstring(g_L, "sim.scale_bench");
+    if (lua_pcall(g_L, 1, 1, 0) != LUA_OK) {
+        std::cerr << "Lua error: " << lua_tostring(g_L, -1) << std::endl;
+        lua_pop(g_L, 1);
+        return false;
+    }
+    lua_getfield(g_L, -1, name);
+    lua_remove(g_L, -2);
+    return true;
+}
+
+/**
+ * @brief 规模测试子进程：测量一个点并追加到 CSV
+ * @return 成功返回 0，测量出错（已写入 CSV）返回 2
+ */
+static int run_scale_point(const SimulatorOptions& opts)
+{
+    std::string point = opts.scale_point;
+    size_t colon = point.rfind(':');
+    if (colon == std::string::npos) {
+        std::cerr << "Invalid scale point: " << point << std::endl;
+        return -1;
+    }
+    std::filesystem::path work_dir = std::filesystem::path(opts.scale_csv).parent_path();
+
+    if (!push_scale_field("run_point")) {
+        return -1;
+    }
+    lua_createtable(g_L, 0, 5);
+    lua_pushstring(g_L, point.substr(0, colon).c_str());
+    lua_setfield(g_L, -2, "module");
+    lua_pushinteger(g_L, strtol(point.c_str() + colon + 1, nullptr, 10));
+    lua_setfield(g_L, -2, "count");
+    lua_pushstring(g_L, opts.scale_csv);
+    lua_setfield(g_L, -2, "csv");
+    lua_pushstring(g_L, work_dir.empty() ? "." : work_dir.string().c_str());
+    lua_setfield(g_L, -2, "work_dir");
+    if (opts.update_pct >= 0) {
+        lua_pushinteger(g_L, opts.update_pct);
+        lua_setfield(g_L, -2, "update_pct");
+    }
+    if (lua_pcall(g_L, 1, 2, 0) != LUA_OK) {
+        std::cerr << "Lua error: " << lua_tostring(g_L, -1) << std::endl;
+        lua_pop(g_L, 1);
+        return -1;
+    }
+    int exit_code = 0;
+    if (lua_isnil(g_L, -2)) {
+        const char* error = lua_tostring(g_L, -1);
+        std::cerr << "Scale point failed: " << (error ? error : "unknown error") << std::endl;
+        exit_code = -1;
+    }
+    else if (!lua_toboolean(g_L, -2)) {
+        exit_code = 2;
+    }
+    lua_pop(g_L, 2);
+    return exit_code;
+}
+
+/**
+ * @brief 规模测试：每种控件按数量从小到大逐点测量，每个点一个子进程，
+ *        子进程崩溃、出错或超过时间预算后该类型不再测试更大的数量
+ * @return 成功返回 0
+ */
+static int run_scale(const SimulatorOptions& opts)
+{
+    std::vector<long> sizes;
+    for (const char* p = opts.scale_sizes; *p; ) {
+        char* end = nullptr;
+        long size = strtol(p, &end, 10);
+        if (end == p || size <= 0) {
+            std::cerr << "Invalid scale sizes: " << opts.scale_sizes << std::endl;
+            return -1;
+        }
+        sizes.push_back(size);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    std::sort(sizes.begin(), sizes.end());
+
+    std::vector<std::string> modules;
+    if (opts.scale_types) {
+        std::string types = opts.scale_types;
+        size_t start = 0;
+        while (start <= types.size()) {
+            size_t comma = types.find(',', start);
+            std::string type = types.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+            if (!type.empty()) {
+                modules.push_back("widgets." + type);
+            }
+            if (comma == std::string::npos) break;
+            start = comma + 1;
+        }
+    }
+    else {
+        if (!push_scale_field("WIDGET_MODULES")) {
+            return -1;
+        }
+        lua_Integer n = luaL_len(g_L, -1);
+        for (lua_Integer i = 1; i <= n; i++) {
+            lua_rawgeti(g_L, -1, i);
+            modules.push_back(lua_tostring(g_L, -1));
+            lua_pop(g_L, 1);
+        }
+        lua_pop(g_L, 1);
+    }
+
+    // CSV 表头
+    if (!push_scale_field("CSV_HEADER")) {
+        return -1;
+    }
+    {
+        std::ofstream out(opts.scale_csv, std::ios::binary);
+        if (!out) {
+            std::cerr << "Failed to write " << opts.scale_csv << std::endl;
+            lua_pop(g_L, 1);
+            return -1;
+        }
+        out << lua_tostring(g_L, -1) << "\n";
+    }
+    lua_pop(g_L, 1);
+
+    std::string exe_path = get_exe_path();
+    std::string size = std::to_string(opts.width) + "x" + std::to_string(opts.height);
+    for (const std::string& module : modules) {
+        for (long count : sizes) {
+            std::vector<std::string> args = {
+                exe_path, "--scale", opts.scale_csv, "--scale-point", module + ":" + std::to_string(count),
+                "--size", size,
+            };
+            if (opts.update_pct >= 0) {
+                args.push_back("--update-pct");
+                args.push_back(std::to_string(opts.update_pct));
+            }
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ChildProcess child;
+            int code = spawn_process(args, child) ? wait_process(child) : -1;
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (code != 0 && code != 2) {
+                // 子进程崩溃（例如内存耗尽），由父进程记录
+                if (push_scale_field("write_failure")) {
+                    lua_pushstring(g_L, opts.scale_csv);
+                    lua_pushstring(g_L, module.c_str());
+                    lua_pushinteger(g_L, count);
+                    lua_pushstring(g_L, ("process exited with code " + std::to_string(code)).c_str());
+                    lua_pcall(g_L, 4, 0, 0);
+                }
+                std::cerr << "[Scale] " << module << " " << count << " widgets: process exited with code " << code << std::endl;
+            }
+            if (code != 0) {
+                break;
+            }
+            if (seconds > opts.scale_budget_s) {
+                std::cout << "[Scale] " << module << " " << count << " widgets took " << seconds
+                          << " s, skipping larger sizes" << std::endl;
+                break;
+            }
+        }
+    }
+    std::cout << "Scalability results written to: " << opts.scale_csv << std::endl;
+    return 0;
+}
+
+/**
+ * @brief 运行长时间运行测试（调用 lua/sim/soak.lua）
+ * @return 成功且没有资源持续增长返回 0
+ */
+static int run_soak(const SimulatorOptions& opts)
+{
+    lua_getglobal(g_L, "require");
+    lua_pushstring(g_L, "sim.soak");
+    if (lua_pcall(g_L, 1, 1, 0) != LUA_OK) {
+        std::cerr << "Lua error: " << lua_tostring(g_L, -1) << std::endl;
+        lua_pop(g_L, 1);
+        return -1;
+    }
+    lua_getfield(g_L, -1, "run");
+    lua_createtable(g_L, 0, 4);
+    lua_pushstring(g_L, opts.soak_csv);
+    lua_setfield(g_L, -2, "output");
+    if (opts.soak_cycles > 0) {
+        lua_pushinteger(g_L, opts.soak_cycles);
+        lua_setfield(g_L, -2, "cycles");
+    }
+    if (opts.soak_sample_every > 0) {
+        lua_pushinteger(g_L, opts.soak_sample_every);
+        lua_setfield(g_L, -2, "sample_every");
+    }
+    if (opts.soak_project) {
+        lua_pushstring(g_L, opts.soak_project);
+        lua_setfield(g_L, -2, "project");
+    }
+    if (lua_pcall(g_L, 1, 2, 0) != LUA_OK) {
+        std::cerr << "Lua error: " << lua_tostring(g_L, -1) << std::endl;
+        lua_pop(g_L, 2);
+        return -1;
+    }
+    int exit_code = 0;
+    if (lua_isnil(g_L, -2)) {
+        const char* error = lua_tostring(g_L, -1);
+        std::cerr << "Soak test failed: " << (error ? error : "unknown error") << std::endl;
+        exit_code = -1;
+    }
+    else if (lua_tointeger(g_L, -2) > 0) {
+        std::cerr << "Soak test: " << lua_tointeger(g_L, -2) << " resources keep growing" << std::endl;
+        exit_code = 1;
+    }
+    else {
+        std::cout << "Soak test passed" << std::endl;
+    }
+    lua_pop(g_L, 3);
+    return exit_code;
+}
+
+/**
+ * @brief 主函数
+ */
+int main(int argc, char* argv[])
+{
+#ifdef _WIN32
+    // 将控制台设置为 UTF-8 以支持中文输出
+    SetConsoleCP(CP_UTF8);
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    SimulatorOptions opts;
+    if (!parse_options(argc, argv, opts)) {
+        return -1;
+    }
+
+    std::cout << "VduSimulator - LVGL Lua Configuration Editor" << std::endl;
+    std::cout << (opts.headless ? "Headless size: " : "Window size: ") << opts.width << "x" << opts.height << std::endl;
+
+    // 获取可执行文件目录（在程序启动时获取一次）
+    g_exe_directory = get_exe_directory();
+    if (g_exe_directory.empty()) {
+        std::cerr << "Failed to get executable directory" << std::endl;
+        return -1;
+    }
+    std::cout << "Application directory: " << g_exe_directory << std::endl;
+
+    // 批量渲染：父进程只负责分发和汇总，单进程时直接在本进程渲染
+    if (opts.render_project && opts.shards == 0) {
+        std::error_code ec;
+        std::filesystem::create_directories(opts.render_out, ec);
+        unsigned jobs = opts.jobs ? opts.jobs : std::max(1u, std::thread::hardware_concurrency());
+        if (jobs > 1) {
+            return render_parallel(opts, jobs);
+        }
+        opts.shard = 0;
+        opts.shards = 1;
+        opts.render_merge = true;
+    }
+
+    // 确定脚本路径
+    const char* script_path = opts.script_path;
+    if (opts.render_project) {
+        std::cout << "Rendering project: " << opts.render_project << std::endl;
+    }
+    else if (opts.golden_dir) {
+        std::cout << "Golden test: " << opts.golden_dir << std::endl;
+    }
+    else if (opts.bench_out) {
+        std::cout << "Running benchmarks: " << opts.bench_out << std::endl;
+    }
+    else if (opts.scale_csv) {
+        std::cout << "Scalability test: " << (opts.scale_point ? opts.scale_point : opts.scale_csv) << std::endl;
+    }
+    else if (opts.soak_csv) {
+        std::cout << "Soak test: " << opts.soak_csv << std::endl;
+    }
+    else if (script_path != DEFAULT_SCRIPT_PATH) {
+        std::cout << "Using command line script: " << script_path << std::endl;
+    }
+    else {
+        std::cout << "Using default script: " << script_path << std::endl;
+    }
+
+    // 初始化 LVGL
+    lv_init();
+
+    // 创建显示
+#ifdef _WIN32
+    lv_display_t* display = opts.headless ? create_headless_display(opts) : create_window_display(opts);
+#else
+    lv_display_t* display = create_headless_display(opts);
+#endif
+    if (!display) {
         return -1;
     }
 
+    // 虚拟时钟（在显示驱动设置 tick 之后接管）
+    if (opts.virtual_clock) {
+        lvgl_clock_set_virtual(opts.start_time * 1000);
+        if (opts.timestep_ms) {
+            std::cout << "Virtual clock: fixed timestep " << opts.timestep_ms << " ms" << std::endl;
+        }
+        else {
+            std::cout << "Virtual clock: free running" << std::endl;
+        }
+    }
+
     // 运行几个定时器周期，让 LVGL 完全初始化显示
     for (int i = 0; i < 10; i++) {
         lv_timer_handler();
-        Sleep(10);
+        lv_delay_ms(10);
     }
 
     std::cout << "LVGL display initialized successfully" << std::endl;
@@ -388,6 +1407,49 @@ int main(int argc, char* argv[])
         return -1;
     }
 
+    // 批量渲染模式：渲染完成后直接退出
+    if (opts.render_project) {
+        int exit_code = render_pages(opts);
+        if (opts.render_merge && merge_render_timing(opts, 1) != 0) {
+            exit_code = -1;
+        }
+        cleanup_lua();
+        cleanup_chinese_font();
+        return exit_code;
+    }
+
+    // 图像回归测试模式：编译、渲染、比较后退出
+    if (opts.golden_dir) {
+        int exit_code = run_golden(opts);
+        cleanup_lua();
+        cleanup_chinese_font();
+        return exit_code;
+    }
+
+    // 微基准测试模式：测量后退出
+    if (opts.bench_out) {
+        int exit_code = run_bench(opts);
+        cleanup_lua();
+        cleanup_chinese_font();
+        return exit_code;
+    }
+
+    // 规模测试模式：父进程逐点启动子进程，子进程测量一个点
+    if (opts.scale_csv) {
+        int exit_code = opts.scale_point ? run_scale_point(opts) : run_scale(opts);
+        cleanup_lua();
+        cleanup_chinese_font();
+        return exit_code;
+    }
+
+    // 长时间运行测试模式：循环操作并检测资源增长后退出
+    if (opts.soak_csv) {
+        int exit_code = run_soak(opts);
+        cleanup_lua();
+        cleanup_chinese_font();
+        return exit_code;
+    }
+
     // 加载并执行 Lua 脚本
     if (!load_lua_script(script_path)) {
         std::cerr << "Failed to load Lua script, showing default demo" << std::endl;
@@ -405,22 +1467,87 @@ int main(int argc, char* argv[])
         lv_obj_align(label, LV_ALIGN_CENTER, 0, 0);
     }
 
+    // 输入录制 / 回放（界面建立之后开始，时间戳从此刻算起）
+    if (opts.record_path) {
+        if (lvgl_input_record_start(opts.record_path)) {
+            std::cout << "Recording input to: " << opts.record_path << std::endl;
+        }
+        else {
+            std::cerr << "Failed to record input to: " << opts.record_path << std::endl;
+        }
+    }
+    if (opts.replay_path) {
+        if (lvgl_input_replay_start(opts.replay_path)) {
+            std::cout << "Replaying input from: " << opts.replay_path << std::endl;
+        }
+        else {
+            std::cerr << "Failed to load input recording: " << opts.replay_path << std::endl;
+            cleanup_lua();
+            cleanup_chinese_font();
+            return -1;
+        }
+    }
+
     std::cout << "Starting main loop..." << std::endl;
 
-    // 主循环
-    while (1) {
+    // 主循环（指定 --run-ms 时到时退出）
+    uint32_t start_tick = lv_tick_get();
+    uint64_t start_virtual_ms = lvgl_clock_elapsed_ms();
+    std::chrono::steady_clock::time_point start_real = std::chrono::steady_clock::now();
+    while (opts.run_ms == 0 || lv_tick_elaps(start_tick) < opts.run_ms) {
         uint32_t time_till_next = lv_timer_handler();
         // 处理 LV_NO_TIMER_READY 的情况，避免等待过长时间
         // LV_NO_TIMER_READY = 0xFFFFFFFF，表示没有定时器准备好
         if (time_till_next == LV_NO_TIMER_READY) {
             time_till_next = LV_DEF_REFR_PERIOD;  // 使用默认刷新周期（通常是 33ms）
         }
-        lv_delay_ms(time_till_next);
+        if (opts.timestep_ms) {
+            lvgl_clock_advance(opts.timestep_ms);
+        }
+        else if (opts.virtual_clock) {
+            // 不等待，直接跳到下一个定时器的到期时间
+            lvgl_clock_advance(time_till_next > 0 ? time_till_next : 1);
+        }
+        else {
+            lv_delay_ms(time_till_next);
+        }
+        if (opts.replay_path && opts.run_ms == 0 && lvgl_input_replay_is_done()) {
+            break;
+        }
     }
 
-    // 清理资源（在此示例中永远不会执行到这里）
+    if (opts.record_path) {
+        std::cout << "Recorded " << lvgl_input_record_stop() << " input events" << std::endl;
+    }
+    if (opts.replay_path) {
+        lvgl_input_replay_print_stats();
+    }
+
+    if (opts.virtual_clock) {
+        double real_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_real).count();
+        double virtual_s = (double)(lvgl_clock_elapsed_ms() - start_virtual_ms) / 1000.0;
+        std::cout << "Simulated " << virtual_s << " s in " << real_s << " s";
+        if (real_s > 0) {
+            std::cout << " (" << virtual_s / real_s << "x)";
+        }
+        std::cout << std::endl;
+    }
+
+    // 保存最后一帧
+    int exit_code = 0;
+    if (opts.screenshot_path) {
+        if (lvgl_headless_save_frame(display, opts.screenshot_path)) {
+            std::cout << "Screenshot saved: " << opts.screenshot_path << std::endl;
+        }
+        else {
+            std::cerr << "Failed to save screenshot: " << opts.screenshot_path << std::endl;
+            exit_code = -1;
+        }
+    }
+
+    // 清理资源
     cleanup_lua();
     cleanup_chinese_font();
 
-    return 0;
+    return exit_code;
 }